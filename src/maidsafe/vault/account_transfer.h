@@ -20,6 +20,7 @@
 #define MAIDSAFE_VAULT_ACCOUNT_TRANSFER_H_
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <deque>
 #include <map>
@@ -36,6 +37,8 @@
 
 #include "maidsafe/routing/parameters.h"
 
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/pending_request_limits.h"
 #include "maidsafe/vault/unresolved_account_transfer_action.h"
 
 namespace maidsafe {
@@ -75,8 +78,10 @@ class AccountTransfer {
   struct PendingRequest {
    public:
     PendingRequest(const UnresolvedAccountTransferAction& request_in,
-                   const routing::GroupSource& source_in)
-        : request(request_in), group_id(source_in.group_id) {
+                   const routing::GroupSource& source_in,
+                   std::chrono::steady_clock::time_point arrival_in)
+        : request(request_in), group_id(source_in.group_id), arrival(arrival_in),
+          reached_quorum(false) {
       request.Merge(request_in, source_in.sender_id);
     }
 
@@ -98,6 +103,9 @@ class AccountTransfer {
     routing::GroupId GetGroupId() const {
       return group_id;
     }
+    nfs::MessageId GetMessageId() const {
+      return request.id;
+    }
     UnresolvedAccountTransferAction GetRequest() const {
       return request;
     }
@@ -108,10 +116,21 @@ class AccountTransfer {
     bool IsResolved() {
       return request.IsResolved();
     }
+    std::chrono::steady_clock::time_point GetArrival() const {
+      return arrival;
+    }
+    bool ReachedQuorum() const {
+      return reached_quorum;
+    }
+    void SetReachedQuorum() {
+      reached_quorum = true;
+    }
 
    private:
     UnresolvedAccountTransferAction request;
     routing::GroupId group_id;
+    std::chrono::steady_clock::time_point arrival;
+    bool reached_quorum;
 //     std::set<routing::SingleId> senders;
   };
 
@@ -121,7 +140,9 @@ class AccountTransfer {
       const UnresolvedAccountTransferAction& request,
       const routing::GroupSource& source,
       AddRequestChecker checker);
+  // True if any request from the group has been handled within the request ttl
   bool CheckHandled(const routing::GroupId& source);
+  detail::PendingRequestStatistics GetStatistics() const;
 
  private:
   AccountTransfer(const AccountTransfer&);
@@ -129,13 +150,23 @@ class AccountTransfer {
   AccountTransfer(AccountTransfer&&);
   AccountTransfer& operator=(AccountTransfer&&);
 
+  bool IsHandled(const routing::GroupId& source_group_id, const nfs::MessageId& message_id) const;
   bool RequestExists(const UnresolvedAccountTransferAction& request,
                      const routing::GroupSource& source);
   void CleanUpHandledRequests();
+  bool IsHandledRecently(const boost::posix_time::ptime& handled_time,
+                         const boost::posix_time::ptime& now) const;
+  void ExpireAndEvict(std::chrono::steady_clock::time_point now);
+  void PopOldest(bool expired);
 
+  // In arrival order
   std::deque<PendingRequest> pending_requests_;
-  std::map<routing::GroupId, boost::posix_time::ptime> handled_requests_;
-  const size_t kMaxPendingRequestsCount_, kMaxHandledRequestsCount_;
+  // An account may be sent in several chunks, each with its own message id
+  std::map<routing::GroupId, std::map<nfs::MessageId, boost::posix_time::ptime>>
+      handled_requests_;
+  detail::PendingRequestLimits limits_;
+  detail::PendingRequestStatistics statistics_;
+  const size_t kMaxHandledRequestsCount_;
   mutable std::mutex mutex_;
 };
 
@@ -145,7 +176,10 @@ template <typename UnresolvedAccountTransferAction>
 AccountTransfer<UnresolvedAccountTransferAction>::AccountTransfer()
     : pending_requests_(),
       handled_requests_(),
-      kMaxPendingRequestsCount_(100),
+      limits_(detail::Parameters::account_transfer_request_ttl,
+              detail::Parameters::account_transfer_min_capacity,
+              detail::Parameters::account_transfer_max_capacity),
+      statistics_(),
       kMaxHandledRequestsCount_(100),
       mutex_() {}
 
@@ -159,26 +193,30 @@ std::unique_ptr<UnresolvedAccountTransferAction>
                 << HexSubstr(source.group_id.data.string()) << " sent from "
                 << HexSubstr(source.sender_id->string());
   std::unique_ptr<UnresolvedAccountTransferAction> resolved_action;
-  if (CheckHandled(source.group_id)) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto now(std::chrono::steady_clock::now());
+  limits_.RecordArrival(now);
+  ExpireAndEvict(now);
+  if (IsHandled(source.group_id, request.id)) {
     LOG(kInfo) << "AccountTransfer::AddUnresolvedAction request has been handled";
     return resolved_action;
   }
-  std::lock_guard<std::mutex> lock(mutex_);
   if (RequestExists(request, source)) {
     LOG(kVerbose) << "AccountTransfer::AddUnresolvedAction request already existed";
     auto itr(pending_requests_.begin());
     while (itr != pending_requests_.end()) {
-      if (itr->GetGroupId() == source.group_id) {
+      if (itr->GetGroupId() == source.group_id && itr->GetMessageId() == request.id) {
         LOG(kVerbose) << "AccountTransfer::AddUnresolvedAction merge request before having "
                       << itr->GetSenders().size() << " senders";
         itr->MergePendingRequest(request, source);
         LOG(kVerbose) << "AccountTransfer::AddUnresolvedAction merge request after having "
                       << itr->GetSenders().size() << " senders";
         if (checker(itr->GetSenders()) == AddResult::kSuccess) {
+          itr->SetReachedQuorum();
           resolved_action.reset(new UnresolvedAccountTransferAction(
               itr->GetResolved(routing::Parameters::group_size / 2)));
           if (itr->IsResolved()) {
-            handled_requests_[itr->GetGroupId()] =
+            handled_requests_[itr->GetGroupId()][itr->GetMessageId()] =
                 boost::posix_time::microsec_clock::universal_time();
             LOG(kVerbose) << "AccountTransfer::AddUnresolvedAction put "
                           << DebugId(itr->GetGroupId()) << " into handled list";
@@ -192,11 +230,12 @@ std::unique_ptr<UnresolvedAccountTransferAction>
       ++itr;
     }
   } else {
-    pending_requests_.push_back(PendingRequest(request, source));
+    if (pending_requests_.size() >= limits_.capacity())
+      PopOldest(false);
+    pending_requests_.push_back(PendingRequest(request, source, now));
+    ++statistics_.added;
     LOG(kVerbose) << "AccountTransfer::AddUnresolvedAction has " << pending_requests_.size()
-                  << " pending requests, allowing " << kMaxPendingRequestsCount_ << " requests";
-    if (pending_requests_.size() > kMaxPendingRequestsCount_)
-      pending_requests_.pop_front();
+                  << " pending requests, allowing " << limits_.capacity() << " requests";
   }
   return std::move(resolved_action);
 }
@@ -207,23 +246,49 @@ bool AccountTransfer<UnresolvedAccountTransferAction>::CheckHandled(
   std::lock_guard<std::mutex> lock(mutex_);
   LOG(kVerbose) << "AccountTransfer::CheckHandled handled_requests_.size() "
                 << handled_requests_.size();
-  auto handled_entry(handled_requests_.find(source_group_id));
-  if (handled_entry == handled_requests_.end())
+  auto handled_group(handled_requests_.find(source_group_id));
+  if (handled_group == handled_requests_.end())
     return false;
   auto cur_time(boost::posix_time::microsec_clock::universal_time());
-  if ((cur_time - handled_entry->second).total_seconds() > 60) {
-    handled_requests_.erase(handled_entry);
+  auto& handled_ids(handled_group->second);
+  for (auto itr(handled_ids.begin()); itr != handled_ids.end();) {
+    if (!IsHandledRecently(itr->second, cur_time))
+      itr = handled_ids.erase(itr);
+    else
+      ++itr;
+  }
+  if (handled_ids.empty()) {
+    handled_requests_.erase(handled_group);
     return false;
   }
   return true;
 }
 
+template <typename UnresolvedAccountTransferAction>
+bool AccountTransfer<UnresolvedAccountTransferAction>::IsHandled(
+    const routing::GroupId& source_group_id, const nfs::MessageId& message_id) const {
+  auto handled_group(handled_requests_.find(source_group_id));
+  if (handled_group == handled_requests_.end())
+    return false;
+  auto handled_entry(handled_group->second.find(message_id));
+  return handled_entry != handled_group->second.end() &&
+         IsHandledRecently(handled_entry->second,
+                           boost::posix_time::microsec_clock::universal_time());
+}
+
+template <typename UnresolvedAccountTransferAction>
+bool AccountTransfer<UnresolvedAccountTransferAction>::IsHandledRecently(
+    const boost::posix_time::ptime& handled_time, const boost::posix_time::ptime& now) const {
+  return (now - handled_time).total_seconds() <= limits_.ttl().count();
+}
+
 template <typename UnresolvedAccountTransferAction>
 bool AccountTransfer<UnresolvedAccountTransferAction>::RequestExists(
     const UnresolvedAccountTransferAction& request, const routing::GroupSource& source) {
   auto request_message_id(request.id);
   for (auto& pending_request : pending_requests_)
-    if (request_message_id == pending_request.GetRequest().id) {
+    if (request_message_id == pending_request.GetMessageId() &&
+        source.group_id == pending_request.GetGroupId()) {
       LOG(kWarning) << "AccountTransfer::RequestExists,  reguest with message id "
                     << request_message_id.data
                     << " with group_id " << HexSubstr(source.group_id->string())
@@ -242,13 +307,57 @@ void AccountTransfer<UnresolvedAccountTransferAction>::CleanUpHandledRequests()
   auto itr(handled_requests_.begin());
   auto cur_time(boost::posix_time::microsec_clock::universal_time());
   while (itr != handled_requests_.end()) {
-    if ((cur_time - itr->second).total_seconds() > 60)
+    auto& handled_ids(itr->second);
+    for (auto id_itr(handled_ids.begin()); id_itr != handled_ids.end();) {
+      if (!IsHandledRecently(id_itr->second, cur_time))
+        id_itr = handled_ids.erase(id_itr);
+      else
+        ++id_itr;
+    }
+    if (handled_ids.empty())
       itr = handled_requests_.erase(itr);
     else
       ++itr;
   }
 }
 
+template <typename UnresolvedAccountTransferAction>
+detail::PendingRequestStatistics
+    AccountTransfer<UnresolvedAccountTransferAction>::GetStatistics() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto statistics(statistics_);
+  statistics.capacity = limits_.capacity();
+  statistics.pending_count = pending_requests_.size();
+  return statistics;
+}
+
+template <typename UnresolvedAccountTransferAction>
+void AccountTransfer<UnresolvedAccountTransferAction>::ExpireAndEvict(
+    std::chrono::steady_clock::time_point now) {
+  while (!pending_requests_.empty() &&
+         limits_.IsExpired(pending_requests_.front().GetArrival(), now)) {
+    PopOldest(true);
+  }
+  while (pending_requests_.size() > limits_.capacity())
+    PopOldest(false);
+}
+
+template <typename UnresolvedAccountTransferAction>
+void AccountTransfer<UnresolvedAccountTransferAction>::PopOldest(bool expired) {
+  if (!pending_requests_.front().ReachedQuorum()) {
+    if (expired) {
+      ++statistics_.expired_before_quorum;
+    } else {
+      ++statistics_.evicted_before_quorum;
+      LOG(kWarning) << "AccountTransfer evicted request with message id "
+                    << pending_requests_.front().GetMessageId().data << " before quorum; "
+                    << statistics_.evicted_before_quorum << " of " << statistics_.added
+                    << " requests evicted so far";
+    }
+  }
+  pending_requests_.pop_front();
+}
+
 }  // namespace vault
 
 }  // namespace maidsafe
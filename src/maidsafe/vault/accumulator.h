@@ -20,16 +20,29 @@
 #define MAIDSAFE_VAULT_ACCUMULATOR_H_
 
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "boost/functional/hash.hpp"
+
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/data_types/data_name_variant.h"
 #include "maidsafe/nfs/utils.h"
 #include "maidsafe/nfs/message_types.h"
 #include "maidsafe/nfs/types.h"
 #include "maidsafe/nfs/vault/messages.h"
 #include "maidsafe/vault/handled_request.pb.h"
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/pending_request_limits.h"
 #include "maidsafe/vault/types.h"
 
 namespace maidsafe {
@@ -47,6 +60,14 @@ class MessageIdRequestVisitor : public boost::static_visitor<nfs::MessageId> {
   }
 };
 
+class SerialiseRequestVisitor : public boost::static_visitor<std::string> {
+ public:
+  template <typename T>
+  std::string operator()(const T& message) const {
+    return message.Serialise();
+  }
+};
+
 /*
 class ContentEraseVisitor : public boost::static_visitor<> {
  public:
@@ -72,7 +93,25 @@ class Accumulator {
     kFailure,
     kHandled
   };
-  typedef std::function<AddResult(const std::vector<T>&)> AddCheckerFunctor;
+  // Identifies a request's full serialised content, so that copies of a request can be compared
+  // without comparing their (possibly large) contents.
+  typedef crypto::SHA512Hash Digest;
+  // The requests passed to an AddCheckerFunctor: the shared instance held for each pending copy,
+  // along with its digest.  Checkers which need the requests' content can take a
+  // const std::vector<T>&, which is only then copied from the instances.
+  struct Requests {
+    size_t size() const { return instances.size(); }
+    operator std::vector<T>() const {
+      std::vector<T> requests;
+      requests.reserve(instances.size());
+      for (const auto& instance : instances)
+        requests.push_back(*instance);
+      return requests;
+    }
+    std::vector<std::shared_ptr<const T>> instances;
+    std::vector<Digest> digests;
+  };
+  typedef std::function<AddResult(const Requests&)> AddCheckerFunctor;
   class AddRequestChecker {
    public:
     explicit AddRequestChecker(size_t required_requests)
@@ -81,20 +120,35 @@ class Accumulator {
              "Invalid number of requests");
     }
 
-    AddResult operator()(const std::vector<T>& requests);
+    AddResult operator()(const Requests& requests);
 
    private:
     size_t required_requests_;
   };
 
+  // Copies of a request with the same digest, as normally arrive from each member of a group,
+  // share a single instance of the request, so a chunk is held once however many copies arrive.
+  // The instance's serialised size is counted in 'bytes' of the oldest copy sharing it, and 0 for
+  // the others.
   struct PendingRequest {
-    PendingRequest(const T& request_in, const routing::GroupSource& source_in)
-        : request(request_in), source(source_in) {}
-    T request;
+    PendingRequest(std::shared_ptr<const T> request_in, const routing::GroupSource& source_in,
+                   const Digest& digest_in, std::chrono::steady_clock::time_point arrival_in,
+                   uint64_t bytes_in)
+        : request(std::move(request_in)), source(source_in), digest(digest_in),
+          arrival(arrival_in), bytes(bytes_in) {}
+    std::shared_ptr<const T> request;
     routing::GroupSource source;
+    Digest digest;
+    std::chrono::steady_clock::time_point arrival;
+    uint64_t bytes;
   };
 
+  // Limits are taken from the Parameters accumulator_request_ttl, accumulator_min_capacity,
+  // accumulator_max_capacity and accumulator_max_bytes.
   Accumulator();
+  Accumulator(std::chrono::seconds request_ttl, size_t min_capacity, size_t max_capacity);
+  Accumulator(std::chrono::seconds request_ttl, size_t min_capacity, size_t max_capacity,
+              uint64_t max_bytes);
 
   AddResult AddPendingRequest(const T& request, const routing::GroupSource& source,
                               AddCheckerFunctor checker);
@@ -104,6 +158,7 @@ class Accumulator {
   bool CheckHandled(const T& request);
   //  void SetHandled(const T& request, const routing::GroupSource& source);
   std::vector<T> Get(const T& request, const routing::GroupSource& source);
+  detail::PendingRequestStatistics GetStatistics() const;
 
  private:
   Accumulator(const Accumulator&);
@@ -111,19 +166,72 @@ class Accumulator {
   Accumulator(Accumulator&&);
   Accumulator& operator=(Accumulator&&);
 
-  bool RequestExists(const T& request, const routing::GroupSource& source);
+  // Requests sharing a message id and variant index, i.e. the copies of one request from the
+  // members of a group, differing only by sender (and content if the senders disagree).
+  typedef std::pair<nfs::MessageId::value_type, int> RequestKey;
+  typedef boost::hash<RequestKey> RequestKeyHash;
+
+  static RequestKey MakeRequestKey(const T& request);
+  bool RequestExists(const routing::GroupSource& source, const RequestKey& key,
+                     const Digest& digest) const;
+  std::shared_ptr<const T> FindSharedRequest(const RequestKey& key, const Digest& digest) const;
+  Requests GetRequests(const RequestKey& key, const routing::GroupSource& source) const;
+  const PendingRequest& AtSequence(uint64_t sequence) const {
+    return pending_requests_[static_cast<size_t>(sequence - front_sequence_)];
+  }
+  void ExpireAndEvict(std::chrono::steady_clock::time_point now);
+  void PopOldest(bool expired);
+
+  // The requests with a given key, by sequence number, oldest first.  Once a quorum of them has
+  // been reached, their later expiry or eviction isn't counted as a drop.
+  struct SameKeyRequests {
+    SameKeyRequests() : sequences(), reached_quorum(false) {}
+    std::vector<uint64_t> sequences;
+    bool reached_quorum;
+  };
 
+  // Pending requests in arrival order.  The request at the front has sequence number
+  // front_sequence_, and the numbers rise by one per request.
   std::deque<PendingRequest> pending_requests_;
-  std::deque<T> handled_requests_;
-  const size_t kMaxPendingRequestsCount_, kMaxHandledRequestsCount_;
+  uint64_t front_sequence_;
+  // Sum of the pending requests' 'bytes', kept within kMaxBytes_ unless a single request exceeds it
+  uint64_t pending_bytes_;
+  std::unordered_map<RequestKey, SameKeyRequests, RequestKeyHash> pending_index_;
+  std::unordered_set<RequestKey, RequestKeyHash> handled_requests_;
+  detail::PendingRequestLimits limits_;
+  // Guards statistics_ alone, so that GetStatistics may be called from any thread while the
+  // Accumulator is in use
+  mutable std::mutex statistics_mutex_;
+  detail::PendingRequestStatistics statistics_;
+  const size_t kMaxHandledRequestsCount_;
+  const uint64_t kMaxBytes_;
 };
 
 template <typename T>
 Accumulator<T>::Accumulator()
+    : Accumulator(detail::Parameters::accumulator_request_ttl,
+                  detail::Parameters::accumulator_min_capacity,
+                  detail::Parameters::accumulator_max_capacity) {}
+
+template <typename T>
+Accumulator<T>::Accumulator(std::chrono::seconds request_ttl, size_t min_capacity,
+                            size_t max_capacity)
+    : Accumulator(request_ttl, min_capacity, max_capacity,
+                  detail::Parameters::accumulator_max_bytes) {}
+
+template <typename T>
+Accumulator<T>::Accumulator(std::chrono::seconds request_ttl, size_t min_capacity,
+                            size_t max_capacity, uint64_t max_bytes)
     : pending_requests_(),
+      front_sequence_(0),
+      pending_bytes_(0),
+      pending_index_(),
       handled_requests_(),
-      kMaxPendingRequestsCount_(300),
-      kMaxHandledRequestsCount_(1000) {}
+      limits_(request_ttl, min_capacity, max_capacity),
+      statistics_mutex_(),
+      statistics_(),
+      kMaxHandledRequestsCount_(1000),
+      kMaxBytes_(max_bytes) {}
 
 template <typename T>
 typename Accumulator<T>::AddResult Accumulator<T>::AddPendingRequest(
@@ -136,16 +244,46 @@ typename Accumulator<T>::AddResult Accumulator<T>::AddPendingRequest(
     return Accumulator<T>::AddResult::kHandled;
   }
 
-  if (!RequestExists(request, source)) {
-    pending_requests_.push_back(PendingRequest(request, source));
+  auto now(std::chrono::steady_clock::now());
+  limits_.RecordArrival(now);
+  ExpireAndEvict(now);
+  auto key(MakeRequestKey(request));
+  auto serialised_request(boost::apply_visitor(detail::SerialiseRequestVisitor(), request));
+  auto digest(crypto::Hash<crypto::SHA512>(serialised_request));
+  if (!RequestExists(source, key, digest)) {
+    if (pending_requests_.size() >= limits_.capacity())
+      PopOldest(false);
+    auto shared_request(FindSharedRequest(key, digest));
+    uint64_t bytes(0);
+    if (!shared_request) {
+      shared_request = std::make_shared<const T>(request);
+      bytes = serialised_request.size();
+      while (!pending_requests_.empty() && pending_bytes_ + bytes > kMaxBytes_)
+        PopOldest(false);
+      pending_bytes_ += bytes;
+    }
+    pending_requests_.push_back(
+        PendingRequest(std::move(shared_request), source, digest, now, bytes));
+    pending_index_[key].sequences.push_back(front_sequence_ + pending_requests_.size() - 1);
+    std::lock_guard<std::mutex> lock(statistics_mutex_);
+    ++statistics_.added;
+    statistics_.pending_count = pending_requests_.size();
+    statistics_.capacity = limits_.capacity();
     LOG(kVerbose) << "Accumulator::AddPendingRequest has " << pending_requests_.size()
-                  << " pending requests, allowing " << kMaxPendingRequestsCount_ << " requests";
-    if (pending_requests_.size() > kMaxPendingRequestsCount_)
-      pending_requests_.pop_front();
+                  << " pending requests, allowing " << limits_.capacity() << " requests";
   } else {
     LOG(kInfo) << "Accumulator::AddPendingRequest request already existed";
   }
-  return checker(Get(request, source));
+  auto result(checker(GetRequests(key, source)));
+  if (result == AddResult::kSuccess) {
+    auto itr(pending_index_.find(key));
+    if (itr != std::end(pending_index_) && !itr->second.reached_quorum) {
+      itr->second.reached_quorum = true;
+      std::lock_guard<std::mutex> lock(statistics_mutex_);
+      statistics_.time_to_quorum.Record(now - AtSequence(itr->second.sequences.front()).arrival);
+    }
+  }
+  return result;
 }
 
 template <typename T>
@@ -157,16 +295,7 @@ typename Accumulator<T>::AddResult Accumulator<T>::AddPendingRequest(
 
 template <typename T>
 bool Accumulator<T>::CheckHandled(const T& request) {
-  auto request_message_id(boost::apply_visitor(detail::MessageIdRequestVisitor(), request));
-  nfs::MessageId message_id;
-  for (auto handled_request : handled_requests_) {
-    if (handled_request.which() == request.which()) {
-      message_id = boost::apply_visitor(detail::MessageIdRequestVisitor(), handled_request);
-      if (message_id == request_message_id)
-        return true;
-    }
-  }
-  return false;
+  return handled_requests_.count(MakeRequestKey(request)) != 0;
 }
 
 // template<typename T>
@@ -194,46 +323,127 @@ bool Accumulator<T>::CheckHandled(const T& request) {
 
 template <typename T>
 std::vector<T> Accumulator<T>::Get(const T& request, const routing::GroupSource& source) {
-  std::vector<T> requests;
-  nfs::MessageId message_id;
-  auto request_message_id(boost::apply_visitor(detail::MessageIdRequestVisitor(), request));
-  for (auto pending_request : pending_requests_) {
-    if (pending_request.request.which() == request.which()) {
-      message_id = boost::apply_visitor(detail::MessageIdRequestVisitor(), pending_request.request);
-      if (((message_id == request_message_id)) &&
-          (source.group_id == pending_request.source.group_id))
-        requests.push_back(pending_request.request);
+  return GetRequests(MakeRequestKey(request), source);
+}
+
+template <typename T>
+detail::PendingRequestStatistics Accumulator<T>::GetStatistics() const {
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+  return statistics_;
+}
+
+template <typename T>
+typename Accumulator<T>::Requests Accumulator<T>::GetRequests(
+    const RequestKey& key, const routing::GroupSource& source) const {
+  Requests requests;
+  auto itr(pending_index_.find(key));
+  if (itr != std::end(pending_index_)) {
+    for (auto sequence : itr->second.sequences) {
+      const auto& pending_request(AtSequence(sequence));
+      if (source.group_id == pending_request.source.group_id) {
+        requests.instances.push_back(pending_request.request);
+        requests.digests.push_back(pending_request.digest);
+      }
     }
   }
   LOG(kVerbose) << requests.size() << " requests are found for the request bearing message id "
-                << request_message_id.data;
+                << key.first;
   return requests;
 }
 
 template <typename T>
-bool Accumulator<T>::RequestExists(const T& request, const routing::GroupSource& source) {
-  auto request_message_id(boost::apply_visitor(detail::MessageIdRequestVisitor(), request));
-  for (auto pending_request : pending_requests_)
-    if (request_message_id ==
-            boost::apply_visitor(detail::MessageIdRequestVisitor(), pending_request.request)
-        && source == pending_request.source && pending_request.request == request) {
-      LOG(kWarning) << "Accumulator<T>::RequestExists,  reguest with message id "
-                    << request_message_id.data << " from sender "
-                    << HexSubstr(source.sender_id->string())
-                    << " with group_id " << HexSubstr(source.group_id->string())
-                    << " already exists in the pending requests list";
-      return true;
+typename Accumulator<T>::RequestKey Accumulator<T>::MakeRequestKey(const T& request) {
+  return RequestKey(boost::apply_visitor(detail::MessageIdRequestVisitor(), request).data,
+                    request.which());
+}
+
+template <typename T>
+bool Accumulator<T>::RequestExists(const routing::GroupSource& source, const RequestKey& key,
+                                   const Digest& digest) const {
+  auto itr(pending_index_.find(key));
+  if (itr != std::end(pending_index_)) {
+    for (auto sequence : itr->second.sequences) {
+      const auto& pending_request(AtSequence(sequence));
+      if (source == pending_request.source && pending_request.digest == digest) {
+        LOG(kWarning) << "Accumulator<T>::RequestExists,  reguest with message id " << key.first
+                      << " from sender " << HexSubstr(source.sender_id->string())
+                      << " with group_id " << HexSubstr(source.group_id->string())
+                      << " already exists in the pending requests list";
+        return true;
+      }
     }
+  }
   LOG(kInfo) << "Accumulator<T>::RequestExists,  reguest with message id "
-             << request_message_id.data << " from sender " << HexSubstr(source.sender_id->string())
+             << key.first << " from sender " << HexSubstr(source.sender_id->string())
              << " with group_id " << HexSubstr(source.group_id->string())
              << " doesn't exists in the pending requests list";
   return false;
 }
 
+template <typename T>
+std::shared_ptr<const T> Accumulator<T>::FindSharedRequest(const RequestKey& key,
+                                                           const Digest& digest) const {
+  auto itr(pending_index_.find(key));
+  if (itr != std::end(pending_index_)) {
+    for (auto sequence : itr->second.sequences) {
+      if (AtSequence(sequence).digest == digest)
+        return AtSequence(sequence).request;
+    }
+  }
+  return nullptr;
+}
+
+template <typename T>
+void Accumulator<T>::ExpireAndEvict(std::chrono::steady_clock::time_point now) {
+  while (!pending_requests_.empty() && limits_.IsExpired(pending_requests_.front().arrival, now))
+    PopOldest(true);
+  // The capacity may have shrunk since the last arrival
+  while (pending_requests_.size() > limits_.capacity())
+    PopOldest(false);
+}
+
+// The oldest request is always the first of those sharing its key
+template <typename T>
+void Accumulator<T>::PopOldest(bool expired) {
+  auto itr(pending_index_.find(MakeRequestKey(*pending_requests_.front().request)));
+  assert(itr != std::end(pending_index_) && !itr->second.sequences.empty() &&
+         itr->second.sequences.front() == front_sequence_);
+  std::lock_guard<std::mutex> lock(statistics_mutex_);
+  if (!itr->second.reached_quorum) {
+    if (expired) {
+      ++statistics_.expired_before_quorum;
+    } else {
+      ++statistics_.evicted_before_quorum;
+      LOG(kWarning) << "Accumulator evicted request with message id " << itr->first.first
+                    << " before quorum; " << statistics_.evicted_before_quorum << " of "
+                    << statistics_.added << " requests evicted so far";
+    }
+  }
+  // The next copy sharing the instance, if any, now accounts for its size
+  auto& oldest(pending_requests_.front());
+  if (oldest.bytes != 0) {
+    auto sharer(std::find_if(std::next(std::begin(itr->second.sequences)),
+                             std::end(itr->second.sequences), [&](uint64_t sequence) {
+                               return AtSequence(sequence).digest == oldest.digest;
+                             }));
+    if (sharer != std::end(itr->second.sequences))
+      pending_requests_[static_cast<size_t>(*sharer - front_sequence_)].bytes = oldest.bytes;
+    else
+      pending_bytes_ -= oldest.bytes;
+  }
+  if (itr->second.sequences.size() == 1)
+    pending_index_.erase(itr);
+  else
+    itr->second.sequences.erase(std::begin(itr->second.sequences));
+  pending_requests_.pop_front();
+  ++front_sequence_;
+  statistics_.pending_count = pending_requests_.size();
+}
+
 template <typename T>
 typename Accumulator<T>::AddResult Accumulator<T>::AddRequestChecker::operator()(
-    const std::vector<T>& requests) {
+    const Requests& requests) {
+  assert(requests.digests.size() == requests.size());
   LOG(kVerbose) << "Accumulator<T>::AddRequestChecker operator(),  required_requests_ : "
                 << required_requests_ << " , checking against " << requests.size()
                 << " requests";
@@ -247,10 +457,11 @@ typename Accumulator<T>::AddResult Accumulator<T>::AddRequestChecker::operator()
     LOG(kInfo) << "Accumulator<T>::AddRequestChecke::operator() not enough pending requests";
     return AddResult::kWaiting;
   } else {
+    const auto& digests(requests.digests);
     auto index(0);
-    while ((requests.size() - index) >= required_requests_) {
-      if (std::count_if(std::begin(requests), std::end(requests), [&](const T& request) {
-            if (requests.at(index) == request) {
+    while ((digests.size() - index) >= required_requests_) {
+      if (std::count_if(std::begin(digests), std::end(digests), [&](const Digest& digest) {
+            if (digests.at(index) == digest) {
               LOG(kVerbose) << "requests match each other";
               return true;
             } else {
@@ -0,0 +1,171 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/churn_ranges.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+namespace {
+
+const size_t kNameBits(NodeId::kSize * 8);
+
+bool Bit(const std::string& name, size_t index) {
+  return ((static_cast<unsigned char>(name[index / 8]) >> (7 - index % 8)) & 1) != 0;
+}
+
+void FlipBit(std::string& name, size_t index) {
+  name[index / 8] = static_cast<char>(name[index / 8] ^ (0x80 >> (index % 8)));
+}
+
+// Returns kNameBits if the names are equal
+size_t FirstDifferingBit(const std::string& lhs, const std::string& rhs) {
+  for (size_t i(0); i != NodeId::kSize; ++i) {
+    if (lhs[i] == rhs[i])
+      continue;
+    size_t bit(i * 8);
+    while (Bit(lhs, bit) == Bit(rhs, bit))
+      ++bit;
+    return bit;
+  }
+  return kNameBits;
+}
+
+// All names starting with the first 'prefix_bits' bits of 'prefix'
+ChurnRanges::Range MakeRange(const std::string& prefix, size_t prefix_bits) {
+  ChurnRanges::Range range(prefix, prefix);
+  size_t byte(prefix_bits / 8);
+  if (prefix_bits % 8 != 0) {
+    const char kMask(static_cast<char>(0xFF >> (prefix_bits % 8)));
+    range.first[byte] = static_cast<char>(range.first[byte] & ~kMask);
+    range.second[byte] = static_cast<char>(range.second[byte] | kMask);
+    ++byte;
+  }
+  for (; byte != NodeId::kSize; ++byte) {
+    range.first[byte] = '\0';
+    range.second[byte] = static_cast<char>(0xFF);
+  }
+  return range;
+}
+
+}  // unnamed namespace
+
+ChurnRanges::ChurnRanges(size_t close_count, uint32_t full_check_interval)
+    : kCloseCount_(close_count),
+      kFullCheckInterval_(full_check_interval),
+      mutex_(),
+      nodes_(),
+      event_count_(0) {
+  assert(kCloseCount_ > 0);
+}
+
+ChurnRanges::Range ChurnRanges::AllNames() {
+  return Range(std::string(NodeId::kSize, '\0'), std::string(NodeId::kSize, '\xFF'));
+}
+
+std::vector<ChurnRanges::Range> ChurnRanges::Update(const std::vector<NodeId>& new_nodes,
+                                                    const std::vector<NodeId>& lost_nodes,
+                                                    bool check_all) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::set<std::string> kOldNodes(nodes_);
+  for (const auto& node : new_nodes)
+    nodes_.insert(node.string());
+  for (const auto& node : lost_nodes)
+    nodes_.erase(node.string());
+  if (kFullCheckInterval_ != 0 && ++event_count_ % kFullCheckInterval_ == 0)
+    check_all = true;
+  if (check_all)
+    return std::vector<Range>(1, AllNames());
+
+  // A leaving node's closeness is judged against the matrix it was in, a joining node's against
+  // the matrix it joined.
+  std::vector<Range> ranges;
+  for (const auto& node : lost_nodes)
+    AddRanges(node.string(), kOldNodes, ranges);
+  for (const auto& node : new_nodes)
+    AddRanges(node.string(), nodes_, ranges);
+  std::sort(std::begin(ranges), std::end(ranges));
+  std::vector<Range> merged_ranges;
+  for (auto& range : ranges) {
+    if (!merged_ranges.empty() && range.first <= merged_ranges.back().second)
+      merged_ranges.back().second = std::max(merged_ranges.back().second, range.second);
+    else
+      merged_ranges.push_back(std::move(range));
+  }
+  return merged_ranges;
+}
+
+void ChurnRanges::AddRanges(const std::string& node, const std::set<std::string>& matrix,
+                            std::vector<Range>& ranges) const {
+  // For each other node, the bit at which it diverges from 'node'.  A name matching 'node' at
+  // that bit is closer to 'node', otherwise it is closer to the other node.
+  std::vector<size_t> divergent_bits;
+  for (const auto& other : matrix) {
+    size_t divergent_bit(FirstDifferingBit(node, other));
+    if (divergent_bit != kNameBits)
+      divergent_bits.push_back(divergent_bit);
+  }
+  std::sort(std::begin(divergent_bits), std::end(divergent_bits));
+  std::string prefix(node);
+  AddRanges(node, prefix, 0, 0, std::begin(divergent_bits), std::end(divergent_bits), ranges);
+}
+
+// Adds the ranges within the names starting with the first 'prefix_bits' bits of 'prefix' for
+// which 'node' can be among the kCloseCount_ closest nodes.  For every such name, 'closer_count'
+// nodes are closer than 'node', while the order of those diverging from 'node' at the bits in
+// [tied_begin, tied_end) is not yet fixed.  Bits of 'prefix' from 'prefix_bits' onwards match
+// 'node'.
+void ChurnRanges::AddRanges(const std::string& node, std::string& prefix, size_t prefix_bits,
+                            size_t closer_count, std::vector<size_t>::const_iterator tied_begin,
+                            std::vector<size_t>::const_iterator tied_end,
+                            std::vector<Range>& ranges) const {
+  if (closer_count >= kCloseCount_)
+    return;
+  if (closer_count + static_cast<size_t>(tied_end - tied_begin) < kCloseCount_) {
+    ranges.push_back(MakeRange(prefix, prefix_bits));
+    return;
+  }
+  // Bits before the next divergent bit don't change the order.  Rather than splitting the names
+  // leaving 'node' at those bits by their later bits, each such subtree is taken whole.
+  const size_t kSplitBit(*tied_begin);
+  for (size_t bit(prefix_bits); bit != kSplitBit; ++bit) {
+    FlipBit(prefix, bit);
+    ranges.push_back(MakeRange(prefix, bit + 1));
+    FlipBit(prefix, bit);
+  }
+  auto split_end(std::upper_bound(tied_begin, tied_end, kSplitBit));
+  AddRanges(node, prefix, kSplitBit + 1, closer_count, split_end, tied_end, ranges);
+  FlipBit(prefix, kSplitBit);
+  AddRanges(node, prefix, kSplitBit + 1,
+            closer_count + static_cast<size_t>(split_end - tied_begin), split_end, tied_end,
+            ranges);
+  FlipBit(prefix, kSplitBit);
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,84 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_CHURN_RANGES_H_
+#define MAIDSAFE_VAULT_CHURN_RANGES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Works out which names a churn event can affect.  A name's holders only change if a joining node
+// is now among its 'close_count' closest nodes, or a leaving node was.  Every other name keeps the
+// in-range status and holders it had after the previous event, so only the ranges returned by
+// Update need checking.
+// The matrix is tracked from the new and lost nodes of each event.  Not knowing some of its nodes
+// only widens the ranges, but a missed event could narrow them wrongly, so every
+// 'full_check_interval'th event returns the whole name space.
+class ChurnRanges {
+ public:
+  // Inclusive bounds, each NodeId::kSize bytes
+  typedef std::pair<std::string, std::string> Range;
+
+  ChurnRanges(size_t close_count, uint32_t full_check_interval);
+
+  // Records the event's changes and returns the sorted, non-overlapping ranges it can affect, or a
+  // single range covering every name if 'check_all' is true or a full check is due.
+  std::vector<Range> Update(const std::vector<NodeId>& new_nodes,
+                            const std::vector<NodeId>& lost_nodes, bool check_all);
+  static Range AllNames();
+
+ private:
+  ChurnRanges(const ChurnRanges&);
+  ChurnRanges& operator=(const ChurnRanges&);
+  ChurnRanges(ChurnRanges&&);
+  ChurnRanges& operator=(ChurnRanges&&);
+
+  void AddRanges(const std::string& node, const std::set<std::string>& matrix,
+                 std::vector<Range>& ranges) const;
+  void AddRanges(const std::string& node, std::string& prefix, size_t prefix_bits,
+                 size_t closer_count, std::vector<size_t>::const_iterator tied_begin,
+                 std::vector<size_t>::const_iterator tied_end, std::vector<Range>& ranges) const;
+
+  const size_t kCloseCount_;
+  const uint32_t kFullCheckInterval_;
+  std::mutex mutex_;
+  std::set<std::string> nodes_;
+  uint32_t event_count_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_CHURN_RANGES_H_
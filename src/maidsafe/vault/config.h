@@ -19,10 +19,14 @@
 #ifndef MAIDSAFE_VAULT_CONFIG_H_
 #define MAIDSAFE_VAULT_CONFIG_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 #include "maidsafe/common/data_types/data_name_variant.h"
 
+#include "maidsafe/vault/parameters.h"
+
 namespace maidsafe {
 
 namespace vault {
@@ -41,6 +45,26 @@ enum class GroupDbMetaDataStatus {
   kGroupNonEmpty
 };
 
+// Construction options for Db and GroupDb, defaulting to the corresponding Parameters.
+struct DbOptions {
+  DbOptions()
+      : durable(Parameters::durable_dbs),
+        lock_stripe_count(Parameters::db_lock_stripe_count),
+        value_cache_capacity(Parameters::group_db_value_cache_capacity),
+        prefix_width(Parameters::group_db_prefix_width),
+        churn_full_check_interval(Parameters::churn_full_check_interval),
+        max_transfer_chunk_bytes(Parameters::max_transfer_chunk_bytes) {}
+
+  // If true, an existing db is reopened rather than replaced, and is kept on destruction
+  bool durable;
+  size_t lock_stripe_count;
+  // GroupDb only
+  size_t value_cache_capacity;
+  int prefix_width;
+  uint32_t churn_full_check_interval;
+  size_t max_transfer_chunk_bytes;
+};
+
 }  // namespace detail
 
 }  // namespace vault
@@ -28,13 +28,40 @@ namespace vault {
 
 namespace {
 
+IntegrityCheckData::Result GetResult(const char* serialised_value, size_t size,
+                                     const std::string& random_input) {
+  IntegrityCheckData::Hasher hasher(random_input);
+  hasher.Update(serialised_value, size);
+  return hasher.Finalise();
+}
+
 IntegrityCheckData::Result GetResult(const NonEmptyString& serialised_value,
                                      const std::string& random_input) {
-  return crypto::Hash<crypto::SHA512>(serialised_value.string() + random_input);
+  return GetResult(serialised_value.string().data(), serialised_value.string().size(),
+                   random_input);
 }
 
 }  // unnamed namespace
 
+IntegrityCheckData::Hasher::Hasher(std::string random_input)
+    : random_input_(std::move(random_input)), hash_(), finalised_(false) {}
+
+void IntegrityCheckData::Hasher::Update(const char* data, size_t size) {
+  hash_.Update(reinterpret_cast<const unsigned char*>(data), size);
+}
+
+IntegrityCheckData::Result IntegrityCheckData::Hasher::Finalise() {
+  if (finalised_) {
+    LOG(kError) << "IntegrityCheckData::Hasher has already been finalised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  }
+  finalised_ = true;
+  hash_.Update(reinterpret_cast<const unsigned char*>(random_input_.data()), random_input_.size());
+  std::string result(crypto::SHA512::DIGESTSIZE, '\0');
+  hash_.Final(reinterpret_cast<unsigned char*>(&result[0]));
+  return Result(result);
+}
+
 IntegrityCheckData::IntegrityCheckData() : random_input_(), result_() {}
 
 IntegrityCheckData::IntegrityCheckData(std::string random_input)
@@ -45,6 +72,11 @@ IntegrityCheckData::IntegrityCheckData(std::string random_input,
     : random_input_(std::move(random_input)),
       result_(GetResult(serialised_value, random_input_)) {}
 
+IntegrityCheckData::IntegrityCheckData(std::string random_input, const char* serialised_value,
+                                       size_t size)
+    : random_input_(std::move(random_input)),
+      result_(GetResult(serialised_value, size, random_input_)) {}
+
 IntegrityCheckData::IntegrityCheckData(const IntegrityCheckData& other)
     : random_input_(other.random_input_), result_(other.result_) {}
 
@@ -34,9 +34,30 @@ class IntegrityCheckData {
  public:
   typedef crypto::SHA512Hash Result;
 
+  // Computes a result incrementally, giving the same hash as for the serialised value joined with
+  // the random input, but without needing both in one buffer.  The serialised value can be fed in
+  // pieces, e.g. as it's read from disk.
+  class Hasher {
+   public:
+    explicit Hasher(std::string random_input);
+    void Update(const char* data, size_t size);
+    // Adds the random input and returns the result.  Throws if called more than once.
+    Result Finalise();
+
+   private:
+    Hasher(const Hasher&);
+    Hasher& operator=(const Hasher&);
+
+    std::string random_input_;
+    crypto::SHA512 hash_;
+    bool finalised_;
+  };
+
   IntegrityCheckData();
   explicit IntegrityCheckData(std::string random_input);
   IntegrityCheckData(std::string random_input, const NonEmptyString& serialised_value);
+  // Computes the result over 'size' bytes at 'serialised_value', e.g. a chunk mapped from disk.
+  IntegrityCheckData(std::string random_input, const char* serialised_value, size_t size);
   IntegrityCheckData(const IntegrityCheckData& other);
   IntegrityCheckData(IntegrityCheckData&& other);
   IntegrityCheckData& operator=(IntegrityCheckData other);
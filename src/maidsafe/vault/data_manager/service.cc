@@ -55,22 +55,37 @@ DataManagerService::DataManagerService(const passport::Pmid& pmid, routing::Rout
     : routing_(routing),
       asio_service_(2),
       data_getter_(data_getter),
-      accumulator_mutex_(),
+      accumulator_ingestion_(),
       matrix_change_mutex_(),
       stopped_(false),
       accumulator_(),
       matrix_change_(),
       dispatcher_(routing_, pmid),
+      sync_batcher_(dispatcher_, detail::Parameters::max_sync_batch_bytes),
       get_timer_(asio_service_),
       get_cached_response_timer_(asio_service_),
-      db_(UniqueDbPath(vault_root_dir)),
+      db_(PersonaDbPath(vault_root_dir, "data_manager")),
       sync_puts_(NodeId(pmid.name()->string())),
       sync_deletes_(NodeId(pmid.name()->string())),
       sync_add_pmids_(NodeId(pmid.name()->string())),
       sync_remove_pmids_(NodeId(pmid.name()->string())),
       sync_node_downs_(NodeId(pmid.name()->string())),
       sync_node_ups_(NodeId(pmid.name()->string())),
-      account_transfer_() {
+      account_transfer_(),
+      sync_retry_timer_(asio_service_, detail::Parameters::sync_retry_check_interval,
+                        [this](std::chrono::steady_clock::time_point now) {
+                          ResendDueSyncs(now);
+                        }) {
+}
+
+void DataManagerService::ResendDueSyncs(std::chrono::steady_clock::time_point now) {
+  detail::ResendDueSyncs(sync_batcher_, sync_puts_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_deletes_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_add_pmids_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_remove_pmids_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_node_downs_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_node_ups_, now);
+  sync_batcher_.Flush();
 }
 
 // ==================== Put implementation =========================================================
@@ -87,7 +102,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -103,7 +118,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -119,7 +134,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 // ==================== Get / IntegrityCheck implementation ========================================
@@ -138,7 +153,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -173,7 +188,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 
@@ -213,7 +228,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -229,7 +244,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 void DataManagerService::HandleGetResponse(const PmidName& pmid_name, nfs::MessageId message_id,
@@ -277,7 +292,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 void DataManagerService::SendDeleteRequests(const DataManager::Key& key,
@@ -297,12 +312,19 @@ void DataManagerService::HandleMessage(
     const typename SynchroniseFromDataManagerToDataManager::Sender& sender,
     const typename SynchroniseFromDataManagerToDataManager::Receiver& /*receiver*/) {
   LOG(kVerbose) << "DataManagerService::HandleMessage SynchroniseFromDataManagerToDataManager";
-  protobuf::Sync proto_sync;
-  if (!proto_sync.ParseFromString(message.contents->data)) {
+  protobuf::SyncBatch proto_sync_batch;
+  if (!proto_sync_batch.ParseFromString(message.contents->data)) {
     LOG(kError) << "SynchroniseFromDataManagerToDataManager can't parse content";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
+  detail::ApplySyncBatch(proto_sync_batch, "SynchroniseFromDataManagerToDataManager",
+                         [&](const protobuf::Sync& proto_sync) {
+                           HandleSync(proto_sync, sender);
+                         });
+}
 
+void DataManagerService::HandleSync(const protobuf::Sync& proto_sync,
+                                    const routing::GroupSource& sender) {
   switch (static_cast<nfs::MessageAction>(proto_sync.action_type())) {
     case ActionDataManagerPut::kActionId: {
       LOG(kVerbose) << "SynchroniseFromDataManagerToDataManager ActionDataManagerPut";
@@ -342,12 +364,14 @@ void DataManagerService::HandleMessage(
           proto_sync.serialised_unresolved_action(), sender.sender_id, routing_.kNodeId());
       LOG(kVerbose) << "SynchroniseFromDataManagerToDataManager ActionDataManagerAddPmid "
                     << " for chunk " << HexSubstr(unresolved_action.key.name.string())
-                    << " and pmid_node " << HexSubstr(unresolved_action.action.kPmidName->string());
+                    << " and pmid_node "
+                    << HexSubstr(unresolved_action.action.kPmidName->string());
       auto resolved_action(sync_add_pmids_.AddUnresolvedAction(unresolved_action));
       if (resolved_action) {
         LOG(kInfo) << "SynchroniseFromDataManagerToDataManager commit add pmid to db"
                    << " for chunk " << HexSubstr(unresolved_action.key.name.string())
-                   << " and pmid_node " << HexSubstr(unresolved_action.action.kPmidName->string());
+                   << " and pmid_node "
+                   << HexSubstr(unresolved_action.action.kPmidName->string());
         try {
           db_.Commit(resolved_action->key, resolved_action->action);
         }
@@ -472,10 +496,14 @@ void DataManagerService::HandleChurnEvent(std::shared_ptr<routing::MatrixChange>
 //   matrix_change->Print();
   matrix_change_ = *matrix_change;
 
-  Db<DataManager::Key, DataManager::Value>::TransferInfo transfer_info(
-      db_.GetTransferInfo(matrix_change));
-  for (auto& transfer : transfer_info)
-    TransferAccount(transfer.first, transfer.second);
+  // Entries recovered from a previous run are kept unless out of range for this node
+  if (db_.Recovered())
+    LOG(kInfo) << "DataManagerService checking recovered entries against close group";
+  db_.GetTransferInfo(matrix_change,
+      [this](const NodeId& new_holder,
+             std::vector<Db<DataManager::Key, DataManager::Value>::KvPair>&& chunk) {
+        TransferAccount(new_holder, chunk);
+      });
 //   LOG(kVerbose) << "HandleChurnEvent matrix_change_ containing following info after : ";
 //   matrix_change_.Print();
 }
@@ -488,6 +516,7 @@ void DataManagerService::TransferAccount(const NodeId& dest,
     LOG(kWarning) << "DataManager account just received";
     return;
   }
+  assert(!accounts.empty());
   std::vector<std::string> actions;
   for (auto& account : accounts) {
     VLOG(nfs::Persona::kDataManager, VisualiserAction::kAccountTransfer, account.first.name,
@@ -497,7 +526,9 @@ void DataManagerService::TransferAccount(const NodeId& dest,
     kv_msg.set_value(account.second.Serialise());
     actions.push_back(kv_msg.SerializeAsString());
   }
-  nfs::MessageId message_id(HashStringToMessageId(dest.string()));
+  // Holders send the same chunks, so a chunk's first key identifies it
+  nfs::MessageId message_id(HashStringToMessageId(
+      dest.string() + accounts.front().first.Serialise()));
   DataManager::UnresolvedAccountTransfer account_transfer(
       passport::PublicPmid::Name(Identity(dest.string())), message_id, actions);
   LOG(kVerbose) << "DataManagerService::TransferAccount send account_transfer";
@@ -518,7 +549,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -534,7 +565,7 @@ void DataManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 
@@ -565,6 +596,18 @@ void DataManagerService::HandleMessage(
 //  // containing record name, old_holders, new_holders.
 // }
 
+detail::ServiceStatistics DataManagerService::GetStatistics() const {
+  detail::ServiceStatistics statistics;
+  statistics.accumulators["accumulator"] = accumulator_.GetStatistics();
+  statistics.syncs["puts"] = sync_puts_.GetStatistics();
+  statistics.syncs["deletes"] = sync_deletes_.GetStatistics();
+  statistics.syncs["add_pmids"] = sync_add_pmids_.GetStatistics();
+  statistics.syncs["remove_pmids"] = sync_remove_pmids_.GetStatistics();
+  statistics.syncs["node_downs"] = sync_node_downs_.GetStatistics();
+  statistics.syncs["node_ups"] = sync_node_ups_.GetStatistics();
+  return statistics;
+}
+
 }  // namespace vault
 
 }  // namespace maidsafe
@@ -20,6 +20,7 @@
 #define MAIDSAFE_VAULT_DATA_MANAGER_SERVICE_H_
 
 #include <algorithm>
+#include <chrono>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -45,10 +46,14 @@
 #include "maidsafe/vault/account_transfer.h"
 #include "maidsafe/vault/accumulator.h"
 #include "maidsafe/vault/group_db.h"
+#include "maidsafe/vault/ingestion_queue.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/operation_visitors.h"
 #include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/sync.h"
+#include "maidsafe/vault/sync_batcher.h"
+#include "maidsafe/vault/sync_retry_timer.h"
+#include "maidsafe/vault/statistics.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/data_manager/action_put.h"
 #include "maidsafe/vault/data_manager/data_manager.h"
@@ -83,6 +88,9 @@ class DataManagerService {
 
   void HandleChurnEvent(std::shared_ptr<routing::MatrixChange> matrix_change);
 
+  // Snapshot of the Accumulator and Sync statistics, safe to call from any thread
+  detail::ServiceStatistics GetStatistics() const;
+
   void Stop() {
     std::lock_guard<std::mutex> lock(matrix_change_mutex_);
     stopped_ = true;
@@ -206,6 +214,9 @@ class DataManagerService {
   // =========================== Sync / AccountTransfer section ====================================
   template <typename UnresolvedAction>
   void DoSync(const UnresolvedAction& unresolved_action);
+  // Applies one sync from a received batch
+  void HandleSync(const protobuf::Sync& proto_sync, const routing::GroupSource& sender);
+  void ResendDueSyncs(std::chrono::steady_clock::time_point now);
 
   void TransferAccount(const NodeId& dest,
                        const std::vector<Db<DataManager::Key,
@@ -264,11 +275,13 @@ class DataManagerService {
   routing::Routing& routing_;
   AsioService asio_service_;
   nfs_client::DataGetter& data_getter_;
-  mutable std::mutex accumulator_mutex_, matrix_change_mutex_;
+  detail::IngestionQueue accumulator_ingestion_;
+  mutable std::mutex matrix_change_mutex_;
   bool stopped_;
   Accumulator<Messages> accumulator_;
   routing::MatrixChange matrix_change_;
   DataManagerDispatcher dispatcher_;
+  detail::SyncBatcher<DataManagerDispatcher> sync_batcher_;
   routing::Timer<std::pair<PmidName, GetResponseContents>> get_timer_;
   routing::Timer<GetCachedResponseContents> get_cached_response_timer_;
   Db<DataManager::Key, DataManager::Value> db_;
@@ -279,6 +292,7 @@ class DataManagerService {
   Sync<DataManager::UnresolvedNodeDown> sync_node_downs_;
   Sync<DataManager::UnresolvedNodeUp> sync_node_ups_;
   AccountTransfer<DataManager::UnresolvedAccountTransfer> account_transfer_;
+  detail::SyncRetryTimer sync_retry_timer_;
 
  protected:
   std::mutex lock_guard;
@@ -903,12 +917,7 @@ void DataManagerService::MarkNodeUp(const PmidName& pmid_node, const DataName& n
 
 template <typename UnresolvedAction>
 void DataManagerService::DoSync(const UnresolvedAction& unresolved_action) {
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_puts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_deletes_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_add_pmids_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_remove_pmids_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_node_downs_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_node_ups_, unresolved_action);
+  detail::SendSyncAction(sync_batcher_, unresolved_action);
 }
 
 }  // namespace vault
@@ -19,6 +19,8 @@
 #ifndef MAIDSAFE_VAULT_DB_H_
 #define MAIDSAFE_VAULT_DB_H_
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -29,59 +31,104 @@
 #include "boost/filesystem.hpp"
 
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
+#include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/visualiser_log.h"
 #include "maidsafe/routing/matrix_change.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/vault/churn_ranges.h"
 #include "maidsafe/vault/config.h"
+#include "maidsafe/vault/striped_mutex.h"
+#include "maidsafe/vault/transfer_chunks.h"
 #include "maidsafe/vault/types.h"
+#include "maidsafe/vault/utils.h"
 
 
 namespace maidsafe {
 
 namespace vault {
 
+// Keys are locked by a hash of Key::name, split between 'options.lock_stripe_count' mutexes.
+// In durable mode an existing db is reopened, repairing it if corrupt, and kept on destruction.
+// Its format version is stored under the empty key, which no entry key can collide with.
+// GetTransferInfo only checks the names which the churn event could have moved (see ChurnRanges),
+// so it must be called for every churn event.
 template <typename Key, typename Value>
 class Db {
  public:
   typedef std::pair<Key, Value> KvPair;
   typedef std::map<NodeId, std::vector<KvPair>> TransferInfo;
+  typedef std::function<detail::DbAction(std::unique_ptr<Value>& value)> CommitFunctor;
+  typedef typename detail::TransferChunks<KvPair>::ChunkFunctor TransferFunctor;
 
-  explicit Db(const boost::filesystem::path& db_path);
+  explicit Db(const boost::filesystem::path& db_path,
+              const detail::DbOptions& options = detail::DbOptions());
   ~Db();
 
   Value Get(const Key& key);
   // if functor returns DbAction::kDelete, the value is deleted from db
-  std::unique_ptr<Value> Commit(
-      const Key& key, std::function<detail::DbAction(std::unique_ptr<Value>& value)> functor);
+  std::unique_ptr<Value> Commit(const Key& key, CommitFunctor functor);
+  // Runs each functor in turn with the same semantics as Commit, a functor seeing the result of
+  // any earlier functor for the same key, then writes all puts and deletes in a single
+  // leveldb::WriteBatch.  If any functor throws or the write fails, nothing is written.  The
+  // returned vector holds, for each functor, the deleted value if it returned kDelete, else null.
+  std::vector<std::unique_ptr<Value>> CommitBatch(
+      const std::vector<std::pair<Key, CommitFunctor>>& key_functor_pairs);
+  // Prunes entries no longer in range and returns all those to be moved to new holders.
   TransferInfo GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change);
+  // As above, but passes the entries to be moved to 'functor' while scanning, in chunks of at most
+  // 'options.max_transfer_chunk_bytes' per new holder (see TransferChunks).
+  void GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change,
+                       const TransferFunctor& functor);
   void HandleTransfer(const std::vector<KvPair>& contents);
+  // True if existing entries were found when the db was opened, until a GetTransferInfo call has
+  // checked them all against the current close group, pruning those out of range.  Recovered
+  // entries are always all checked, whatever the churn event.
+  bool Recovered() const { return recovered_; }
 
  private:
   Db(const Db&);
   Db& operator=(const Db&);
   Db(Db&&);
   Db& operator=(Db&&);
+  void OpenDurable();
+  std::unique_ptr<Value> GetIfExists(const Key& key);
   void Delete(const Key& key);
   void Put(const KvPair& key_value_pair);
 
+  static const uint32_t kFormatVersion_ = 1;
+  const bool kDurable_;
+  const size_t kMaxTransferChunkBytes_;
   const boost::filesystem::path kDbPath_;
-  mutable std::mutex mutex_;
+  detail::StripedMutex mutexes_;
+  detail::ChurnRanges churn_ranges_;
   std::unique_ptr<leveldb::DB> leveldb_;
+  std::atomic<bool> recovered_;
 };
 
 template <typename Key, typename Value>
-Db<Key, Value>::Db(const boost::filesystem::path& db_path)
-    : kDbPath_(db_path),
-      mutex_(), leveldb_() {
-  leveldb::DB* db;
-  leveldb::Options options;
-  options.create_if_missing = true;
-  options.error_if_exists = true;
-  leveldb::Status status(leveldb::DB::Open(options, kDbPath_.string(), &db));
-  if (!status.ok())
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
-  leveldb_ = std::move(std::unique_ptr<leveldb::DB>(db));
+Db<Key, Value>::Db(const boost::filesystem::path& db_path, const detail::DbOptions& options)
+    : kDurable_(options.durable),
+      kMaxTransferChunkBytes_(options.max_transfer_chunk_bytes),
+      kDbPath_(db_path),
+      mutexes_(options.lock_stripe_count),
+      churn_ranges_(routing::Parameters::group_size + 1, options.churn_full_check_interval),
+      leveldb_(),
+      recovered_(false) {
+  if (kDurable_) {
+    OpenDurable();
+  } else {
+    leveldb::DB* db;
+    leveldb::Options leveldb_options;
+    leveldb_options.create_if_missing = true;
+    leveldb_options.error_if_exists = true;
+    leveldb::Status status(leveldb::DB::Open(leveldb_options, kDbPath_.string(), &db));
+    if (!status.ok())
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    leveldb_ = std::move(std::unique_ptr<leveldb::DB>(db));
+  }
   assert(leveldb_);
 #if defined(__GNUC__) && (!defined(MAIDSAFE_APPLE) && !(defined(_MSC_VER) && _MSC_VER == 1700))
   // Remove this assert if value needs to be copy constructible.
@@ -95,6 +142,8 @@ Db<Key, Value>::Db(const boost::filesystem::path& db_path)
 
 template <typename Key, typename Value>
 Db<Key, Value>::~Db() {
+  if (kDurable_)
+    return;
   try {
     leveldb::DestroyDB(kDbPath_.string(), leveldb::Options());
     boost::filesystem::remove_all(kDbPath_);
@@ -104,20 +153,39 @@ Db<Key, Value>::~Db() {
 }
 
 template <typename Key, typename Value>
-std::unique_ptr<Value> Db<Key, Value>::Commit(const Key& key,
-    std::function<detail::DbAction(std::unique_ptr<Value>& value)> functor) {
-  assert(functor);
-  std::lock_guard<std::mutex> lock(mutex_);
-  std::unique_ptr<Value> value;
-  try {
-    value.reset(new Value(Get(key)));
-  } catch (const maidsafe_error& error) {
-    if (error.code() != make_error_code(VaultErrors::no_such_account)) {
-      LOG(kError) << "Db<Key, Value>::Commit unknown db error "
-                  << boost::diagnostic_information(error);
-      throw error;  // For db errors
+void Db<Key, Value>::OpenDurable() {
+  bool repaired(false);
+  leveldb_ = OpenLevelDb(kDbPath_, &repaired);
+  std::string version_string;
+  leveldb::Status status(leveldb_->Get(leveldb::ReadOptions(), "", &version_string));
+  if (status.ok()) {
+    if (version_string != std::to_string(kFormatVersion_)) {
+      LOG(kError) << "Db at " << kDbPath_ << " has unknown format version " << version_string;
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
     }
+  } else if (status.IsNotFound()) {
+    leveldb::WriteOptions write_options;
+    write_options.sync = true;
+    if (!leveldb_->Put(write_options, "", std::to_string(kFormatVersion_)).ok())
+      BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  } else {
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
   }
+
+  std::unique_ptr<leveldb::Iterator> db_iter(leveldb_->NewIterator(leveldb::ReadOptions()));
+  db_iter->SeekToFirst();
+  if (db_iter->Valid() && db_iter->key().empty())
+    db_iter->Next();
+  recovered_ = db_iter->Valid();
+  LOG(kInfo) << "Db opened " << kDbPath_ << (repaired ? " after repair" : "")
+             << (recovered_ ? " with existing entries" : "");
+}
+
+template <typename Key, typename Value>
+std::unique_ptr<Value> Db<Key, Value>::Commit(const Key& key, CommitFunctor functor) {
+  assert(functor);
+  auto lock(mutexes_.LockName(key.name.string()));
+  std::unique_ptr<Value> value(GetIfExists(key));
   if (detail::DbAction::kPut == functor(value)) {
     assert(value);
     if (!value)
@@ -134,59 +202,129 @@ std::unique_ptr<Value> Db<Key, Value>::Commit(const Key& key,
   return nullptr;
 }
 
-// option 1 : Fire functor here with check_holder_result.new_holder & the corresponding value
-// option 2 : create a map<NodeId, std::vector<std::pair<Key, value>>> and return after pruning
+template <typename Key, typename Value>
+std::vector<std::unique_ptr<Value>> Db<Key, Value>::CommitBatch(
+    const std::vector<std::pair<Key, CommitFunctor>>& key_functor_pairs) {
+  std::vector<std::string> names;
+  names.reserve(key_functor_pairs.size());
+  for (const auto& key_functor : key_functor_pairs)
+    names.push_back(key_functor.first.name.string());
+  auto locks(mutexes_.LockNames(names));
+  // Result of the functors run so far, per key.  A null value marks a pending delete.
+  std::map<Key, std::unique_ptr<Value>> staged_values;
+  std::vector<std::unique_ptr<Value>> deleted_values;
+  deleted_values.reserve(key_functor_pairs.size());
+  for (const auto& key_functor : key_functor_pairs) {
+    assert(key_functor.second);
+    std::unique_ptr<Value> value;
+    auto staged_itr(staged_values.find(key_functor.first));
+    if (staged_itr != std::end(staged_values))
+      value = std::move(staged_itr->second);
+    else
+      value = GetIfExists(key_functor.first);
+
+    if (detail::DbAction::kPut == key_functor.second(value)) {
+      assert(value);
+      if (!value)
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
+      staged_values[key_functor.first] = std::move(value);
+      deleted_values.push_back(nullptr);
+    } else {
+      assert(value);
+      staged_values[key_functor.first] = nullptr;
+      deleted_values.push_back(std::move(value));
+    }
+  }
+
+  leveldb::WriteBatch batch;
+  for (const auto& staged : staged_values) {
+    if (staged.second)
+      batch.Put(staged.first.ToFixedWidthKey().slice(), staged.second->Serialise());
+    else
+      batch.Delete(staged.first.ToFixedWidthKey().slice());
+  }
+  LOG(kInfo) << "Db<Key, Value>::CommitBatch writing " << staged_values.size() << " entries";
+  leveldb::Status status(leveldb_->Write(leveldb::WriteOptions(), &batch));
+  if (!status.ok()) {
+    LOG(kError) << "Db<Key, Value>::CommitBatch incorrect leveldb::Status";
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  }
+  return deleted_values;
+}
+
 template <typename Key, typename Value>
 typename Db<Key, Value>::TransferInfo Db<Key, Value>::GetTransferInfo(
     std::shared_ptr<routing::MatrixChange> matrix_change) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  std::vector<std::string> prune_vector;
   TransferInfo transfer_info;
+  GetTransferInfo(matrix_change, [&](const NodeId& new_holder, std::vector<KvPair>&& chunk) {
+    auto& kv_pairs(transfer_info[new_holder]);
+    for (auto& kv_pair : chunk)
+      kv_pairs.push_back(std::move(kv_pair));
+  });
+  return transfer_info;
+}
+
+// Reads from a snapshot so no lock is held while scanning; each pruned key is then deleted under
+// its own stripe's lock.  Only the ranges of names the churn event can affect are read.
+template <typename Key, typename Value>
+void Db<Key, Value>::GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change,
+                                     const TransferFunctor& functor) {
+  assert(functor);
+  if (!matrix_change)
+    return;
+  std::vector<Key> prune_vector;
   {
-    LOG(kVerbose) << "Db::GetTransferInfo";
-    std::unique_ptr<leveldb::Iterator> db_iter(leveldb_->NewIterator(leveldb::ReadOptions()));
-    for (db_iter->SeekToFirst(); db_iter->Valid(); db_iter->Next()) {
-      Key key(typename Key::FixedWidthString(db_iter->key().ToString()));
-      auto check_holder_result = matrix_change->CheckHolders(NodeId(key.name.string()));
-      if (check_holder_result.proximity_status == routing::GroupRangeStatus::kInRange) {
-        LOG(kVerbose) << "Db::GetTransferInfo in range ";
-        if (check_holder_result.new_holders.size() != 0) {
-          LOG(kVerbose) << "Db::GetTransferInfo having new node "
-                        << DebugId(check_holder_result.new_holders.at(0));
-//           assert(check_holder_result.new_holders.size() == 1);
-          if (check_holder_result.new_holders.size() != 1)
-            LOG(kError) << "having " << check_holder_result.new_holders.size()
-                        << " new holders, only the first one got processed";
-          auto found_itr = transfer_info.find(check_holder_result.new_holders.at(0));
-          if (found_itr != transfer_info.end()) {
-            found_itr->second.push_back(std::make_pair(key, Value(db_iter->value().ToString())));
-          } else {  // create
-            LOG(kInfo) << "Db::GetTransferInfo transfering account "
-                       << HexSubstr(key.name.string()) << " to "
-                       << DebugId(check_holder_result.new_holders.at(0));
-            std::vector<KvPair> kv_pair;
-            kv_pair.push_back(std::make_pair(key, Value(db_iter->value().ToString())));
-            transfer_info.insert(std::make_pair(check_holder_result.new_holders.at(0),
-                                                std::move(kv_pair)));
+    auto ranges(churn_ranges_.Update(matrix_change->new_nodes(), matrix_change->lost_nodes(),
+                                     recovered_));
+    LOG(kVerbose) << "Db::GetTransferInfo checking " << ranges.size() << " ranges";
+    detail::TransferChunks<KvPair> chunks(kMaxTransferChunkBytes_, functor);
+    leveldb::ReadOptions read_options;
+    read_options.snapshot = leveldb_->GetSnapshot();
+    on_scope_exit release_snapshot([&]() { leveldb_->ReleaseSnapshot(read_options.snapshot); });
+    std::unique_ptr<leveldb::Iterator> db_iter(leveldb_->NewIterator(read_options));
+    for (const auto& range : ranges) {
+      // Seeking to a full name skips the format version under the empty key
+      for (db_iter->Seek(range.first);
+           db_iter->Valid() && db_iter->key().size() >= NodeId::kSize &&
+               leveldb::Slice(db_iter->key().data(), NodeId::kSize).compare(range.second) <= 0;
+           db_iter->Next()) {
+        Key key(db_iter->key());
+        auto check_holder_result = matrix_change->CheckHolders(NodeId(key.name.string()));
+        if (check_holder_result.proximity_status == routing::GroupRangeStatus::kInRange) {
+          LOG(kVerbose) << "Db::GetTransferInfo in range ";
+          if (check_holder_result.new_holders.size() != 0) {
+            LOG(kVerbose) << "Db::GetTransferInfo transfering " << HexSubstr(key.name.string())
+                          << " to " << DebugId(check_holder_result.new_holders.at(0));
+//             assert(check_holder_result.new_holders.size() == 1);
+            if (check_holder_result.new_holders.size() != 1)
+              LOG(kError) << "having " << check_holder_result.new_holders.size()
+                          << " new holders, only the first one got processed";
+            chunks.Add(check_holder_result.new_holders.at(0), db_iter->key(),
+                       std::make_pair(key, Value(db_iter->value().ToString())),
+                       db_iter->key().size() + db_iter->value().size());
           }
+        } else {
+          VLOG(VisualiserAction::kRemoveAccount, Identity{ db_iter->key().data() });
+          prune_vector.push_back(key);
         }
-      } else {
-        VLOG(VisualiserAction::kRemoveAccount, Identity{ db_iter->key().data() });
-        prune_vector.push_back(db_iter->key().data());
       }
     }
+    chunks.Flush();
   }
 
-  for (const auto& key_string : prune_vector)
-    leveldb_->Delete(leveldb::WriteOptions(), key_string);  // Ignore Delete failure here ?
-  return transfer_info;
+  for (const auto& key : prune_vector) {
+    auto lock(mutexes_.LockName(key.name.string()));
+    // Ignore Delete failure here ?
+    leveldb_->Delete(leveldb::WriteOptions(), key.ToFixedWidthKey().slice());
+  }
+  recovered_ = false;
 }
 
 // Ignores values which are already in db
 template <typename Key, typename Value>
 void Db<Key, Value>::HandleTransfer(const std::vector<std::pair<Key, Value>>& contents) {
-  std::lock_guard<std::mutex> lock(mutex_);
   for (const auto& kv_pair : contents) {
+    auto lock(mutexes_.LockName(kv_pair.first.name.string()));
     try {
       Get(kv_pair.first);
     } catch (const maidsafe_error& error) {
@@ -207,7 +345,7 @@ Value Db<Key, Value>::Get(const Key& key) {
   read_options.verify_checksums = true;
   std::string value_string;
   leveldb::Status status(
-      leveldb_->Get(read_options, key.ToFixedWidthString().string(), &value_string));
+      leveldb_->Get(read_options, key.ToFixedWidthKey().slice(), &value_string));
   if (status.ok()) {
     assert(!value_string.empty());
     return Value(value_string);
@@ -217,10 +355,26 @@ Value Db<Key, Value>::Get(const Key& key) {
   BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
 }
 
+// returns null if key is not in db, throws on other level-db errors
+template <typename Key, typename Value>
+std::unique_ptr<Value> Db<Key, Value>::GetIfExists(const Key& key) {
+  std::unique_ptr<Value> value;
+  try {
+    value.reset(new Value(Get(key)));
+  } catch (const maidsafe_error& error) {
+    if (error.code() != make_error_code(VaultErrors::no_such_account)) {
+      LOG(kError) << "Db<Key, Value>::GetIfExists unknown db error "
+                  << boost::diagnostic_information(error);
+      throw error;  // For db errors
+    }
+  }
+  return value;
+}
+
 template <typename Key, typename Value>
 void Db<Key, Value>::Put(const KvPair& key_value_pair) {
   leveldb::Status status(leveldb_->Put(leveldb::WriteOptions(),
-                                       key_value_pair.first.ToFixedWidthString().string(),
+                                       key_value_pair.first.ToFixedWidthKey().slice(),
                                        key_value_pair.second.Serialise()));
   if (!status.ok()) {
     LOG(kError) << "Db<Key, Value>::Put incorrect leveldb::Status";
@@ -231,7 +385,7 @@ void Db<Key, Value>::Put(const KvPair& key_value_pair) {
 template <typename Key, typename Value>
 void Db<Key, Value>::Delete(const Key& key) {
   leveldb::Status status(
-      leveldb_->Delete(leveldb::WriteOptions(), key.ToFixedWidthString().string()));
+      leveldb_->Delete(leveldb::WriteOptions(), key.ToFixedWidthKey().slice()));
   if (!status.ok()) {
     LOG(kError) << "Db<Key, Value>::Delete incorrect leveldb::Status";
     BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
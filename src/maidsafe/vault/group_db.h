@@ -20,6 +20,7 @@
 #define MAIDSAFE_VAULT_GROUP_DB_H_
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <map>
@@ -33,20 +34,43 @@
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
+#include "maidsafe/common/active.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/visualiser_log.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/vault/churn_ranges.h"
 #include "maidsafe/vault/utils.h"
 #include "maidsafe/vault/config.h"
+#include "maidsafe/vault/group_db.pb.h"
+#include "maidsafe/vault/group_id_allocator.h"
+#include "maidsafe/vault/striped_mutex.h"
+#include "maidsafe/vault/transfer_chunks.h"
+#include "maidsafe/vault/value_cache.h"
 #include "maidsafe/vault/pmid_manager/pmid_manager.h"
 
 namespace maidsafe {
 
 namespace vault {
 
-// All public methods provide strong exception guarantee
+// All public methods provide strong exception guarantee.
+// Groups are locked by a hash of GroupName, split between 'options.lock_stripe_count' mutexes.  The
+// map of groups has its own mutex, held only while the map itself is searched or modified; an
+// entry's group id and metadata are only read or written while holding that group's stripe lock.
+// Up to 'options.value_cache_capacity' recently used values are cached, deserialised, in a
+// write-through LRU cache keyed by leveldb key.  Each group's entries are prefixed by its
+// 'options.prefix_width' byte group id, allowing up to 256 ^ prefix_width - 1 groups.
+// In durable mode each group's id and metadata are also stored, under the reserved group id 0
+// followed by the group name, and the db is reloaded rather than replaced on construction.  The
+// prefix width is recorded under the empty key; if it differs from the one requested, the db is
+// re-keyed before use.
+// A deleted group's entries are removed in a single write, and the group's key range is then
+// compacted in the background; deletions made while a compaction is pending are coalesced into it.
+// GetTransferInfo only checks the groups which the churn event could have moved (see ChurnRanges),
+// so it must be called for every churn event.
 template <typename Persona>
 class GroupDb {
  public:
@@ -57,6 +81,7 @@ class GroupDb {
   typedef std::pair<Key, Value> KvPair;
   struct Contents;
   typedef std::map<NodeId, std::vector<Contents>> TransferInfo;
+  typedef std::function<void(const NodeId& new_holder, Contents&& contents)> TransferFunctor;
 
   struct Contents {
     Contents() : group_name(), metadata(), kv_pairs() {}
@@ -73,7 +98,8 @@ class GroupDb {
     Contents(const Contents& other);
   };
 
-  explicit GroupDb(const boost::filesystem::path& db_path);
+  explicit GroupDb(const boost::filesystem::path& db_path,
+                   const detail::DbOptions& options = detail::DbOptions());
   ~GroupDb();
 
   void AddGroup(const GroupName& group_name, const Metadata& metadata);
@@ -84,7 +110,12 @@ class GroupDb {
   // For atomically updating metadata and value
   std::unique_ptr<Value> Commit(const Key& key,
       std::function<detail::DbAction(Metadata& metadata, std::unique_ptr<Value>& value)> functor);
+  // Prunes groups no longer in range and returns all those to be moved to new holders.
   TransferInfo GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change);
+  // As above, but passes each group to be moved to 'functor' while scanning, split into chunks of
+  // at most 'options.max_transfer_chunk_bytes' of entries.
+  void GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change,
+                       const TransferFunctor& functor);
   void HandleTransfer(const Contents& content);
 
   // returns metadata if group_name exists in db
@@ -93,6 +124,12 @@ class GroupDb {
   Value GetValue(const Key& key);
   Contents GetContents(const GroupName& group_name);
 
+  // True if groups were loaded when the db was opened, until a GetTransferInfo call has checked
+  // them all against the current close group, pruning those out of range.
+  bool Recovered() const { return recovered_; }
+  uint64_t value_cache_hits() const { return value_cache_.hits(); }
+  uint64_t value_cache_misses() const { return value_cache_.misses(); }
+
  private:
   typedef uint32_t GroupId;
   typedef std::map<GroupName, std::pair<GroupId, Metadata>> GroupMap;
@@ -101,27 +138,55 @@ class GroupDb {
   GroupDb(GroupDb&&);
   GroupDb& operator=(GroupDb&&);
 
+  void OpenDurable();
+  void Migrate(int old_prefix_width, const boost::filesystem::path& migration_path);
+  void LoadGroups();
+  void WriteFormatRecord(leveldb::DB& db) const;
+  std::string MakeGroupRecordKey(const GroupName& group_name) const;
+  void AddGroupRecord(leveldb::WriteBatch& batch, typename GroupMap::const_iterator it) const;
+  void AddGroupRecord(leveldb::WriteBatch& batch, const GroupName& group_name, GroupId group_id,
+                      const Metadata& metadata) const;
+  void WriteGroupRecord(typename GroupMap::const_iterator it);
+  void Write(leveldb::WriteBatch& batch);
+
   typename GroupMap::iterator AddGroupToMap(const GroupName& group_name, const Metadata& metadata);
   void UpdateGroup(typename GroupMap::iterator itr);
 
   void DeleteGroupEntries(const GroupName& group_name);
   void DeleteGroupEntries(typename GroupMap::iterator itr);
-  Contents GetContents(typename GroupMap::iterator it);
+  void ScheduleCompaction(GroupId group_id);
+  void CompactPendingGroups();
+  Contents GetContents(typename GroupMap::const_iterator it,
+                       const leveldb::ReadOptions& read_options = leveldb::ReadOptions());
+  void GetContents(typename GroupMap::const_iterator it, const leveldb::ReadOptions& read_options,
+                   const NodeId& new_holder, const TransferFunctor& functor);
   void ApplyTransfer(const Contents& /*contents*/);
-  Value Get(const Key& key, const GroupId& group_id);
-  void Put(const KvPair& key_value_pair, const GroupId& group_id);
-  void Delete(const Key& key, const GroupId& group_id);
-  std::string MakeLevelDbKey(const GroupId& group_id, const Key& key);
+  Value Get(const detail::FixedWidthKey& db_key);
+  std::unique_ptr<Value> Read(const detail::FixedWidthKey& db_key);
+  void Put(const detail::FixedWidthKey& db_key, const Value& value);
+  detail::FixedWidthKey MakeLevelDbKey(const GroupId& group_id, const Key& key) const;
+  detail::FixedWidthKey MakeGroupPrefix(const GroupId& group_id) const;
   Key MakeKey(const GroupName group_name, const leveldb::Slice& level_db_key);
   uint32_t GetGroupId(const leveldb::Slice& level_db_key) const;
   typename GroupMap::iterator FindGroup(const GroupName& group_name);
   typename GroupMap::iterator FindOrCreateGroup(const GroupName& group_name);
 
-  static const int kPrefixWidth_ = 2;
+  static const uint32_t kFormatVersion_ = 1;
+  const int kPrefixWidth_;
+  const bool kDurable_;
+  const size_t kMaxTransferChunkBytes_;
   const boost::filesystem::path kDbPath_;
-  std::mutex mutex_;
+  detail::StripedMutex mutexes_;
+  detail::ChurnRanges churn_ranges_;
+  std::mutex group_map_mutex_;
   std::unique_ptr<leveldb::DB> leveldb_;
   GroupMap group_map_;
+  detail::GroupIdAllocator group_ids_;
+  detail::ValueCache<Value, detail::FixedWidthKey, detail::FixedWidthKeyHash> value_cache_;
+  std::atomic<bool> recovered_;
+  std::mutex compaction_mutex_;
+  std::set<GroupId> pending_compactions_;
+  std::unique_ptr<Active> compactor_;
 };
 
 template <>
@@ -132,11 +197,23 @@ template <>
 void GroupDb<PmidManager>::UpdateGroup(typename GroupMap::iterator itr);
 
 template <typename Persona>
-GroupDb<Persona>::GroupDb(const boost::filesystem::path& db_path)
-    : kDbPath_(db_path),
-      mutex_(),
-      leveldb_(InitialiseLevelDb(kDbPath_)),
-      group_map_() {
+GroupDb<Persona>::GroupDb(const boost::filesystem::path& db_path,
+                          const detail::DbOptions& options)
+    : kPrefixWidth_(options.prefix_width),
+      kDurable_(options.durable),
+      kMaxTransferChunkBytes_(options.max_transfer_chunk_bytes),
+      kDbPath_(db_path),
+      mutexes_(options.lock_stripe_count),
+      churn_ranges_(routing::Parameters::group_size + 1, options.churn_full_check_interval),
+      group_map_mutex_(),
+      leveldb_(),
+      group_map_(),
+      group_ids_(kPrefixWidth_),
+      value_cache_(options.value_cache_capacity),
+      recovered_(false),
+      compaction_mutex_(),
+      pending_compactions_(),
+      compactor_(new Active()) {
 #if defined(__GNUC__) && (!defined(MAIDSAFE_APPLE) && !(defined(_MSC_VER) && _MSC_VER == 1700))
   // Remove this assert if value needs to be copy constructible.
   // this is just a check to avoid copy constructor unless we require it
@@ -148,10 +225,18 @@ GroupDb<Persona>::GroupDb(const boost::filesystem::path& db_path)
   static_assert(std::is_move_constructible<typename Persona::Value>::value,
                 "value should be move constructible !");
 #endif
+  if (kDurable_)
+    OpenDurable();
+  else
+    leveldb_ = InitialiseLevelDb(kDbPath_);
 }
 
 template <typename Persona>
 GroupDb<Persona>::~GroupDb() {
+  // Runs any pending compaction before the db is closed or destroyed
+  compactor_.reset();
+  if (kDurable_)
+    return;
   try {
     leveldb::DestroyDB(kDbPath_.string(), leveldb::Options());
     boost::filesystem::remove_all(kDbPath_);
@@ -160,30 +245,181 @@ GroupDb<Persona>::~GroupDb() {
   }
 }
 
+// A migration which was interrupted before its result replaced the original db is redone, unless
+// the original had already been removed, in which case the completed result is used.
+template <typename Persona>
+void GroupDb<Persona>::OpenDurable() {
+  const boost::filesystem::path kMigrationPath(kDbPath_.string() + ".migrating");
+  if (boost::filesystem::exists(kMigrationPath)) {
+    if (boost::filesystem::exists(kDbPath_))
+      boost::filesystem::remove_all(kMigrationPath);
+    else
+      boost::filesystem::rename(kMigrationPath, kDbPath_);
+  }
+  leveldb_ = OpenLevelDb(kDbPath_);
+
+  std::string format_string;
+  leveldb::Status status(leveldb_->Get(leveldb::ReadOptions(), "", &format_string));
+  if (status.IsNotFound()) {
+    WriteFormatRecord(*leveldb_);
+  } else if (!status.ok()) {
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  } else {
+    protobuf::GroupDbFormat format;
+    if (!format.ParseFromString(format_string))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    if (format.version() != kFormatVersion_) {
+      LOG(kError) << "GroupDb at " << kDbPath_ << " has unknown format version "
+                  << format.version();
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+    }
+    if (format.prefix_width() != kPrefixWidth_)
+      Migrate(format.prefix_width(), kMigrationPath);
+  }
+  LoadGroups();
+}
+
+// Copies every group, re-keyed to the current prefix width, into a new db at 'migration_path'.
+// The format record is written last, marking the copy complete, before it replaces the original.
+template <typename Persona>
+void GroupDb<Persona>::Migrate(int old_prefix_width,
+                               const boost::filesystem::path& migration_path) {
+  LOG(kInfo) << "GroupDb migrating " << kDbPath_ << " from prefix width " << old_prefix_width
+             << " to " << kPrefixWidth_;
+  if (old_prefix_width < 1 || old_prefix_width > 4)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  {
+    std::unique_ptr<leveldb::DB> migrated_db(InitialiseLevelDb(migration_path));
+    detail::GroupIdAllocator group_ids(kPrefixWidth_);
+    const std::string kOldRecordPrefix(old_prefix_width, '\0');
+    std::unique_ptr<leveldb::Iterator> group_iter(leveldb_->NewIterator(leveldb::ReadOptions()));
+    std::unique_ptr<leveldb::Iterator> entry_iter(leveldb_->NewIterator(leveldb::ReadOptions()));
+    for (group_iter->Seek(kOldRecordPrefix);
+         group_iter->Valid() && group_iter->key().starts_with(kOldRecordPrefix);
+         group_iter->Next()) {
+      protobuf::GroupDbGroup proto_group;
+      if (!proto_group.ParseFromString(group_iter->value().ToString()))
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+      const std::string kOldPrefix(
+          detail::ToFixedWidthString(proto_group.group_id(), old_prefix_width));
+      const GroupId kNewGroupId(group_ids.Allocate());
+      const std::string kNewPrefix(detail::ToFixedWidthString(kNewGroupId, kPrefixWidth_));
+      leveldb::WriteBatch batch;
+      for (entry_iter->Seek(kOldPrefix);
+           entry_iter->Valid() && entry_iter->key().starts_with(kOldPrefix); entry_iter->Next()) {
+        batch.Put(kNewPrefix + entry_iter->key().ToString().substr(old_prefix_width),
+                  entry_iter->value());
+      }
+      proto_group.set_group_id(kNewGroupId);
+      batch.Put(std::string(kPrefixWidth_, '\0') +
+                    group_iter->key().ToString().substr(old_prefix_width),
+                proto_group.SerializeAsString());
+      if (!migrated_db->Write(leveldb::WriteOptions(), &batch).ok())
+        BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+    }
+    WriteFormatRecord(*migrated_db);
+  }
+  leveldb_.reset();
+  boost::filesystem::remove_all(kDbPath_);
+  boost::filesystem::rename(migration_path, kDbPath_);
+  leveldb_ = OpenLevelDb(kDbPath_);
+}
+
+template <typename Persona>
+void GroupDb<Persona>::LoadGroups() {
+  const std::string kRecordPrefix(kPrefixWidth_, '\0');
+  std::unique_ptr<leveldb::Iterator> iter(leveldb_->NewIterator(leveldb::ReadOptions()));
+  for (iter->Seek(kRecordPrefix); iter->Valid() && iter->key().starts_with(kRecordPrefix);
+       iter->Next()) {
+    protobuf::GroupDbGroup proto_group;
+    if (!proto_group.ParseFromString(iter->value().ToString()))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    GroupName group_name(Identity(iter->key().ToString().substr(kPrefixWidth_)));
+    group_ids_.Reserve(proto_group.group_id());
+    group_map_.insert(std::make_pair(group_name, std::make_pair(proto_group.group_id(),
+                          Metadata(proto_group.serialised_metadata()))));
+  }
+  recovered_ = !group_map_.empty();
+  LOG(kInfo) << "GroupDb loaded " << group_map_.size() << " groups from " << kDbPath_;
+}
+
+template <typename Persona>
+void GroupDb<Persona>::WriteFormatRecord(leveldb::DB& db) const {
+  protobuf::GroupDbFormat format;
+  format.set_version(kFormatVersion_);
+  format.set_prefix_width(kPrefixWidth_);
+  leveldb::WriteOptions write_options;
+  write_options.sync = true;
+  if (!db.Put(write_options, "", format.SerializeAsString()).ok())
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+}
+
+template <typename Persona>
+std::string GroupDb<Persona>::MakeGroupRecordKey(const GroupName& group_name) const {
+  return std::string(kPrefixWidth_, '\0') + group_name->string();
+}
+
+template <typename Persona>
+void GroupDb<Persona>::AddGroupRecord(leveldb::WriteBatch& batch,
+                                      typename GroupMap::const_iterator it) const {
+  AddGroupRecord(batch, it->first, it->second.first, it->second.second);
+}
+
+// No-op unless durable
+template <typename Persona>
+void GroupDb<Persona>::AddGroupRecord(leveldb::WriteBatch& batch, const GroupName& group_name,
+                                      GroupId group_id, const Metadata& metadata) const {
+  if (!kDurable_)
+    return;
+  protobuf::GroupDbGroup proto_group;
+  proto_group.set_group_id(group_id);
+  proto_group.set_serialised_metadata(metadata.Serialise());
+  batch.Put(MakeGroupRecordKey(group_name), proto_group.SerializeAsString());
+}
+
+template <typename Persona>
+void GroupDb<Persona>::WriteGroupRecord(typename GroupMap::const_iterator it) {
+  if (!kDurable_)
+    return;
+  leveldb::WriteBatch batch;
+  AddGroupRecord(batch, it);
+  Write(batch);
+}
+
+template <typename Persona>
+void GroupDb<Persona>::Write(leveldb::WriteBatch& batch) {
+  leveldb::Status status(leveldb_->Write(leveldb::WriteOptions(), &batch));
+  if (!status.ok()) {
+    LOG(kError) << "GroupDb<Persona>::Write failed : " << status.ToString();
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+  }
+}
+
 template <typename Persona>
 void GroupDb<Persona>::AddGroup(const GroupName& group_name, const Metadata& metadata) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  auto lock(mutexes_.LockName(group_name->string()));
   AddGroupToMap(group_name, metadata);
 }
 
 template <typename Persona>
 typename GroupDb<Persona>::GroupMap::iterator GroupDb<Persona>::AddGroupToMap(
     const GroupName& group_name, const Metadata& metadata) {
-  static const uint64_t kGroupsLimit(static_cast<GroupId>(std::pow(256, kPrefixWidth_)));
-  if (group_map_.size() == kGroupsLimit - 1)
-    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
-  GroupId group_id(RandomInt32() % kGroupsLimit);
-  while (std::any_of(std::begin(group_map_), std::end(group_map_),
-                     [&group_id](const std::pair<GroupName, std::pair<GroupId, Metadata>>&
-                                 element) { return group_id == element.second.first; })) {
-    group_id = RandomInt32() % kGroupsLimit;
+  std::lock_guard<std::mutex> lock(group_map_mutex_);
+  if (group_map_.count(group_name) != 0U) {
+    LOG(kError) << "account already exists in the group map";
+    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::account_already_exists));
   }
+  GroupId group_id(group_ids_.Allocate());
   LOG(kVerbose) << "GroupDb<Persona>::AddGroupToMap size of group_map_ " << group_map_.size()
                 << " current group_name " << HexSubstr(group_name->string());
   auto ret_val = group_map_.insert(std::make_pair(group_name, std::make_pair(group_id, metadata)));
-  if (!ret_val.second) {
-    LOG(kError) << "account already exists in the group map";
-    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::account_already_exists));
+  assert(ret_val.second);
+  try {
+    WriteGroupRecord(ret_val.first);
+  } catch (const maidsafe_error&) {
+    group_map_.erase(ret_val.first);
+    group_ids_.Release(group_id);
+    throw;
   }
   LOG(kInfo) << "group inserting succeeded for group_name "
              << HexSubstr(group_name->string());
@@ -192,7 +428,7 @@ typename GroupDb<Persona>::GroupMap::iterator GroupDb<Persona>::AddGroupToMap(
 
 template <typename Persona>
 void GroupDb<Persona>::DeleteGroup(const GroupName& group_name) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  auto lock(mutexes_.LockName(group_name->string()));
   DeleteGroupEntries(group_name);
 }
 
@@ -202,10 +438,17 @@ void GroupDb<Persona>::Commit(const GroupName& group_name,
   LOG(kVerbose) << "GroupDb<Persona>::Commit update metadata for account "
                 << HexSubstr(group_name->string());
   assert(functor);
-  std::lock_guard<std::mutex> lock(mutex_);
+  auto lock(mutexes_.LockName(group_name->string()));
   const auto it(FindOrCreateGroup(group_name));
   on_scope_exit update_group([it, this]() { UpdateGroup(it); });
-  functor(it->second.second);
+  // The functor works on a copy, which only replaces the cached metadata once written
+  Metadata metadata(it->second.second);
+  functor(metadata);
+  leveldb::WriteBatch batch;
+  AddGroupRecord(batch, it->first, it->second.first, metadata);
+  if (kDurable_)
+    Write(batch);
+  it->second.second = metadata;
 }
 
 template <typename Persona>
@@ -215,30 +458,44 @@ std::unique_ptr<typename Persona::Value> GroupDb<Persona>::Commit(
   LOG(kVerbose) << "GroupDb<Persona>::Commit update metadata and value for account "
                 << HexSubstr(key.group_name()->string());
   assert(functor);
-  std::lock_guard<std::mutex> lock(mutex_);
+  auto lock(mutexes_.LockName(key.group_name()->string()));
   const auto it(FindOrCreateGroup(key.group_name()));
   on_scope_exit update_group([it, this]() { UpdateGroup(it); });
-  std::unique_ptr<Value> value;
-  try {
-    value.reset(new Value(Get(key, it->second.first)));
-  } catch (const maidsafe_error& error) {
-    LOG(kError) << "GroupDb<Persona>::Commit encountered error "
-                << boost::diagnostic_information(error);
-    if (error.code() != make_error_code(CommonErrors::no_such_element))
-      throw error;  // throw only for db errors
+  const auto db_key(MakeLevelDbKey(it->second.first, key));
+  // The cached value is taken out of the cache and only re-inserted once successfully written
+  std::unique_ptr<Value> value(value_cache_.Take(db_key));
+  if (!value) {
+    try {
+      value = Read(db_key);
+    } catch (const maidsafe_error& error) {
+      LOG(kError) << "GroupDb<Persona>::Commit encountered error "
+                  << boost::diagnostic_information(error);
+      if (error.code() != make_error_code(CommonErrors::no_such_element))
+        throw error;  // throw only for db errors
+    }
   }
 
   try {
-    if (detail::DbAction::kPut == functor(it->second.second, value)) {
+    // The value and the group's updated metadata are written together
+    leveldb::WriteBatch batch;
+    Metadata metadata(it->second.second);
+    if (detail::DbAction::kPut == functor(metadata, value)) {
       LOG(kInfo) << "detail::DbAction::kPut";
       assert(value);
       if (!value)
         BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
-      Put(std::make_pair(key, std::move(*value)), it->second.first);
+      batch.Put(db_key.slice(), value->Serialise());
+      AddGroupRecord(batch, it->first, it->second.first, metadata);
+      Write(batch);
+      it->second.second = metadata;
+      value_cache_.Insert(db_key, std::move(value));
     } else {
       LOG(kInfo) << "detail::DbAction::kDelete";
       if (value) {
-        Delete(key, it->second.first);
+        batch.Delete(db_key.slice());
+        AddGroupRecord(batch, it->first, it->second.first, metadata);
+        Write(batch);
+        it->second.second = metadata;
         return value;
       } else {
         LOG(kError) << "value is not initialised";
@@ -254,22 +511,22 @@ std::unique_ptr<typename Persona::Value> GroupDb<Persona>::Commit(
 
 template <typename Persona>
 typename GroupDb<Persona>::Contents GroupDb<Persona>::GetContents(const GroupName& group_name) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  auto lock(mutexes_.LockName(group_name->string()));
   auto it(FindGroup(group_name));
   return GetContents(it);
 }
 
 template <typename Persona>
-typename GroupDb<Persona>::Contents GroupDb<Persona>::GetContents(typename GroupMap::iterator it) {
+typename GroupDb<Persona>::Contents GroupDb<Persona>::GetContents(
+    typename GroupMap::const_iterator it, const leveldb::ReadOptions& read_options) {
   Contents contents;
   contents.group_name = it->first;
   contents.metadata = it->second.second;
   // get db entry
-  std::unique_ptr<leveldb::Iterator> iter(leveldb_->NewIterator(leveldb::ReadOptions()));
+  std::unique_ptr<leveldb::Iterator> iter(leveldb_->NewIterator(read_options));
   const auto group_id = it->second.first;
-  const auto group_id_str = detail::ToFixedWidthString<kPrefixWidth_>(group_id);
-  for (iter->Seek(group_id_str); (iter->Valid() && (GetGroupId(iter->key()) == group_id));
-       iter->Next()) {
+  for (iter->Seek(MakeGroupPrefix(group_id).slice());
+       (iter->Valid() && (GetGroupId(iter->key()) == group_id)); iter->Next()) {
     contents.kv_pairs.push_back(std::make_pair(MakeKey(contents.group_name, iter->key()),
                                                Value(iter->value().ToString())));
   }
@@ -277,35 +534,88 @@ typename GroupDb<Persona>::Contents GroupDb<Persona>::GetContents(typename Group
   return contents;
 }
 
+// Sends the group's entries to 'functor' in chunks (see TransferChunks), each carrying the group's
+// name and metadata.  A group without entries is sent as a single chunk of just its metadata.
+template <typename Persona>
+void GroupDb<Persona>::GetContents(typename GroupMap::const_iterator it,
+                                   const leveldb::ReadOptions& read_options,
+                                   const NodeId& new_holder, const TransferFunctor& functor) {
+  bool sent_chunk(false);
+  auto send_chunk([&](const NodeId& holder, std::vector<KvPair>&& kv_pairs) {
+    Contents contents;
+    contents.group_name = it->first;
+    contents.metadata = it->second.second;
+    contents.kv_pairs = std::move(kv_pairs);
+    sent_chunk = true;
+    functor(holder, std::move(contents));
+  });
+  detail::TransferChunks<KvPair> chunks(kMaxTransferChunkBytes_, send_chunk);
+  std::unique_ptr<leveldb::Iterator> iter(leveldb_->NewIterator(read_options));
+  const auto group_id = it->second.first;
+  for (iter->Seek(MakeGroupPrefix(group_id).slice());
+       (iter->Valid() && (GetGroupId(iter->key()) == group_id)); iter->Next()) {
+    // The key without its group id prefix is the same on every holder
+    chunks.Add(new_holder, leveldb::Slice(iter->key().data() + kPrefixWidth_,
+                                          iter->key().size() - kPrefixWidth_),
+               std::make_pair(MakeKey(it->first, iter->key()), Value(iter->value().ToString())),
+               iter->key().size() + iter->value().size());
+  }
+  iter.reset();
+  chunks.Flush();
+  if (!sent_chunk)
+    send_chunk(new_holder, std::vector<KvPair>());
+}
+
 template <typename Persona>
 typename GroupDb<Persona>::TransferInfo GroupDb<Persona>::GetTransferInfo(
     std::shared_ptr<routing::MatrixChange> matrix_change) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  std::vector<GroupName> prune_vector;
   TransferInfo transfer_info;
-  LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo group_map_.size() " << group_map_.size();
-  for (auto group_itr(group_map_.begin()); group_itr != group_map_.end(); ++group_itr) {
+  GetTransferInfo(matrix_change, [&](const NodeId& new_holder, Contents&& contents) {
+    transfer_info[new_holder].push_back(std::move(contents));
+  });
+  return transfer_info;
+}
+
+// Works on a copy of the groups in the ranges the churn event can affect and a leveldb snapshot,
+// both taken while briefly holding every lock, so a consistent view is scanned without blocking
+// other operations.
+template <typename Persona>
+void GroupDb<Persona>::GetTransferInfo(std::shared_ptr<routing::MatrixChange> matrix_change,
+                                       const TransferFunctor& functor) {
+  assert(functor);
+  if (!matrix_change)
+    return;
+  auto ranges(churn_ranges_.Update(matrix_change->new_nodes(), matrix_change->lost_nodes(),
+                                   recovered_));
+  GroupMap group_map;
+  leveldb::ReadOptions read_options;
+  {
+    auto locks(mutexes_.LockAll());
+    std::lock_guard<std::mutex> lock(group_map_mutex_);
+    for (const auto& range : ranges) {
+      for (auto itr(group_map_.lower_bound(GroupName(Identity(range.first))));
+           itr != group_map_.end() && itr->first->string() <= range.second; ++itr) {
+        group_map.insert(group_map.end(), *itr);
+      }
+    }
+    read_options.snapshot = leveldb_->GetSnapshot();
+  }
+  on_scope_exit release_snapshot([&]() { leveldb_->ReleaseSnapshot(read_options.snapshot); });
+  std::vector<GroupName> prune_vector;
+  LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo group_map.size() " << group_map.size();
+  for (auto group_itr(group_map.cbegin()); group_itr != group_map.cend(); ++group_itr) {
     auto check_holder_result = matrix_change->CheckHolders(NodeId(group_itr->first->string()));
     if (check_holder_result.proximity_status == routing::GroupRangeStatus::kInRange) {
       LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo in range ";
       if (check_holder_result.new_holders.size() != 0) {
-        LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo having new node "
-                      << DebugId(check_holder_result.new_holders.at(0));
 //         assert(check_holder_result.new_holders.size() == 1);
         if (check_holder_result.new_holders.size() != 1)
           LOG(kError) << "having " << check_holder_result.new_holders.size()
                       << " new holders, only the first one got processed";
-        auto found_itr = transfer_info.find(check_holder_result.new_holders.at(0));
-        if (found_itr != transfer_info.end()) {  // Add to map
-          found_itr->second.push_back(GetContents(group_itr));
-        } else {  // create contents add to map
-          LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo transfering account "
-                        << HexSubstr(group_itr->first->string()) << " to "
-                        << DebugId(check_holder_result.new_holders.at(0));
-          std::vector<Contents>  contents_vector;
-          contents_vector.push_back(std::move(GetContents(group_itr)));
-          transfer_info[check_holder_result.new_holders.at(0)] = std::move(contents_vector);
-        }
+        LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo transfering account "
+                      << HexSubstr(group_itr->first->string()) << " to "
+                      << DebugId(check_holder_result.new_holders.at(0));
+        GetContents(group_itr, read_options, check_holder_result.new_holders.at(0), functor);
       }
     } else {  // Prune group
       VLOG(VisualiserAction::kRemoveAccount, Identity{ group_itr->first->string() });
@@ -314,14 +624,14 @@ typename GroupDb<Persona>::TransferInfo GroupDb<Persona>::GetTransferInfo(
   }
   LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo prune_vector.size() " << prune_vector.size();
   for (const auto& i : prune_vector)
-    DeleteGroupEntries(i);
-  return transfer_info;
+    DeleteGroup(i);
+  recovered_ = false;
 }
 
 // FIXME (Prakash)
 template <typename Persona>
 void GroupDb<Persona>::HandleTransfer(const Contents& content) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  auto lock(mutexes_.LockName(content.group_name->string()));
   ApplyTransfer(content);
 }
 
@@ -343,7 +653,7 @@ void GroupDb<Persona>::ApplyTransfer(const Contents& contents) {
   }
   for (const auto& kv_pair : contents.kv_pairs) {
     try {
-      Put(kv_pair, itr->second.first);
+      Put(MakeLevelDbKey(itr->second.first, kv_pair.first), kv_pair.second);
     } catch(...) {
       LOG(kError) << "trying to re-insert an existing entry";
     }
@@ -352,7 +662,7 @@ void GroupDb<Persona>::ApplyTransfer(const Contents& contents) {
 
 template <typename Persona>
 typename GroupDb<Persona>::Metadata GroupDb<Persona>::GetMetadata(const GroupName& group_name) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  auto lock(mutexes_.LockName(group_name->string()));
   auto it(FindGroup(group_name));
   return it->second.second;
 }
@@ -360,9 +670,9 @@ typename GroupDb<Persona>::Metadata GroupDb<Persona>::GetMetadata(const GroupNam
 
 template <typename Persona>
 typename GroupDb<Persona>::Value GroupDb<Persona>::GetValue(const Key& key) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  auto lock(mutexes_.LockName(key.group_name()->string()));
   auto it(FindGroup(key.group_name()));
-  return Get(key, it->second.first);
+  return Get(MakeLevelDbKey(it->second.first, key));
 }
 
 template <typename Persona>
@@ -379,37 +689,94 @@ void GroupDb<Persona>::DeleteGroupEntries(const GroupName& group_name) {
 template <typename Persona>
 void GroupDb<Persona>::DeleteGroupEntries(typename GroupMap::iterator it) {
   assert(it != group_map_.end());
-  std::vector<std::string> group_db_keys;
   const auto group_id = it->second.first;
-  const auto group_id_str = detail::ToFixedWidthString<kPrefixWidth_>(group_id);
+  // The entries and the group record are deleted together
+  leveldb::WriteBatch batch;
   std::unique_ptr<leveldb::Iterator> iter(leveldb_->NewIterator(leveldb::ReadOptions()));
-  for (iter->Seek(group_id_str);
+  for (iter->Seek(MakeGroupPrefix(group_id).slice());
        (iter->Valid() && (GetGroupId(iter->key()) == group_id));
-       iter->Next())
-    group_db_keys.push_back(iter->key().ToString());
-
+       iter->Next()) {
+    if (value_cache_.enabled()) {
+      detail::FixedWidthKey db_key;
+      db_key.Append(iter->key().data(), iter->key().size());
+      value_cache_.Erase(db_key);
+    }
+    batch.Delete(iter->key());
+  }
   iter.reset();
+  if (kDurable_)
+    batch.Delete(MakeGroupRecordKey(it->first));
+  Write(batch);
+  {
+    std::lock_guard<std::mutex> lock(group_map_mutex_);
+    group_map_.erase(it);
+    group_ids_.Release(group_id);
+  }
+  ScheduleCompaction(group_id);
+}
 
-  for (const auto& key : group_db_keys) {
-    leveldb::Status status(leveldb_->Delete(leveldb::WriteOptions(), key));
-    if (!status.ok())
-      BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+template <typename Persona>
+void GroupDb<Persona>::ScheduleCompaction(GroupId group_id) {
+  std::lock_guard<std::mutex> lock(compaction_mutex_);
+  bool compaction_pending(!pending_compactions_.empty());
+  pending_compactions_.insert(group_id);
+  if (!compaction_pending)
+    compactor_->Send([this] { CompactPendingGroups(); });
+}
+
+// Compacts each run of consecutive pending group ids as a single range
+template <typename Persona>
+void GroupDb<Persona>::CompactPendingGroups() {
+  std::set<GroupId> group_ids;
+  {
+    std::lock_guard<std::mutex> lock(compaction_mutex_);
+    group_ids.swap(pending_compactions_);
+  }
+  const uint64_t kGroupIdLimit(static_cast<uint64_t>(1) << (8 * kPrefixWidth_));
+  auto itr(std::begin(group_ids));
+  while (itr != std::end(group_ids)) {
+    const GroupId kFirst(*itr);
+    GroupId last(*itr);
+    while (++itr != std::end(group_ids) && *itr == last + 1)
+      ++last;
+    const auto kBegin(MakeGroupPrefix(kFirst));
+    const leveldb::Slice kBeginSlice(kBegin.slice());
+    if (static_cast<uint64_t>(last) + 1 == kGroupIdLimit) {
+      leveldb_->CompactRange(&kBeginSlice, nullptr);
+    } else {
+      const auto kEnd(MakeGroupPrefix(last + 1));
+      const leveldb::Slice kEndSlice(kEnd.slice());
+      leveldb_->CompactRange(&kBeginSlice, &kEndSlice);
+    }
   }
-  group_map_.erase(it);
-  leveldb_->CompactRange(nullptr, nullptr);
+  LOG(kVerbose) << "GroupDb<Persona>::CompactPendingGroups compacted " << group_ids.size()
+                << " groups";
 }
 
 // throws
 template <typename Persona>
-typename GroupDb<Persona>::Value GroupDb<Persona>::Get(const Key& key, const GroupId& group_id) {
+typename GroupDb<Persona>::Value GroupDb<Persona>::Get(const detail::FixedWidthKey& db_key) {
+  auto cached_value(value_cache_.Get(db_key));
+  if (cached_value)
+    return std::move(*cached_value);
+  auto value(Read(db_key));
+  Value result(std::move(*value));
+  if (value_cache_.enabled())
+    value_cache_.Insert(db_key, std::unique_ptr<Value>(new Value(result.Serialise())));
+  return result;
+}
+
+// throws, bypasses the cache
+template <typename Persona>
+std::unique_ptr<typename Persona::Value> GroupDb<Persona>::Read(
+    const detail::FixedWidthKey& db_key) {
   leveldb::ReadOptions read_options;
   read_options.verify_checksums = true;
   std::string value_string;
-  leveldb::Status status(
-              leveldb_->Get(read_options, MakeLevelDbKey(group_id, key), &value_string));
+  leveldb::Status status(leveldb_->Get(read_options, db_key.slice(), &value_string));
   if (status.ok()) {
     assert(!value_string.empty());
-    return Value(value_string);
+    return std::unique_ptr<Value>(new Value(value_string));
   } else if (status.IsNotFound()) {
     LOG(kWarning) << "cann't find such element for get, throwing error";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
@@ -419,44 +786,49 @@ typename GroupDb<Persona>::Value GroupDb<Persona>::Get(const Key& key, const Gro
 }
 
 template <typename Persona>
-void GroupDb<Persona>::Put(const KvPair& key_value_pair, const GroupId& group_id) {
-  leveldb::Status status(leveldb_->Put(leveldb::WriteOptions(),
-                                       MakeLevelDbKey(group_id, key_value_pair.first),
-                                       key_value_pair.second.Serialise()));
+void GroupDb<Persona>::Put(const detail::FixedWidthKey& db_key, const Value& value) {
+  value_cache_.Erase(db_key);
+  leveldb::Status status(leveldb_->Put(leveldb::WriteOptions(), db_key.slice(), value.Serialise()));
   if (!status.ok())
     BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
 }
 
 template <typename Persona>
-void GroupDb<Persona>::Delete(const Key& key, const GroupId& group_id) {
-  leveldb::Status status(
-      leveldb_->Delete(leveldb::WriteOptions(), MakeLevelDbKey(group_id, key)));
-  if (!status.ok())
-    BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+detail::FixedWidthKey GroupDb<Persona>::MakeLevelDbKey(const GroupId& group_id,
+                                                       const Key& key) const {
+  auto db_key(MakeGroupPrefix(group_id));
+  key.AppendTo(db_key);
+  return db_key;
 }
 
 template <typename Persona>
-std::string GroupDb<Persona>::MakeLevelDbKey(const GroupId& group_id, const Key& key) {
-  return detail::ToFixedWidthString<kPrefixWidth_>(group_id) + key.ToFixedWidthString().string();
+detail::FixedWidthKey GroupDb<Persona>::MakeGroupPrefix(const GroupId& group_id) const {
+  detail::FixedWidthKey prefix;
+  prefix.AppendNumber(group_id, kPrefixWidth_);
+  return prefix;
 }
 
 template <typename Persona>
 typename Persona::Key GroupDb<Persona>::MakeKey(const GroupName group_name,
                                                 const leveldb::Slice& level_db_key) {
-  return Key(group_name, typename Persona::Key::FixedWidthString(
-                 (level_db_key.ToString()).substr(kPrefixWidth_)));
+  assert(level_db_key.size() >= static_cast<size_t>(kPrefixWidth_));
+  return Key(group_name, leveldb::Slice(level_db_key.data() + kPrefixWidth_,
+                                        level_db_key.size() - kPrefixWidth_));
 }
 
+// Keys too short to carry a group id are reported as belonging to the reserved group 0
 template <typename Persona>
 uint32_t GroupDb<Persona>::GetGroupId(const leveldb::Slice& level_db_key) const {
-  return detail::FromFixedWidthString<kPrefixWidth_>(
-      (level_db_key.ToString()).substr(0, kPrefixWidth_));
+  if (level_db_key.size() < static_cast<size_t>(kPrefixWidth_))
+    return 0;
+  return detail::ReadFixedWidth(level_db_key.data(), kPrefixWidth_);
 }
 
 // throws
 template <typename Persona>
 typename GroupDb<Persona>::GroupMap::iterator GroupDb<Persona>::FindGroup(
     const GroupName& group_name) {
+  std::lock_guard<std::mutex> lock(group_map_mutex_);
   auto it(group_map_.find(group_name));
   if (it == group_map_.end())
     BOOST_THROW_EXCEPTION(MakeError(VaultErrors::no_such_account));
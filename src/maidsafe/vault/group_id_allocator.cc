@@ -0,0 +1,72 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/group_id_allocator.h"
+
+#include <cassert>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+GroupIdAllocator::GroupIdAllocator(int prefix_width)
+    : kLimit_(static_cast<uint64_t>(1) << (8 * prefix_width)),
+      next_unallocated_(1),
+      released_ids_(),
+      used_ids_() {
+  assert(prefix_width > 0 && prefix_width < 5);
+}
+
+uint32_t GroupIdAllocator::Allocate() {
+  while (!released_ids_.empty()) {
+    uint32_t id(released_ids_.back());
+    released_ids_.pop_back();
+    if (used_ids_.insert(id).second)
+      return id;
+  }
+  // Skips ids which have been reserved
+  while (next_unallocated_ < kLimit_) {
+    uint32_t id(static_cast<uint32_t>(next_unallocated_++));
+    if (used_ids_.insert(id).second)
+      return id;
+  }
+  LOG(kError) << "All " << kLimit_ - 1 << " group ids are in use";
+  BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
+}
+
+void GroupIdAllocator::Reserve(uint32_t id) {
+  assert(id != 0 && id < kLimit_);
+  used_ids_.insert(id);
+}
+
+void GroupIdAllocator::Release(uint32_t id) {
+  if (used_ids_.erase(id) != 0U)
+    released_ids_.push_back(id);
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
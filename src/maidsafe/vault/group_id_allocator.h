@@ -0,0 +1,61 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_GROUP_ID_ALLOCATOR_H_
+#define MAIDSAFE_VAULT_GROUP_ID_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Allocates the ids GroupDb uses as key prefixes, from [1, 256 ^ prefix_width).  Id 0 is never
+// allocated, leaving its range free for the db's own records.  Released ids are reused before
+// fresh ones, and allocation and release are O(1) amortised.  Not thread-safe.
+class GroupIdAllocator {
+ public:
+  explicit GroupIdAllocator(int prefix_width);
+
+  // Throws if every id is in use
+  uint32_t Allocate();
+  // Marks an id already in use, e.g. one read back from disk
+  void Reserve(uint32_t id);
+  void Release(uint32_t id);
+  size_t size() const { return used_ids_.size(); }
+
+ private:
+  const uint64_t kLimit_;
+  uint64_t next_unallocated_;
+  std::vector<uint32_t> released_ids_;
+  std::unordered_set<uint32_t> used_ids_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_GROUP_ID_ALLOCATOR_H_
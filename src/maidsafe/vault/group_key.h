@@ -19,10 +19,12 @@
 #ifndef MAIDSAFE_VAULT_GROUP_KEY_H_
 #define MAIDSAFE_VAULT_GROUP_KEY_H_
 
+#include <cassert>
 #include <string>
 #include <tuple>
 
-#include "maidsafe/common/bounded_string.h"
+#include "leveldb/slice.h"
+
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/common/types.h"
@@ -59,12 +61,12 @@ struct GroupKey {
   friend class GroupDb;
 
  private:
-  typedef maidsafe::detail::BoundedString<NodeId::kSize + detail::PaddedWidth::value,
-                                          NodeId::kSize + detail::PaddedWidth::value>
-      FixedWidthString;
+  static const size_t kFixedWidthSize = NodeId::kSize + detail::PaddedWidth::value;
 
-  GroupKey(const GroupName& group_name_in, const FixedWidthString& fixed_width_string);
-  FixedWidthString ToFixedWidthString() const;
+  // Decodes a key from its fixed-width form, which excludes the group name.  Only the name is
+  // copied.
+  GroupKey(const GroupName& group_name_in, const leveldb::Slice& fixed_width_key);
+  void AppendTo(detail::FixedWidthKey& fixed_width_key) const;
 };
 
 template <typename GroupName>
@@ -91,11 +93,16 @@ GroupKey<GroupName>::GroupKey(const std::string& serialised_group_key)
 
 template <typename GroupName>
 GroupKey<GroupName>::GroupKey(const GroupName& group_name_in,
-                              const FixedWidthString& fixed_width_string)
-    : metadata_key(group_name_in),
-      name(fixed_width_string.string().substr(0, NodeId::kSize)),
-      type(static_cast<DataTagValue>(detail::FromFixedWidthString<detail::PaddedWidth::value>(
-          fixed_width_string.string().substr(NodeId::kSize)))) {}
+                              const leveldb::Slice& fixed_width_key)
+    : metadata_key(group_name_in), name(), type(DataTagValue::kMutableDataValue) {
+  if (fixed_width_key.size() != kFixedWidthSize) {
+    LOG(kError) << "GroupKey fixed-width key has wrong size " << fixed_width_key.size();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  name = Identity(std::string(fixed_width_key.data(), NodeId::kSize));
+  type = static_cast<DataTagValue>(
+      detail::ReadFixedWidth(fixed_width_key.data() + NodeId::kSize, detail::PaddedWidth::value));
+}
 
 template <typename GroupName>
 GroupKey<GroupName>::GroupKey(const GroupKey& other)
@@ -123,9 +130,10 @@ std::string GroupKey<GroupName>::Serialise() const {
 }
 
 template <typename GroupName>
-typename GroupKey<GroupName>::FixedWidthString GroupKey<GroupName>::ToFixedWidthString() const {
-  return FixedWidthString(name.string() + detail::ToFixedWidthString<detail::PaddedWidth::value>(
-                                              static_cast<uint32_t>(type)));
+void GroupKey<GroupName>::AppendTo(detail::FixedWidthKey& fixed_width_key) const {
+  assert(name.string().size() == NodeId::kSize);
+  fixed_width_key.Append(name.string().data(), NodeId::kSize);
+  fixed_width_key.AppendNumber(static_cast<uint32_t>(type), detail::PaddedWidth::value);
 }
 
 template <typename GroupName>
@@ -0,0 +1,98 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+const size_t Histogram::kSubBucketBits_;
+const size_t Histogram::kSubBucketCount_;
+const size_t Histogram::kMaxExponent_;
+const size_t Histogram::kBucketCount_;
+
+Histogram::Histogram()
+    : counts_(), count_(0), min_(std::numeric_limits<uint64_t>::max()), max_(0), sum_(0.0) {
+  counts_.fill(0);
+}
+
+void Histogram::Record(uint64_t value) {
+  ++counts_[BucketIndex(value)];
+  ++count_;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  sum_ += static_cast<double>(value);
+}
+
+double Histogram::Mean() const {
+  return count_ == 0 ? 0.0 : sum_ / static_cast<double>(count_);
+}
+
+uint64_t Histogram::ValueAtPercentile(double percentile) const {
+  if (count_ == 0)
+    return 0;
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  auto wanted(static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count_))));
+  wanted = std::max(wanted, static_cast<uint64_t>(1));
+  uint64_t counted(0);
+  for (size_t index(0); index != kBucketCount_; ++index) {
+    counted += counts_[index];
+    // The top bucket also holds values beyond its bound
+    if (counted >= wanted)
+      return index == kBucketCount_ - 1 ? max_ : std::min(BucketUpperBound(index), max_);
+  }
+  return max_;
+}
+
+// Values below kSubBucketCount_ have a bucket each.  Above that, a value with its highest set bit
+// at 'exponent' falls in the row of kSubBucketCount_ buckets for that exponent, picked by the
+// kSubBucketBits_ bits below its highest.
+size_t Histogram::BucketIndex(uint64_t value) {
+  if (value < kSubBucketCount_)
+    return static_cast<size_t>(value);
+  size_t exponent(kSubBucketBits_);
+  while (exponent < kMaxExponent_ && (value >> (exponent + 1)) != 0)
+    ++exponent;
+  if ((value >> (exponent + 1)) != 0)
+    return kBucketCount_ - 1;
+  size_t shift(exponent - kSubBucketBits_);
+  size_t sub_bucket(static_cast<size_t>(value >> shift) & (kSubBucketCount_ - 1));
+  return kSubBucketCount_ * (shift + 1) + sub_bucket;
+}
+
+uint64_t Histogram::BucketUpperBound(size_t index) {
+  if (index < kSubBucketCount_)
+    return index;
+  size_t shift(index / kSubBucketCount_ - 1);
+  uint64_t lower((static_cast<uint64_t>(kSubBucketCount_ + index % kSubBucketCount_)) << shift);
+  return lower + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,79 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_HISTOGRAM_H_
+#define MAIDSAFE_VAULT_HISTOGRAM_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Log-linear histogram of non-negative values, in the manner of an HdrHistogram.  Values below 16
+// are counted exactly; larger ones fall in buckets each a sixteenth of their power of two wide, so
+// a reported value is within about 6% of a recorded one.  Values of 2^41 and above are counted in
+// the top bucket.  Copy a histogram to take a snapshot of it.
+class Histogram {
+ public:
+  Histogram();
+
+  void Record(uint64_t value);
+  // Durations are recorded in microseconds
+  template <typename Rep, typename Period>
+  void Record(std::chrono::duration<Rep, Period> duration) {
+    auto microseconds(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    Record(static_cast<uint64_t>(microseconds < 0 ? 0 : microseconds));
+  }
+
+  uint64_t Count() const { return count_; }
+  uint64_t Min() const { return count_ == 0 ? 0 : min_; }
+  uint64_t Max() const { return max_; }
+  double Mean() const;
+  // Returns the value at or below which 'percentile' percent of the recorded values lie, rounded up
+  // to the top of its bucket.  'percentile' is clamped to [0, 100].
+  uint64_t ValueAtPercentile(double percentile) const;
+
+ private:
+  static const size_t kSubBucketBits_ = 4;
+  static const size_t kSubBucketCount_ = size_t(1) << kSubBucketBits_;
+  static const size_t kMaxExponent_ = 40;
+  static const size_t kBucketCount_ =
+      kSubBucketCount_ * (kMaxExponent_ - kSubBucketBits_ + 2);
+
+  static size_t BucketIndex(uint64_t value);
+  static uint64_t BucketUpperBound(size_t index);
+
+  std::array<uint64_t, kBucketCount_> counts_;
+  uint64_t count_, min_, max_;
+  double sum_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_HISTOGRAM_H_
@@ -0,0 +1,117 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/ingestion_queue.h"
+
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/vault/parameters.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+namespace {
+
+// Used in queued mode only, where the drainer may be running other producers' tasks
+IngestionQueue::Continuation RunTask(const IngestionQueue::Task& task) {
+  try {
+    return task();
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "Ingestion task failed: " << e.what();
+  }
+  return IngestionQueue::Continuation();
+}
+
+void RunContinuation(const IngestionQueue::Continuation& continuation) {
+  if (!continuation)
+    return;
+  try {
+    continuation();
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "Ingestion continuation failed: " << e.what();
+  }
+}
+
+}  // unnamed namespace
+
+IngestionQueue::IngestionQueue()
+    : IngestionQueue(Parameters::queued_ingestion, Parameters::ingestion_batch_size) {}
+
+IngestionQueue::IngestionQueue(bool queued, size_t max_batch_size)
+    : kQueued_(queued),
+      kMaxBatchSize_(max_batch_size == 0 ? 1 : max_batch_size),
+      mutex_(),
+      tasks_(),
+      pending_count_(0),
+      draining_(false) {}
+
+void IngestionQueue::Run(Task task) {
+  if (!kQueued_) {
+    Continuation continuation;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      continuation = task();
+    }
+    if (continuation)
+      continuation();
+    return;
+  }
+
+  pending_count_.fetch_add(1);
+  tasks_.Push(std::move(task));
+  Drain();
+}
+
+// A task pushed while another thread is draining is either popped by that thread, or seen in
+// pending_count_ once it has released draining_, so it's never left in the queue unattended.  Since
+// the count is raised before the push, it can briefly exceed the number of poppable tasks.
+void IngestionQueue::Drain() {
+  std::vector<Continuation> continuations;
+  while (pending_count_.load() != 0 && !draining_.exchange(true)) {
+    Task task;
+    while (continuations.size() < kMaxBatchSize_ && pending_count_.load() != 0) {
+      if (!tasks_.TryPop(task)) {
+        // A push is part way through linking its node
+        std::this_thread::yield();
+        continue;
+      }
+      pending_count_.fetch_sub(1);
+      continuations.push_back(RunTask(task));
+    }
+    draining_.store(false);
+    for (const auto& continuation : continuations)
+      RunContinuation(continuation);
+    continuations.clear();
+  }
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
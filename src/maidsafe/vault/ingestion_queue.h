@@ -0,0 +1,134 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_INGESTION_QUEUE_H_
+#define MAIDSAFE_VAULT_INGESTION_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Unbounded multi-producer, single-consumer queue.  Push never blocks or takes a lock; TryPop must
+// only be called by one thread at a time, and can fail while a push which began before it is still
+// linking its node.  T must be default-constructible.
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(new Node), tail_(head_.load()) {}
+
+  ~MpscQueue() {
+    while (tail_) {
+      Node* next(tail_->next.load(std::memory_order_relaxed));
+      delete tail_;
+      tail_ = next;
+    }
+  }
+
+  void Push(T value) {
+    Node* node(new Node(std::move(value)));
+    Node* previous(head_.exchange(node, std::memory_order_acq_rel));
+    previous->next.store(node, std::memory_order_seq_cst);
+  }
+
+  bool TryPop(T& value) {
+    Node* next(tail_->next.load(std::memory_order_acquire));
+    if (!next)
+      return false;
+    value = std::move(next->value);
+    delete tail_;
+    tail_ = next;
+    return true;
+  }
+
+ private:
+  MpscQueue(const MpscQueue&);
+  MpscQueue& operator=(const MpscQueue&);
+  MpscQueue(MpscQueue&&);
+  MpscQueue& operator=(MpscQueue&&);
+
+  // The node at tail_ is a sentinel whose value has already been popped
+  struct Node {
+    Node() : value(), next(nullptr) {}
+    explicit Node(T value_in) : value(std::move(value_in)), next(nullptr) {}
+    T value;
+    std::atomic<Node*> next;
+  };
+
+  std::atomic<Node*> head_;
+  Node* tail_;
+};
+
+// Runs tasks from any number of threads one at a time, so that a task can use state such as an
+// Accumulator without locking it.  Each task returns a continuation (possibly empty) which is run
+// afterwards on the same thread, but not exclusively.
+//
+// In locked mode, Run takes a mutex around the task.  In queued mode, Run pushes the task onto an
+// MpscQueue and returns at once unless no thread is draining the queue, in which case the caller
+// becomes the drainer: it runs up to 'max_batch_size' tasks, releases the queue, runs their
+// continuations, and repeats while tasks remain.  Tasks (and so continuations) may therefore run
+// on a different thread to the one which called Run.
+//
+// In locked mode, an exception thrown by a task or its continuation propagates out of Run as
+// before.  In queued mode, the thread draining the queue is running other producers' tasks too, so
+// such an exception is logged and dropped instead.
+class IngestionQueue {
+ public:
+  typedef std::function<void()> Continuation;
+  typedef std::function<Continuation()> Task;
+
+  // Mode and batch size are taken from Parameters::queued_ingestion and
+  // Parameters::ingestion_batch_size.
+  IngestionQueue();
+  IngestionQueue(bool queued, size_t max_batch_size);
+
+  void Run(Task task);
+  bool queued() const { return kQueued_; }
+
+ private:
+  IngestionQueue(const IngestionQueue&);
+  IngestionQueue& operator=(const IngestionQueue&);
+  IngestionQueue(IngestionQueue&&);
+  IngestionQueue& operator=(IngestionQueue&&);
+
+  void Drain();
+
+  const bool kQueued_;
+  const size_t kMaxBatchSize_;
+  std::mutex mutex_;
+  MpscQueue<Task> tasks_;
+  // Count of pushed tasks not yet popped
+  std::atomic<size_t> pending_count_;
+  std::atomic<bool> draining_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_INGESTION_QUEUE_H_
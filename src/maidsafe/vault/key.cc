@@ -18,6 +18,7 @@
 
 #include "maidsafe/vault/key.h"
 
+#include <cassert>
 #include <tuple>
 
 #include "maidsafe/common/error.h"
@@ -40,10 +41,14 @@ Key::Key(const std::string& serialised_key) : name(), type(DataTagValue::kMutabl
   type = static_cast<DataTagValue>(key_proto.type());
 }
 
-Key::Key(const FixedWidthString& fixed_width_string)
-    : name(fixed_width_string.string().substr(0, NodeId::kSize)),
-      type(static_cast<DataTagValue>(detail::FromFixedWidthString<detail::PaddedWidth::value>(
-          fixed_width_string.string().substr(NodeId::kSize)))) {}
+Key::Key(const leveldb::Slice& fixed_width_key)
+    : name(), type(DataTagValue::kMutableDataValue) {
+  if (fixed_width_key.size() != kFixedWidthSize)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  name = Identity(std::string(fixed_width_key.data(), NodeId::kSize));
+  type = static_cast<DataTagValue>(
+      detail::ReadFixedWidth(fixed_width_key.data() + NodeId::kSize, detail::PaddedWidth::value));
+}
 
 Key::Key(const Key& other) : name(other.name), type(other.type) {}
 
@@ -63,9 +68,16 @@ std::string Key::Serialise() const {
   return key_proto.SerializeAsString();
 }
 
-Key::FixedWidthString Key::ToFixedWidthString() const {
-  return FixedWidthString(name.string() + detail::ToFixedWidthString<detail::PaddedWidth::value>(
-                                              static_cast<uint32_t>(type)));
+void Key::AppendTo(detail::FixedWidthKey& fixed_width_key) const {
+  assert(name.string().size() == NodeId::kSize);
+  fixed_width_key.Append(name.string().data(), NodeId::kSize);
+  fixed_width_key.AppendNumber(static_cast<uint32_t>(type), detail::PaddedWidth::value);
+}
+
+detail::FixedWidthKey Key::ToFixedWidthKey() const {
+  detail::FixedWidthKey fixed_width_key;
+  AppendTo(fixed_width_key);
+  return fixed_width_key;
 }
 
 void swap(Key& lhs, Key& rhs) MAIDSAFE_NOEXCEPT {
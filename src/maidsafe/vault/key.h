@@ -21,7 +21,8 @@
 
 #include <string>
 
-#include "maidsafe/common/bounded_string.h"
+#include "leveldb/slice.h"
+
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/data_types/data_type_values.h"
@@ -61,12 +62,12 @@ struct Key {
   friend class Db;
 
  private:
-  typedef maidsafe::detail::BoundedString<NodeId::kSize + detail::PaddedWidth::value,
-                                          NodeId::kSize + detail::PaddedWidth::value>
-      FixedWidthString;
+  static const size_t kFixedWidthSize = NodeId::kSize + detail::PaddedWidth::value;
 
-  explicit Key(const FixedWidthString& fixed_width_string);
-  FixedWidthString ToFixedWidthString() const;
+  // Decodes a key from its fixed-width form.  Only the name is copied.
+  explicit Key(const leveldb::Slice& fixed_width_key);
+  void AppendTo(detail::FixedWidthKey& fixed_width_key) const;
+  detail::FixedWidthKey ToFixedWidthKey() const;
 };
 
 void swap(Key& lhs, Key& rhs) MAIDSAFE_NOEXCEPT;
@@ -24,6 +24,36 @@ namespace vault {
 
 namespace detail {
 
+std::string ToFixedWidthString(uint32_t number, int width) {
+  std::string result(width, 0);
+  WriteFixedWidth(number, width, &result[0]);
+  return result;
+}
+
+uint32_t FromFixedWidthString(const std::string& number_as_string, int width) {
+  assert(static_cast<int>(number_as_string.size()) == width);
+  return ReadFixedWidth(number_as_string.data(), width);
+}
+
+void WriteFixedWidth(uint32_t number, int width, char* out) {
+  assert(width > 0 && width < 5);
+  assert(number < std::pow(256, width));
+  for (int i(0); i != width; ++i) {
+    out[width - i - 1] = static_cast<char>(number);
+    number /= 256;
+  }
+}
+
+uint32_t ReadFixedWidth(const char* in, int width) {
+  assert(width > 0 && width < 5);
+  uint32_t result(0), factor(1);
+  for (int i(0); i != width; ++i) {
+    result += (static_cast<unsigned char>(in[width - i - 1]) * factor);
+    factor *= 256;
+  }
+  return result;
+}
+
 template <>
 std::string ToFixedWidthString<1>(uint32_t number) {
   assert(number < 256);
@@ -19,11 +19,18 @@
 #ifndef MAIDSAFE_VAULT_KEY_UTILS_H_
 #define MAIDSAFE_VAULT_KEY_UTILS_H_
 
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
+#include "boost/functional/hash.hpp"
+#include "leveldb/slice.h"
+
+#include "maidsafe/common/node_id.h"
+
 namespace maidsafe {
 
 namespace vault {
@@ -60,12 +67,67 @@ uint32_t FromFixedWidthString(const std::string& number_as_string) {
   return result;
 }
 
+// Equivalents of the above for a width only known at runtime
+std::string ToFixedWidthString(uint32_t number, int width);
+
+uint32_t FromFixedWidthString(const std::string& number_as_string, int width);
+
 template <>
 std::string ToFixedWidthString<1>(uint32_t number);
 
 template <>
 uint32_t FromFixedWidthString<1>(const std::string& number_as_string);
 
+// Non-allocating equivalents of the runtime-width functions above, working on raw buffers.  'out'
+// must have room for 'width' chars and 'in' must hold at least 'width' chars.
+void WriteFixedWidth(uint32_t number, int width, char* out);
+
+uint32_t ReadFixedWidth(const char* in, int width);
+
+// Fixed-width encoding of a db key held in an inline buffer, so building one for a leveldb lookup
+// doesn't touch the heap.  It holds up to a 4-char group id prefix followed by a Key or GroupKey.
+class FixedWidthKey {
+ public:
+  static const size_t kMaxSize = 4 + NodeId::kSize + PaddedWidth::value;
+
+  FixedWidthKey() : size_(0), data_() {}
+
+  void Append(const char* data, size_t size) {
+    assert(size_ + size <= kMaxSize);
+    std::memcpy(data_.data() + size_, data, size);
+    size_ += size;
+  }
+
+  void AppendNumber(uint32_t number, int width) {
+    assert(size_ + width <= kMaxSize);
+    WriteFixedWidth(number, width, data_.data() + size_);
+    size_ += width;
+  }
+
+  const char* data() const { return data_.data(); }
+  size_t size() const { return size_; }
+  leveldb::Slice slice() const { return leveldb::Slice(data_.data(), size_); }
+  std::string string() const { return std::string(data_.data(), size_); }
+
+ private:
+  size_t size_;
+  std::array<char, kMaxSize> data_;
+};
+
+inline bool operator==(const FixedWidthKey& lhs, const FixedWidthKey& rhs) {
+  return lhs.size() == rhs.size() && std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+inline bool operator!=(const FixedWidthKey& lhs, const FixedWidthKey& rhs) {
+  return !operator==(lhs, rhs);
+}
+
+struct FixedWidthKeyHash {
+  size_t operator()(const FixedWidthKey& key) const {
+    return boost::hash_range(key.data(), key.data() + key.size());
+  }
+};
+
 }  // namespace detail
 
 }  // namespace vault
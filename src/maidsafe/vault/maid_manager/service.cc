@@ -30,6 +30,7 @@
 #include "maidsafe/passport/types.h"
 
 #include "maidsafe/vault/operation_handlers.h"
+#include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/maid_manager/action_put.h"
 #include "maidsafe/vault/maid_manager/action_update_pmid_health.h"
 #include "maidsafe/vault/maid_manager/action_reference_counts.h"
@@ -155,12 +156,13 @@ MaidManagerService::MaidManagerService(const passport::Pmid& pmid, routing::Rout
                                        const boost::filesystem::path& vault_root_dir)
     : routing_(routing),
       data_getter_(data_getter),
-      group_db_(UniqueDbPath(vault_root_dir)),
-      accumulator_mutex_(),
+      group_db_(PersonaDbPath(vault_root_dir, "maid_manager")),
+      accumulator_ingestion_(),
       mutex_(),
       nfs_accumulator_(),
       vault_accumulator_(),
       dispatcher_(routing_, pmid),
+      sync_batcher_(dispatcher_, detail::Parameters::max_sync_batch_bytes),
       sync_create_accounts_(NodeId(pmid.name()->string())),
       sync_remove_accounts_(NodeId(pmid.name()->string())),
       sync_puts_(NodeId(pmid.name()->string())),
@@ -172,7 +174,25 @@ MaidManagerService::MaidManagerService(const passport::Pmid& pmid, routing::Rout
       sync_decrement_reference_counts_(NodeId(pmid.name()->string())),
       account_transfer_(),
       pending_account_mutex_(),
-      pending_account_map_() {}
+      pending_account_map_(),
+      asio_service_(1),
+      sync_retry_timer_(asio_service_, detail::Parameters::sync_retry_check_interval,
+                        [this](std::chrono::steady_clock::time_point now) {
+                          ResendDueSyncs(now);
+                        }) {}
+
+void MaidManagerService::ResendDueSyncs(std::chrono::steady_clock::time_point now) {
+  detail::ResendDueSyncs(sync_batcher_, sync_create_accounts_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_remove_accounts_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_puts_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_deletes_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_register_pmids_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_unregister_pmids_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_update_pmid_healths_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_increment_reference_counts_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_decrement_reference_counts_, now);
+  sync_batcher_.Flush();
+}
 
 // =============== Maid Account Creation ===========================================================
 
@@ -580,43 +600,44 @@ void MaidManagerService::HandleChurnEvent(
   std::lock_guard<std::mutex> lock(mutex_);
   if (stopped_)
     return;
-  GroupDb<MaidManager>::TransferInfo transfer_info(group_db_.GetTransferInfo(matrix_change));
-  for (auto& transfer : transfer_info)
-    TransferAccount(transfer.first, transfer.second);
+  group_db_.GetTransferInfo(matrix_change,
+      [this](const NodeId& new_holder, GroupDb<MaidManager>::Contents&& contents) {
+        TransferAccount(new_holder, contents);
+      });
 }
 
 void MaidManagerService::TransferAccount(const NodeId& dest,
-    const std::vector<GroupDb<MaidManager>::Contents>& accounts) {
-  for (auto& account : accounts) {
-    // If account just received, shall not pass it out as may under a startup procedure
-    // i.e. existing MM will be seen as new_node in matrix_change
-    if (account_transfer_.CheckHandled(routing::GroupId(NodeId(account.group_name->string())))) {
-      LOG(kInfo) << "MaidManager account " << HexSubstr(account.group_name->string())
-                 << " just received";
-      continue;
-    }
-    VLOG(nfs::Persona::kMaidManager, VisualiserAction::kAccountTransfer, account.group_name,
-         Identity{ dest.string() });
-    try {
-      std::vector<std::string> actions;
-      actions.push_back(account.metadata.Serialise());
-      LOG(kVerbose) << "MaidManagerService::TransferAccount metadata serialised";
-      for (auto& kv : account.kv_pairs) {
-        protobuf::MaidManagerKeyValuePair kv_msg;
-          kv_msg.set_key(kv.first.Serialise());
-          kv_msg.set_value(kv.second.Serialise());
-          actions.push_back(kv_msg.SerializeAsString());
-      }
-      nfs::MessageId message_id(HashStringToMessageId(account.group_name->string()));
-      MaidManager::UnresolvedAccountTransfer account_transfer(
-          account.group_name, message_id, actions);
-      LOG(kVerbose) << "MaidManagerService::TransferAccount send account_transfer";
-      dispatcher_.SendAccountTransfer(dest, account.group_name,
-                                      message_id, account_transfer.Serialise());
-    } catch(...) {
-      // the normal problem is metadata hasn't been populated
-      LOG(kError) << "MaidManagerService::TransferAccount account info error";
+                                       const GroupDb<MaidManager>::Contents& account) {
+  // If account just received, shall not pass it out as may under a startup procedure
+  // i.e. existing MM will be seen as new_node in matrix_change
+  if (account_transfer_.CheckHandled(routing::GroupId(NodeId(account.group_name->string())))) {
+    LOG(kInfo) << "MaidManager account " << HexSubstr(account.group_name->string())
+               << " just received";
+    return;
+  }
+  VLOG(nfs::Persona::kMaidManager, VisualiserAction::kAccountTransfer, account.group_name,
+       Identity{ dest.string() });
+  try {
+    std::vector<std::string> actions;
+    actions.push_back(account.metadata.Serialise());
+    LOG(kVerbose) << "MaidManagerService::TransferAccount metadata serialised";
+    for (auto& kv : account.kv_pairs) {
+      protobuf::MaidManagerKeyValuePair kv_msg;
+        kv_msg.set_key(kv.first.Serialise());
+        kv_msg.set_value(kv.second.Serialise());
+        actions.push_back(kv_msg.SerializeAsString());
     }
+    // Holders send the same chunks, so a chunk's first key identifies it
+    nfs::MessageId message_id(HashStringToMessageId(account.group_name->string() +
+        (account.kv_pairs.empty() ? std::string() : account.kv_pairs.front().first.Serialise())));
+    MaidManager::UnresolvedAccountTransfer account_transfer(
+        account.group_name, message_id, actions);
+    LOG(kVerbose) << "MaidManagerService::TransferAccount send account_transfer";
+    dispatcher_.SendAccountTransfer(dest, account.group_name,
+                                    message_id, account_transfer.Serialise());
+  } catch(...) {
+    // the normal problem is metadata hasn't been populated
+    LOG(kError) << "MaidManagerService::TransferAccount account info error";
   }
 }
 
@@ -632,7 +653,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -647,7 +668,7 @@ void MaidManagerService::HandleMessage(
                             return this->ValidateSender(message, sender);
                           },
       VaultAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -662,7 +683,7 @@ void MaidManagerService::HandleMessage(
                             return this->ValidateSender(message, sender);
                           },
       VaultAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -677,7 +698,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -692,7 +713,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -707,7 +728,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -722,7 +743,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -737,7 +758,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -752,7 +773,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -767,7 +788,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -782,7 +803,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -797,7 +818,7 @@ void MaidManagerService::HandleMessage(
                             return this->ValidateSender(message, sender);
                           },
       VaultAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -812,7 +833,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -827,7 +848,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -842,7 +863,7 @@ void MaidManagerService::HandleMessage(
                             return this->ValidateSender(message, sender);
                           },
       VaultAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -857,7 +878,7 @@ void MaidManagerService::HandleMessage(
                           return this->ValidateSender(message, sender);
                         },
       NfsAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -872,7 +893,7 @@ void MaidManagerService::HandleMessage(
                             return this->ValidateSender(message, sender);
                           },
       VaultAccumulator::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 // =============== Sync ============================================================================
@@ -885,12 +906,20 @@ void MaidManagerService::HandleMessage(
     const typename SynchroniseFromMaidManagerToMaidManager::Sender& sender,
     const typename SynchroniseFromMaidManagerToMaidManager::Receiver& /*receiver*/) {
   LOG(kVerbose) << message;
-  protobuf::Sync proto_sync;
-  if (!proto_sync.ParseFromString(message.contents->data)) {
+  protobuf::SyncBatch proto_sync_batch;
+  if (!proto_sync_batch.ParseFromString(message.contents->data)) {
     LOG(kError) << "SynchroniseFromMaidManagerToMaidManager can't parse the content";
     return;
 //     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
+  detail::ApplySyncBatch(proto_sync_batch, "SynchroniseFromMaidManagerToMaidManager",
+                         [&](const protobuf::Sync& proto_sync) {
+                           HandleSync(proto_sync, sender);
+                         });
+}
+
+void MaidManagerService::HandleSync(const protobuf::Sync& proto_sync,
+                                    const routing::GroupSource& sender) {
   switch (static_cast<nfs::MessageAction>(proto_sync.action_type())) {
     case ActionMaidManagerPut::kActionId: {
       LOG(kVerbose) << "SynchroniseFromMaidManagerToMaidManager ActionMaidManagerPut";
@@ -973,7 +1002,8 @@ void MaidManagerService::HandleMessage(
       LOG(kVerbose) << "SynchroniseFromMaidManagerToMaidManager IncrementReferenceCounts";
       MaidManager::UnresolvedIncrementReferenceCounts unresolved_action(
         proto_sync.serialised_unresolved_action(), sender.sender_id, routing_.kNodeId());
-      auto resolved_action(sync_increment_reference_counts_.AddUnresolvedAction(unresolved_action));
+      auto resolved_action(
+          sync_increment_reference_counts_.AddUnresolvedAction(unresolved_action));
       if (resolved_action) {
         LOG(kInfo) << "SynchroniseFromMaidManagerToMaidManager HandleSyncedIncReferenceCounts";
         HandleSyncedIncrementReferenceCounts(std::move(resolved_action));
@@ -984,7 +1014,8 @@ void MaidManagerService::HandleMessage(
       LOG(kVerbose) << "SynchroniseFromMaidManagerToMaidManager DecrementReferenceCounts";
       MaidManager::UnresolvedDecrementReferenceCounts unresolved_action(
         proto_sync.serialised_unresolved_action(), sender.sender_id, routing_.kNodeId());
-      auto resolved_action(sync_decrement_reference_counts_.AddUnresolvedAction(unresolved_action));
+      auto resolved_action(
+          sync_decrement_reference_counts_.AddUnresolvedAction(unresolved_action));
       if (resolved_action) {
         LOG(kInfo) << "SynchroniseFromMaidManagerToMaidManager SyncedDecReferenceCounts";
         HandleSyncedDecrementReferenceCounts(std::move(resolved_action));
@@ -1117,6 +1148,22 @@ void MaidManagerService::HandleAccountTransfer(
   group_db_.HandleTransfer(content);
 }
 
+detail::ServiceStatistics MaidManagerService::GetStatistics() const {
+  detail::ServiceStatistics statistics;
+  statistics.accumulators["nfs_accumulator"] = nfs_accumulator_.GetStatistics();
+  statistics.accumulators["vault_accumulator"] = vault_accumulator_.GetStatistics();
+  statistics.syncs["create_accounts"] = sync_create_accounts_.GetStatistics();
+  statistics.syncs["remove_accounts"] = sync_remove_accounts_.GetStatistics();
+  statistics.syncs["puts"] = sync_puts_.GetStatistics();
+  statistics.syncs["deletes"] = sync_deletes_.GetStatistics();
+  statistics.syncs["register_pmids"] = sync_register_pmids_.GetStatistics();
+  statistics.syncs["unregister_pmids"] = sync_unregister_pmids_.GetStatistics();
+  statistics.syncs["update_pmid_healths"] = sync_update_pmid_healths_.GetStatistics();
+  statistics.syncs["increment_reference_counts"] = sync_increment_reference_counts_.GetStatistics();
+  statistics.syncs["decrement_reference_counts"] = sync_decrement_reference_counts_.GetStatistics();
+  return statistics;
+}
+
 }  // namespace vault
 
 }  // namespace maidsafe
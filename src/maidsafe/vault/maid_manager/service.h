@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_VAULT_MAID_MANAGER_SERVICE_H_
 #define MAIDSAFE_VAULT_MAID_MANAGER_SERVICE_H_
 
+#include <chrono>
 #include <exception>
 #include <map>
 #include <memory>
@@ -48,6 +49,7 @@
 #include "maidsafe/vault/account_transfer.h"
 #include "maidsafe/vault/accumulator.h"
 #include "maidsafe/vault/group_db.h"
+#include "maidsafe/vault/ingestion_queue.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/unresolved_action.h"
@@ -64,6 +66,9 @@
 #include "maidsafe/vault/maid_manager/maid_manager.pb.h"
 #include "maidsafe/vault/operation_visitors.h"
 #include "maidsafe/vault/sync.h"
+#include "maidsafe/vault/sync_batcher.h"
+#include "maidsafe/vault/sync_retry_timer.h"
+#include "maidsafe/vault/statistics.h"
 
 namespace maidsafe {
 
@@ -99,6 +104,9 @@ class MaidManagerService {
 
   void HandleChurnEvent(std::shared_ptr<routing::MatrixChange> matrix_change);
 
+  // Snapshot of the Accumulator and Sync statistics, safe to call from any thread
+  detail::ServiceStatistics GetStatistics() const;
+
   void Stop() {
     std::lock_guard<std::mutex> lock(mutex_);
     stopped_ = true;
@@ -219,8 +227,7 @@ class MaidManagerService {
                                 const std::string &serialised_pmid_health,
                                 maidsafe_error& return_code, nfs::MessageId message_id);
 
-  void TransferAccount(const NodeId& dest,
-                       const std::vector<GroupDb<MaidManager>::Contents>& accounts);
+  void TransferAccount(const NodeId& dest, const GroupDb<MaidManager>::Contents& account);
 
 //  MaidManagerMetadata::Status AllowPut(const MaidName& account_name, int32_t cost);
 
@@ -242,6 +249,9 @@ class MaidManagerService {
                                 std::shared_ptr<GetPmidTotalsOp> op_data);
   template <typename UnresolvedAction>
   void DoSync(const UnresolvedAction& unresolved_action);
+  // Applies one sync from a received batch
+  void HandleSync(const protobuf::Sync& proto_sync, const routing::GroupSource& sender);
+  void ResendDueSyncs(std::chrono::steady_clock::time_point now);
 
   typedef boost::mpl::vector<> InitialType;
   typedef boost::mpl::insert_range<InitialType,
@@ -299,11 +309,13 @@ class MaidManagerService {
   routing::Routing& routing_;
   nfs_client::DataGetter& data_getter_;
   GroupDb<MaidManager> group_db_;
-  std::mutex accumulator_mutex_, mutex_;
+  detail::IngestionQueue accumulator_ingestion_;
+  std::mutex mutex_;
   bool stopped_;
   NfsAccumulator nfs_accumulator_;
   VaultAccumulator vault_accumulator_;
   MaidManagerDispatcher dispatcher_;
+  detail::SyncBatcher<MaidManagerDispatcher> sync_batcher_;
   Sync<MaidManager::UnresolvedCreateAccount> sync_create_accounts_;
   Sync<MaidManager::UnresolvedRemoveAccount> sync_remove_accounts_;
   Sync<MaidManager::UnresolvedPut> sync_puts_;
@@ -317,6 +329,8 @@ class MaidManagerService {
   static const int kDefaultPaymentFactor_;
   std::mutex pending_account_mutex_;
   std::map<nfs::MessageId, MaidAccountCreationStatus> pending_account_map_;
+  AsioService asio_service_;
+  detail::SyncRetryTimer sync_retry_timer_;
 };
 
 template <typename MessageType>
@@ -625,17 +639,7 @@ void MaidManagerService::ValidatePmidRegistration(
 
 template <typename UnresolvedAction>
 void MaidManagerService::DoSync(const UnresolvedAction& unresolved_action) {
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_puts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_deletes_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_create_accounts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_remove_accounts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_register_pmids_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_unregister_pmids_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_update_pmid_healths_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_increment_reference_counts_,
-                                       unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_decrement_reference_counts_,
-                                       unresolved_action);
+  detail::SendSyncAction(sync_batcher_, unresolved_action);
 }
 
 }  // namespace vault
@@ -646,14 +646,17 @@ void OperationHandler<
     const GetPmidAccountResponseFromPmidManagerToPmidNode::Receiver& /*receiver*/) {
   if (!validate_sender(message, sender))
     return;
-  {
-    std::lock_guard<std::mutex> lock(mutex);
-    if (accumulator.CheckHandled(message))
-      return;
-    auto result(accumulator.AddPendingRequest(message, sender, checker));
+  // The responses are handled inside the task, exclusively of other users of the accumulator
+  auto& accumulator_ref(accumulator);
+  auto checker_copy(checker);
+  auto service_ptr(service);
+  ingestion.Run([=, &accumulator_ref]() -> IngestionQueue::Continuation {
+    if (accumulator_ref.CheckHandled(message))
+      return IngestionQueue::Continuation();
+    auto result(accumulator_ref.AddPendingRequest(message, sender, checker_copy));
     if (result == Accumulator<PmidNodeServiceMessages>::AddResult::kSuccess) {
       int failures(0);
-      auto responses(accumulator.Get(message, sender));
+      auto responses(accumulator_ref.Get(message, sender));
       std::vector<std::set<nfs_vault::DataName>> response_vec;
       for (const auto& response : responses) {
         auto typed_response(boost::get<GetPmidAccountResponseFromPmidManagerToPmidNode>(response));
@@ -662,11 +665,12 @@ void OperationHandler<
         else
          failures++;
       }
-      service->HandlePmidAccountResponses(response_vec, failures);
+      service_ptr->HandlePmidAccountResponses(response_vec, failures);
     } else if (result == Accumulator<PmidNodeServiceMessages>::AddResult::kFailure) {
-      service->StartUp();
+      service_ptr->StartUp();
     }
-  }
+    return IngestionQueue::Continuation();
+  });
 }
 
 template <>
@@ -23,6 +23,7 @@
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/operation_visitors.h"
 #include "maidsafe/vault/accumulator.h"
+#include "maidsafe/vault/ingestion_queue.h"
 #include "maidsafe/vault/maid_manager/service.h"
 #include "maidsafe/vault/data_manager/service.h"
 #include "maidsafe/vault/pmid_manager/service.h"
@@ -59,12 +60,13 @@ template <typename ValidateSender, typename AccumulatorType, typename Checker,
           typename ServiceHandlerType>
 struct OperationHandler {
   OperationHandler(ValidateSender validate_sender_in, AccumulatorType& accumulator_in,
-                   Checker checker_in, ServiceHandlerType* service_in, std::mutex& mutex_in)
+                   Checker checker_in, ServiceHandlerType* service_in,
+                   IngestionQueue& ingestion_in)
       : validate_sender(validate_sender_in),
         accumulator(accumulator_in),
         checker(checker_in),
         service(service_in),
-        mutex(mutex_in) {}
+        ingestion(ingestion_in) {}
 
   template <typename MessageType, typename Sender, typename Receiver>
   void operator()(const MessageType& message, const Sender& sender, const Receiver& receiver);
@@ -74,7 +76,7 @@ struct OperationHandler {
   AccumulatorType& accumulator;
   Checker checker;
   ServiceHandlerType* service;
-  std::mutex& mutex;
+  IngestionQueue& ingestion;
 };
 
 template <typename ValidateSender, typename AccumulatorType, typename Checker,
@@ -87,15 +89,20 @@ void OperationHandler<ValidateSender, AccumulatorType, Checker, ServiceHandlerTy
     LOG(kError) << "invalid sender";
     return;
   }
-  {
-    std::lock_guard<std::mutex> lock(mutex);
-    if (accumulator.AddPendingRequest(message, sender, checker)
+  // Copied, since in queued mode the task can outlive this call
+  AccumulatorType& accumulator_ref(accumulator);
+  Checker checker_copy(checker);
+  ServiceHandlerType* service_ptr(service);
+  ingestion.Run([=, &accumulator_ref]() -> IngestionQueue::Continuation {
+    if (accumulator_ref.AddPendingRequest(message, sender, checker_copy)
            != AccumulatorType::AddResult::kSuccess) {
       LOG(kInfo) << "AddPendingRequest unsuccessful";
-      return;
+      return IngestionQueue::Continuation();
     }
-  }
-  DoOperation<ServiceHandlerType, MessageType>(service, message, sender, receiver);
+    return [=] {
+      DoOperation<ServiceHandlerType, MessageType>(service_ptr, message, sender, receiver);
+    };
+  });
 }
 
 template<>
@@ -464,8 +471,8 @@ struct OperationHandlerWrapper {
   OperationHandlerWrapper(AccumulatorType& accumulator,
                           typename detail::ValidateSenderType<MessageType>::type validate_sender,
                           typename AccumulatorType::AddCheckerFunctor checker,
-                          ServiceHandler* service, std::mutex& mutex)
-      : typed_operation_handler(validate_sender, accumulator, checker, service, mutex) {}
+                          ServiceHandler* service, detail::IngestionQueue& ingestion)
+      : typed_operation_handler(validate_sender, accumulator, checker, service, ingestion) {}
 
   void operator()(const MessageType& message, const typename MessageType::Sender& sender,
                   const typename MessageType::Receiver& receiver) {
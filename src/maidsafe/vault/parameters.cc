@@ -33,6 +33,33 @@ const int Parameters::kMinNetworkHealth(12);
 size_t Parameters::max_recent_data_list_size(1000);
 int Parameters::max_file_element_count(10000);
 int Parameters::integrity_check_string_size(64);
+bool Parameters::durable_dbs(false);
+size_t Parameters::db_lock_stripe_count(16);
+size_t Parameters::group_db_value_cache_capacity(10000);
+int Parameters::group_db_prefix_width(2);
+uint32_t Parameters::churn_full_check_interval(20);
+size_t Parameters::max_transfer_chunk_bytes(1024 * 1024);
+size_t Parameters::max_sync_batch_bytes(256 * 1024);
+std::chrono::milliseconds Parameters::sync_retry_initial_interval(1000);
+std::chrono::milliseconds Parameters::sync_retry_max_interval(32000);
+int Parameters::max_sync_attempts(10);
+std::chrono::milliseconds Parameters::sync_retry_check_interval(250);
+bool Parameters::queued_ingestion(false);
+size_t Parameters::ingestion_batch_size(64);
+std::chrono::seconds Parameters::accumulator_request_ttl(30);
+size_t Parameters::accumulator_min_capacity(300);
+size_t Parameters::accumulator_max_capacity(20000);
+uint64_t Parameters::accumulator_max_bytes(256 * 1024 * 1024);
+std::chrono::seconds Parameters::account_transfer_request_ttl(60);
+size_t Parameters::account_transfer_min_capacity(100);
+size_t Parameters::account_transfer_max_capacity(2000);
+bool Parameters::pmid_node_segment_store(false);
+uint64_t Parameters::segment_store_max_segment_size(64 * 1024 * 1024);
+double Parameters::segment_store_compaction_threshold(0.5);
+size_t Parameters::pmid_node_worker_count(4);
+size_t Parameters::pmid_node_worker_queue_size(1024);
+double Parameters::pmid_node_reserved_disk_fraction(0.1);
+std::chrono::seconds Parameters::pmid_node_disk_reconcile_interval(30);
 const std::chrono::milliseconds Parameters::kDefaultTimeout(10000);
 
 }  // namespace detail
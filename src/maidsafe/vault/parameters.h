@@ -20,6 +20,7 @@
 #define MAIDSAFE_VAULT_PARAMETERS_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <chrono>
 
 namespace maidsafe {
@@ -38,6 +39,60 @@ struct Parameters {
   static int max_file_element_count;
   // Size of the string passed for integrity checking
   static int integrity_check_string_size;
+  // Whether persona dbs are kept on disk across restarts rather than rebuilt by account transfer.
+  static bool durable_dbs;
+  // Number of lock stripes each Db and GroupDb divides its keys between.  Operations on keys in
+  // different stripes run concurrently; 1 serialises all operations on a db.
+  static size_t db_lock_stripe_count;
+  // Max number of deserialised values each GroupDb caches; 0 disables the cache.
+  static size_t group_db_value_cache_capacity;
+  // Width in bytes (1 to 4) of the group id prefixing each GroupDb key.  Limits a GroupDb to
+  // 256 ^ group_db_prefix_width - 1 groups.
+  static int group_db_prefix_width;
+  // Db and GroupDb churn handling checks only the names a churn event can affect, except on every
+  // churn_full_check_interval'th event, when every name is checked.  0 disables full checks.
+  static uint32_t churn_full_check_interval;
+  // Max size of the serialised entries in each chunk of an account transfer.
+  static size_t max_transfer_chunk_bytes;
+  // Max size of the serialised sync messages batched into each message to a group.
+  static size_t max_sync_batch_bytes;
+  // An unresolved sync action is first resent after sync_retry_initial_interval, with the interval
+  // then doubling up to sync_retry_max_interval.  Actions are dropped after max_sync_attempts.
+  static std::chrono::milliseconds sync_retry_initial_interval;
+  static std::chrono::milliseconds sync_retry_max_interval;
+  static int max_sync_attempts;
+  // How often each service checks for sync actions due to be resent, and flushes its batched sync
+  // messages, including those for new actions.
+  static std::chrono::milliseconds sync_retry_check_interval;
+  // Whether each service's message handlers feed its accumulators through a lock-free queue
+  // drained in batches of up to ingestion_batch_size, rather than each taking a mutex.
+  static bool queued_ingestion;
+  static size_t ingestion_batch_size;
+  // Requests awaiting a quorum in an Accumulator expire after accumulator_request_ttl.  The number
+  // held adapts to the arrival rate, between the min and max capacities, while the serialised size
+  // of the distinct requests held is kept within accumulator_max_bytes.
+  static std::chrono::seconds accumulator_request_ttl;
+  static size_t accumulator_min_capacity;
+  static size_t accumulator_max_capacity;
+  static uint64_t accumulator_max_bytes;
+  // As above, for AccountTransfer.  The ttl also bounds how long a group is reported as handled.
+  static std::chrono::seconds account_transfer_request_ttl;
+  static size_t account_transfer_min_capacity;
+  static size_t account_transfer_max_capacity;
+  // Whether a PmidNode stores chunks in a SegmentStore rather than a file per chunk.  Segments are
+  // sealed at segment_store_max_segment_size bytes, and compacted once the proportion of their
+  // bytes which are dead reaches segment_store_compaction_threshold.
+  static bool pmid_node_segment_store;
+  static uint64_t segment_store_max_segment_size;
+  static double segment_store_compaction_threshold;
+  // A PmidNode handles Gets and integrity checks on pmid_node_worker_count threads, with up to
+  // pmid_node_worker_queue_size waiting.  Gets run first, and once full, integrity checks are shed.
+  static size_t pmid_node_worker_count;
+  static size_t pmid_node_worker_queue_size;
+  // The fraction of a PmidNode's max disk usage kept back from chunks for its databases and cache,
+  // and how often its free space is reconciled with the filesystem.
+  static double pmid_node_reserved_disk_fraction;
+  static std::chrono::seconds pmid_node_disk_reconcile_interval;
   // Default network timeout
   static const std::chrono::milliseconds kDefaultTimeout;
 
@@ -0,0 +1,106 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_PENDING_REQUEST_LIMITS_H_
+#define MAIDSAFE_VAULT_PENDING_REQUEST_LIMITS_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "maidsafe/vault/histogram.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Counts kept by a queue of requests awaiting a quorum of copies from a group.  A request which
+// expires or is evicted before reaching quorum has been dropped.  'time_to_quorum' is measured from
+// the arrival of the first copy still held.  'pending_count' and 'capacity' are as at the time of
+// the snapshot.
+struct PendingRequestStatistics {
+  PendingRequestStatistics()
+      : added(0), expired_before_quorum(0), evicted_before_quorum(0), time_to_quorum(),
+        pending_count(0), capacity(0) {}
+  uint64_t added;
+  uint64_t expired_before_quorum;
+  uint64_t evicted_before_quorum;
+  Histogram time_to_quorum;
+  size_t pending_count;
+  size_t capacity;
+};
+
+// Decides how long pending requests are kept and how many may be held.  Requests older than 'ttl'
+// are expired.  The capacity tracks the arrival rate, measured over one-second windows, so that
+// twice the requests arriving in one 'ttl' fit without eviction, within [min, max] capacity.
+class PendingRequestLimits {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  PendingRequestLimits(std::chrono::seconds ttl, size_t min_capacity, size_t max_capacity)
+      : kTtl_(ttl),
+        kMinCapacity_(std::max(min_capacity, static_cast<size_t>(1))),
+        kMaxCapacity_(std::max(max_capacity, kMinCapacity_)),
+        window_start_(Clock::now()),
+        window_arrivals_(0),
+        arrivals_per_second_(0.0),
+        capacity_(kMinCapacity_) {}
+
+  void RecordArrival(Clock::time_point now) {
+    ++window_arrivals_;
+    auto elapsed(now - window_start_);
+    if (elapsed < std::chrono::seconds(1))
+      return;
+    double rate(window_arrivals_ / std::chrono::duration<double>(elapsed).count());
+    // Rises at once to meet a burst, and decays by half per window after it
+    arrivals_per_second_ = std::max(rate, (arrivals_per_second_ + rate) / 2);
+    double wanted(arrivals_per_second_ * kTtl_.count() * 2);
+    capacity_ = static_cast<size_t>(
+        std::min(std::max(wanted, static_cast<double>(kMinCapacity_)),
+                 static_cast<double>(kMaxCapacity_)));
+    window_start_ = now;
+    window_arrivals_ = 0;
+  }
+
+  bool IsExpired(Clock::time_point arrival, Clock::time_point now) const {
+    return now - arrival > kTtl_;
+  }
+
+  size_t capacity() const { return capacity_; }
+  std::chrono::seconds ttl() const { return kTtl_; }
+
+ private:
+  const std::chrono::seconds kTtl_;
+  const size_t kMinCapacity_, kMaxCapacity_;
+  Clock::time_point window_start_;
+  uint64_t window_arrivals_;
+  double arrivals_per_second_;
+  size_t capacity_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_PENDING_REQUEST_LIMITS_H_
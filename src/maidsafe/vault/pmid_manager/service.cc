@@ -52,13 +52,27 @@ inline bool ForThisPersona(const Message& message) {
 
 PmidManagerService::PmidManagerService(const passport::Pmid& pmid, routing::Routing& routing,
                                        const boost::filesystem::path& vault_root_dir)
-    : routing_(routing), group_db_(UniqueDbPath(vault_root_dir)), accumulator_mutex_(), mutex_(),
-      stopped_(false), accumulator_(), dispatcher_(routing_), asio_service_(2),
+    : routing_(routing), group_db_(PersonaDbPath(vault_root_dir, "pmid_manager")),
+      accumulator_ingestion_(), mutex_(),
+      stopped_(false), accumulator_(), dispatcher_(routing_),
+      sync_batcher_(dispatcher_, detail::Parameters::max_sync_batch_bytes), asio_service_(2),
       get_health_timer_(asio_service_), sync_puts_(NodeId(pmid.name()->string())),
       sync_deletes_(NodeId(pmid.name()->string())),
       sync_set_pmid_health_(NodeId(pmid.name()->string())),
       sync_create_account_(NodeId(pmid.name()->string())),
-      account_transfer_() {
+      account_transfer_(),
+      sync_retry_timer_(asio_service_, detail::Parameters::sync_retry_check_interval,
+                        [this](std::chrono::steady_clock::time_point now) {
+                          ResendDueSyncs(now);
+                        }) {
+}
+
+void PmidManagerService::ResendDueSyncs(std::chrono::steady_clock::time_point now) {
+  detail::ResendDueSyncs(sync_batcher_, sync_puts_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_deletes_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_set_pmid_health_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_create_account_, now);
+  sync_batcher_.Flush();
 }
 
 
@@ -132,7 +146,7 @@ void PmidManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -147,7 +161,7 @@ void PmidManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -162,7 +176,7 @@ void PmidManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -177,7 +191,7 @@ void PmidManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -192,7 +206,7 @@ void PmidManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -207,7 +221,7 @@ void PmidManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -222,7 +236,7 @@ void PmidManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -240,7 +254,7 @@ void PmidManagerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)),
-      this, accumulator_mutex_)(message, sender, receiver);
+      this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 // =============== Handle Sync Messages ============================================================
@@ -251,11 +265,19 @@ void PmidManagerService::HandleMessage(
     const typename SynchroniseFromPmidManagerToPmidManager::Sender& sender,
     const typename SynchroniseFromPmidManagerToPmidManager::Receiver& /*receiver*/) {
   LOG(kVerbose) << message;
-  protobuf::Sync proto_sync;
-  if (!proto_sync.ParseFromString(message.contents->data)) {
+  protobuf::SyncBatch proto_sync_batch;
+  if (!proto_sync_batch.ParseFromString(message.contents->data)) {
     LOG(kError) << "SynchroniseFromPmidManagerToPmidManager can't parse content";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   }
+  detail::ApplySyncBatch(proto_sync_batch, "SynchroniseFromPmidManagerToPmidManager",
+                         [&](const protobuf::Sync& proto_sync) {
+                           HandleSync(proto_sync, sender);
+                         });
+}
+
+void PmidManagerService::HandleSync(const protobuf::Sync& proto_sync,
+                                    const routing::GroupSource& sender) {
   switch (static_cast<nfs::MessageAction>(proto_sync.action_type())) {
     case ActionPmidManagerPut::kActionId: {
       LOG(kVerbose) << "SynchroniseFromPmidManagerToPmidManager ActionPmidManagerPut";
@@ -280,7 +302,8 @@ void PmidManagerService::HandleMessage(
       break;
     }
     case ActionPmidManagerSetPmidHealth::kActionId: {
-      LOG(kVerbose) << "SynchroniseFromPmidManagerToPmidManager ActionPmidManagerSetAvailableSize";
+      LOG(kVerbose)
+          << "SynchroniseFromPmidManagerToPmidManager ActionPmidManagerSetAvailableSize";
       PmidManager::UnresolvedSetPmidHealth unresolved_action(
           proto_sync.serialised_unresolved_action(), sender.sender_id, routing_.kNodeId());
       auto resolved_action(sync_set_pmid_health_.AddUnresolvedAction(unresolved_action));
@@ -512,9 +535,10 @@ void PmidManagerService::HandleChurnEvent(
         throw;
     }
   }
-  GroupDb<PmidManager>::TransferInfo transfer_info(group_db_.GetTransferInfo(matrix_change));
-  for (auto& transfer : transfer_info)
-    TransferAccount(transfer.first, transfer.second);
+  group_db_.GetTransferInfo(matrix_change,
+      [this](const NodeId& new_holder, GroupDb<PmidManager>::Contents&& contents) {
+        TransferAccount(new_holder, contents);
+      });
 }
 
 // void PmidManagerService::ValidateDataSender(const nfs::Message& message) const {
@@ -539,37 +563,37 @@ void PmidManagerService::HandleChurnEvent(
 // =============== Account transfer ===============================================================
 
 void PmidManagerService::TransferAccount(const NodeId& dest,
-    const std::vector<GroupDb<PmidManager>::Contents>& accounts) {
-  for (auto& account : accounts) {
-    // If account just received, shall not pass it out as may under a startup procedure
-    // i.e. existing PM will be seen as new_node in matrix_change
-    if (account_transfer_.CheckHandled(routing::GroupId(NodeId(account.group_name->string())))) {
-      LOG(kInfo) << "PmidManager account " << HexSubstr(account.group_name->string())
-                 << " just received";
-      continue;
-    }
-    VLOG(nfs::Persona::kPmidManager, VisualiserAction::kAccountTransfer, account.group_name,
-         Identity{ dest.string() });
-    try {
-      std::vector<std::string> actions;
-      actions.push_back(account.metadata.Serialise());
-      LOG(kVerbose) << "PmidManagerService::TransferAccount metadata serialised";
-      for (auto& kv : account.kv_pairs) {
-        protobuf::PmidManagerKeyValuePair kv_msg;
-          kv_msg.set_key(kv.first.Serialise());
-          kv_msg.set_value(kv.second.Serialise());
-          actions.push_back(kv_msg.SerializeAsString());
-      }
-      nfs::MessageId message_id(HashStringToMessageId(account.group_name->string()));
-      PmidManager::UnresolvedAccountTransfer account_transfer(
-          account.group_name, message_id, actions);
-      LOG(kVerbose) << "PmidManagerService::TransferAccount send account_transfer";
-      dispatcher_.SendAccountTransfer(dest, account.group_name,
-                                      message_id, account_transfer.Serialise());
-    } catch(...) {
-      // normally, the problem is metadata hasn't populated
-      LOG(kError) << "PmidManagerService::TransferAccount account info error";
+                                       const GroupDb<PmidManager>::Contents& account) {
+  // If account just received, shall not pass it out as may under a startup procedure
+  // i.e. existing PM will be seen as new_node in matrix_change
+  if (account_transfer_.CheckHandled(routing::GroupId(NodeId(account.group_name->string())))) {
+    LOG(kInfo) << "PmidManager account " << HexSubstr(account.group_name->string())
+               << " just received";
+    return;
+  }
+  VLOG(nfs::Persona::kPmidManager, VisualiserAction::kAccountTransfer, account.group_name,
+       Identity{ dest.string() });
+  try {
+    std::vector<std::string> actions;
+    actions.push_back(account.metadata.Serialise());
+    LOG(kVerbose) << "PmidManagerService::TransferAccount metadata serialised";
+    for (auto& kv : account.kv_pairs) {
+      protobuf::PmidManagerKeyValuePair kv_msg;
+        kv_msg.set_key(kv.first.Serialise());
+        kv_msg.set_value(kv.second.Serialise());
+        actions.push_back(kv_msg.SerializeAsString());
     }
+    // Holders send the same chunks, so a chunk's first key identifies it
+    nfs::MessageId message_id(HashStringToMessageId(account.group_name->string() +
+        (account.kv_pairs.empty() ? std::string() : account.kv_pairs.front().first.Serialise())));
+    PmidManager::UnresolvedAccountTransfer account_transfer(
+        account.group_name, message_id, actions);
+    LOG(kVerbose) << "PmidManagerService::TransferAccount send account_transfer";
+    dispatcher_.SendAccountTransfer(dest, account.group_name,
+                                    message_id, account_transfer.Serialise());
+  } catch(...) {
+    // normally, the problem is metadata hasn't populated
+    LOG(kError) << "PmidManagerService::TransferAccount account info error";
   }
 }
 
@@ -641,6 +665,16 @@ void PmidManagerService::HandleAccountTransfer(
 //    return;    // TODO(Team) Implement whatever else is required here?
 // }
 
+detail::ServiceStatistics PmidManagerService::GetStatistics() const {
+  detail::ServiceStatistics statistics;
+  statistics.accumulators["accumulator"] = accumulator_.GetStatistics();
+  statistics.syncs["puts"] = sync_puts_.GetStatistics();
+  statistics.syncs["deletes"] = sync_deletes_.GetStatistics();
+  statistics.syncs["set_pmid_health"] = sync_set_pmid_health_.GetStatistics();
+  statistics.syncs["create_account"] = sync_create_account_.GetStatistics();
+  return statistics;
+}
+
 }  // namespace vault
 
 }  // namespace maidsafe
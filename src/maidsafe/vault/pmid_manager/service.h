@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_VAULT_PMID_MANAGER_SERVICE_H_
 #define MAIDSAFE_VAULT_PMID_MANAGER_SERVICE_H_
 
+#include <chrono>
 #include <mutex>
 #include <set>
 #include <string>
@@ -36,12 +37,16 @@
 #include "maidsafe/vault/account_transfer.h"
 #include "maidsafe/vault/accumulator.h"
 #include "maidsafe/vault/group_db.h"
+#include "maidsafe/vault/ingestion_queue.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/pmid_manager/action_delete.h"
 #include "maidsafe/vault/pmid_manager/dispatcher.h"
 #include "maidsafe/vault/pmid_manager/handler.h"
 #include "maidsafe/vault/sync.h"
+#include "maidsafe/vault/sync_batcher.h"
+#include "maidsafe/vault/sync_retry_timer.h"
+#include "maidsafe/vault/statistics.h"
 #include "maidsafe/vault/pmid_manager/pmid_manager.h"
 #include "maidsafe/vault/pmid_manager/metadata.h"
 #include "maidsafe/vault/operation_visitors.h"
@@ -71,6 +76,9 @@ class PmidManagerService {
 
   void HandleChurnEvent(std::shared_ptr<routing::MatrixChange> matrix_change);
 
+  // Snapshot of the Accumulator and Sync statistics, safe to call from any thread
+  detail::ServiceStatistics GetStatistics() const;
+
   void Stop() {
     std::lock_guard<std::mutex> lock(mutex_);
     stopped_ = true;
@@ -130,6 +138,9 @@ class PmidManagerService {
 
   template <typename UnresolvedAction>
   void DoSync(const UnresolvedAction& unresolved_action);
+  // Applies one sync from a received batch
+  void HandleSync(const protobuf::Sync& proto_sync, const routing::GroupSource& sender);
+  void ResendDueSyncs(std::chrono::steady_clock::time_point now);
   void SendPutResponse(const DataNameVariant& data_name, const PmidName& pmid_node, int32_t size,
                        nfs::MessageId message_id);
 
@@ -145,18 +156,19 @@ class PmidManagerService {
   void DoHandleHealthResponse(const PmidName& pmid_node,
       const MaidName& maid_node, const PmidManagerMetadata& pmid_health, nfs::MessageId message_id);
 
-  void TransferAccount(const NodeId& dest,
-                       const std::vector<GroupDb<PmidManager>::Contents>& accounts);
+  void TransferAccount(const NodeId& dest, const GroupDb<PmidManager>::Contents& account);
 
   void HandleAccountTransfer(
       std::unique_ptr<PmidManager::UnresolvedAccountTransfer>&& resolved_action);
 
   routing::Routing& routing_;
   GroupDb<PmidManager> group_db_;
-  std::mutex accumulator_mutex_, mutex_;
+  detail::IngestionQueue accumulator_ingestion_;
+  std::mutex mutex_;
   bool stopped_;
   Accumulator<Messages> accumulator_;
   PmidManagerDispatcher dispatcher_;
+  detail::SyncBatcher<PmidManagerDispatcher> sync_batcher_;
   AsioService asio_service_;
   routing::Timer<PmidManagerMetadata> get_health_timer_;
   Sync<PmidManager::UnresolvedPut> sync_puts_;
@@ -164,6 +176,7 @@ class PmidManagerService {
   Sync<PmidManager::UnresolvedSetPmidHealth> sync_set_pmid_health_;
   Sync<PmidManager::UnresolvedCreateAccount> sync_create_account_;
   AccountTransfer<PmidManager::UnresolvedAccountTransfer> account_transfer_;
+  detail::SyncRetryTimer sync_retry_timer_;
 };
 
 // ============================= Handle Message Specialisations ===================================
@@ -320,10 +333,7 @@ void PmidManagerService::HandleDelete(
 
 template <typename UnresolvedAction>
 void PmidManagerService::DoSync(const UnresolvedAction& unresolved_action) {
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_puts_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_deletes_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_set_pmid_health_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_create_account_, unresolved_action);
+  detail::SendSyncAction(sync_batcher_, unresolved_action);
 }
 
 // ===============================================================================================
@@ -0,0 +1,79 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/pmid_node/chunk_view.h"
+
+#include <string>
+#include <utility>
+
+#include "boost/interprocess/file_mapping.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+ChunkView::ChunkView(NonEmptyString value)
+    : value_(std::move(value)),
+      owner_(),
+      region_(),
+      data_(value_.string().data()),
+      size_(value_.string().size()) {}
+
+ChunkView::ChunkView(const boost::filesystem::path& file_path, uint64_t offset, size_t size,
+                     std::shared_ptr<void> owner)
+    : value_(), owner_(std::move(owner)), region_(), data_(nullptr), size_(size) {
+  try {
+    boost::interprocess::file_mapping file(file_path.string().c_str(),
+                                           boost::interprocess::read_only);
+    boost::interprocess::mapped_region region(file, boost::interprocess::read_only,
+                                              static_cast<boost::interprocess::offset_t>(offset),
+                                              size);
+    region_.swap(region);
+  } catch (const boost::interprocess::interprocess_exception& e) {
+    LOG(kError) << "Failed to map " << size << " bytes at " << offset << " in " << file_path
+                << ": " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  data_ = static_cast<const char*>(region_.get_address());
+}
+
+ChunkView::ChunkView(ChunkView&& other)
+    : value_(std::move(other.value_)),
+      owner_(std::move(other.owner_)),
+      region_(),
+      data_(other.data_),
+      size_(other.size_) {
+  region_.swap(other.region_);
+  // A moved std::string needn't keep its buffer, so re-point at our own copy of an owned value.
+  if (value_.IsInitialised())
+    data_ = value_.string().data();
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+NonEmptyString ChunkView::ToNonEmptyString() const {
+  return NonEmptyString(std::string(data_, size_));
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,69 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_PMID_NODE_CHUNK_VIEW_H_
+#define MAIDSAFE_VAULT_PMID_NODE_CHUNK_VIEW_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// A read-only view of a stored chunk's serialised value.  The value is either mapped straight from
+// the file holding it, or owned by the view where the store can only return a copy.  Either way,
+// hashing or sending the chunk through data() and size() doesn't copy it again.
+class ChunkView {
+ public:
+  explicit ChunkView(NonEmptyString value);
+  // Maps 'size' bytes from 'offset' in 'file_path'.  'owner' is held until the mapping is released,
+  // so that it can keep the file in place.
+  ChunkView(const boost::filesystem::path& file_path, uint64_t offset, size_t size,
+            std::shared_ptr<void> owner);
+  ChunkView(ChunkView&& other);
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  // Copies the value.
+  NonEmptyString ToNonEmptyString() const;
+
+ private:
+  ChunkView(const ChunkView&);
+  ChunkView& operator=(const ChunkView&);
+  ChunkView& operator=(ChunkView&&);
+
+  NonEmptyString value_;
+  // Declared before 'region_' so that the mapping is released first.
+  std::shared_ptr<void> owner_;
+  boost::interprocess::mapped_region region_;
+  const char* data_;
+  size_t size_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_PMID_NODE_CHUNK_VIEW_H_
@@ -0,0 +1,115 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/pmid_node/disk_usage_tracker.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/vault/parameters.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace {
+
+uint64_t Subtract(uint64_t lhs, uint64_t rhs) { return lhs > rhs ? lhs - rhs : 0; }
+
+}  // unnamed namespace
+
+DiskUsageTracker::DiskUsageTracker(const boost::filesystem::path& disk_path,
+                                   DiskUsage max_disk_usage)
+    : DiskUsageTracker(max_disk_usage, detail::Parameters::pmid_node_reserved_disk_fraction,
+                       detail::Parameters::pmid_node_disk_reconcile_interval,
+                       [disk_path]() -> uint64_t {
+                         boost::system::error_code error_code;
+                         auto space_info(boost::filesystem::space(disk_path, error_code));
+                         if (error_code) {
+                           LOG(kWarning) << "Failed to get space available at " << disk_path
+                                         << ": " << error_code.message();
+                           return 0;
+                         }
+                         return space_info.available;
+                       }) {}
+
+DiskUsageTracker::DiskUsageTracker(DiskUsage max_disk_usage, double reserved_fraction,
+                                   std::chrono::steady_clock::duration reconcile_interval,
+                                   AvailableSpaceFunctor available_space)
+    : kMaxDiskUsage_(max_disk_usage.data),
+      kReserved_(static_cast<uint64_t>(static_cast<double>(max_disk_usage.data) *
+                                       std::min(std::max(reserved_fraction, 0.0), 1.0))),
+      kReconcileInterval_(reconcile_interval),
+      kAvailableSpace_(std::move(available_space)),
+      mutex_(),
+      used_(0),
+      filesystem_available_(0),
+      used_at_reconcile_(0),
+      last_reconcile_() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReconcileLocked();
+}
+
+DiskUsage DiskUsageTracker::StoreLimit() const {
+  return DiskUsage(kMaxDiskUsage_ - kReserved_);
+}
+
+void DiskUsageTracker::SetUsed(DiskUsage used) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  used_ = used.data;
+}
+
+DiskUsage DiskUsageTracker::Used() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return DiskUsage(used_);
+}
+
+DiskUsage DiskUsageTracker::Reserved() const {
+  return DiskUsage(kReserved_);
+}
+
+DiskUsage DiskUsageTracker::Free() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (std::chrono::steady_clock::now() - last_reconcile_ >= kReconcileInterval_)
+    ReconcileLocked();
+  uint64_t filesystem_free(Subtract(
+      Subtract(filesystem_available_, Subtract(used_, used_at_reconcile_)), kReserved_));
+  return DiskUsage(std::min(Subtract(kMaxDiskUsage_ - kReserved_, used_), filesystem_free));
+}
+
+void DiskUsageTracker::Reconcile() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReconcileLocked();
+}
+
+void DiskUsageTracker::ReconcileLocked() const {
+  filesystem_available_ = kAvailableSpace_();
+  used_at_reconcile_ = used_;
+  last_reconcile_ = std::chrono::steady_clock::now();
+  LOG(kVerbose) << "DiskUsageTracker used " << used_ << ", reserved " << kReserved_
+                << ", filesystem available " << filesystem_available_;
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
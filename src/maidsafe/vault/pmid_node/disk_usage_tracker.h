@@ -0,0 +1,84 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_PMID_NODE_DISK_USAGE_TRACKER_H_
+#define MAIDSAFE_VAULT_PMID_NODE_DISK_USAGE_TRACKER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// Accounts for a PmidNode's disk space.  Of 'max_disk_usage', a fraction is reserved as headroom
+// for the node's databases and cache, leaving StoreLimit() for chunks.  The space used by chunks
+// is updated after every Put and Delete, while the space available on the filesystem is sampled
+// once per reconciliation interval.  Writes since the last sample are taken off it, but space freed
+// since is only counted at the next.  Free() is the lesser of the space left under StoreLimit() and
+// that left on the filesystem after the reserve.
+class DiskUsageTracker {
+ public:
+  // Returns the number of bytes available on the filesystem
+  typedef std::function<uint64_t()> AvailableSpaceFunctor;
+
+  // The reserved fraction and reconciliation interval are taken from
+  // Parameters::pmid_node_reserved_disk_fraction and Parameters::pmid_node_disk_reconcile_interval,
+  // and the available space from boost::filesystem::space(disk_path).
+  DiskUsageTracker(const boost::filesystem::path& disk_path, DiskUsage max_disk_usage);
+  DiskUsageTracker(DiskUsage max_disk_usage, double reserved_fraction,
+                   std::chrono::steady_clock::duration reconcile_interval,
+                   AvailableSpaceFunctor available_space);
+
+  DiskUsage StoreLimit() const;
+  void SetUsed(DiskUsage used);
+  DiskUsage Used() const;
+  DiskUsage Reserved() const;
+  // Reconciles first if the interval has elapsed.
+  DiskUsage Free() const;
+  void Reconcile() const;
+
+ private:
+  DiskUsageTracker(const DiskUsageTracker&);
+  DiskUsageTracker& operator=(const DiskUsageTracker&);
+  DiskUsageTracker(DiskUsageTracker&&);
+  DiskUsageTracker& operator=(DiskUsageTracker&&);
+
+  void ReconcileLocked() const;
+
+  const uint64_t kMaxDiskUsage_, kReserved_;
+  const std::chrono::steady_clock::duration kReconcileInterval_;
+  const AvailableSpaceFunctor kAvailableSpace_;
+  mutable std::mutex mutex_;
+  uint64_t used_;
+  mutable uint64_t filesystem_available_, used_at_reconcile_;
+  mutable std::chrono::steady_clock::time_point last_reconcile_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_PMID_NODE_DISK_USAGE_TRACKER_H_
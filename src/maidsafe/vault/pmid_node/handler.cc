@@ -18,43 +18,87 @@
 
 #include "maidsafe/vault/pmid_node/handler.h"
 
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/vault/parameters.h"
+
 namespace maidsafe {
 namespace vault {
 
-namespace {
+PmidNodeHandler::PmidNodeHandler(const boost::filesystem::path vault_root_dir,
+                                 DiskUsage max_disk_usage)
+    : disk_usage_tracker_(vault_root_dir, max_disk_usage),
+      permanent_data_store_(),
+      segment_store_() {
+  if (detail::Parameters::pmid_node_segment_store) {
+    segment_store_.reset(new SegmentStore(vault_root_dir / "pmid_node" / "segments",
+                                          disk_usage_tracker_.StoreLimit()));
+  } else {
+    permanent_data_store_.reset(
+        new data_stores::PermanentStore(vault_root_dir / "pmid_node" / "permanent",
+                                        disk_usage_tracker_.StoreLimit()));
+  }
+  disk_usage_tracker_.SetUsed(StoreDiskUsage());
+}
+
+boost::filesystem::path PmidNodeHandler::GetDiskPath() const {
+  return segment_store_ ? segment_store_->GetDiskPath() : permanent_data_store_->GetDiskPath();
+}
+
+std::vector<DataNameVariant> PmidNodeHandler::GetAllDataNames() const {
+  return segment_store_ ? segment_store_->GetKeys() : permanent_data_store_->GetKeys();
+}
 
-MemoryUsage mem_usage = MemoryUsage(524288000);  // 500Mb
-MemoryUsage perm_usage = MemoryUsage(mem_usage / 5);
-DiskUsage perm_disk_usage = DiskUsage(10000000000);
+DiskUsage PmidNodeHandler::AvailableSpace() const {
+  disk_usage_tracker_.SetUsed(StoreDiskUsage());
+  return disk_usage_tracker_.Free();
+}
 
+DiskUsage PmidNodeHandler::UsedSpace() const {
+  disk_usage_tracker_.SetUsed(StoreDiskUsage());
+  return disk_usage_tracker_.Used();
+}
 
-// MemoryUsage mem_only_cache_usage = MemoryUsage(mem_usage * 2 / 5);
-//  fs::space_info space = fs::space("/tmp/vault_root_dir\\");  // FIXME  NOLINT
+DiskUsage PmidNodeHandler::ReservedSpace() const {
+  return disk_usage_tracker_.Reserved();
+}
 
-//  DiskUsage disk_total = DiskUsage(space.available);
-//  DiskUsage permanent_size = DiskUsage(disk_total * 0.8);
-//  DiskUsage cache_size = DiskUsage(disk_total * 0.1);
+NonEmptyString PmidNodeHandler::GetValue(const DataNameVariant& data_name) {
+  return segment_store_ ? segment_store_->Get(data_name) : permanent_data_store_->Get(data_name);
+}
 
-}  // namespace
+ChunkView PmidNodeHandler::GetView(const DataNameVariant& data_name) {
+  return segment_store_ ? segment_store_->GetView(data_name)
+                        : ChunkView(permanent_data_store_->Get(data_name));
+}
 
-PmidNodeHandler::PmidNodeHandler(const boost::filesystem::path vault_root_dir,
-                                 DiskUsage max_disk_usage)
-    : space_info_(boost::filesystem::space(vault_root_dir)),
-      disk_total_(space_info_.available),
-      permanent_size_(disk_total_ * 4 / 5),
-      permanent_data_store_(vault_root_dir / "pmid_node" / "permanent", max_disk_usage) {}
-// TODO(Fraser) BEFORE_RELEASE need to decide on propertion of max_disk_usage. As leveldb and cache
-// will be using a share of it
-boost::filesystem::path PmidNodeHandler::GetDiskPath() const {
-  return permanent_data_store_.GetDiskPath();
+void PmidNodeHandler::PutValue(const DataNameVariant& data_name, const NonEmptyString& value) {
+  auto free_space(AvailableSpace());
+  if (value.string().size() > free_space.data) {
+    LOG(kWarning) << "Refusing to store " << value.string().size() << " bytes with only "
+                  << free_space.data << " free";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+  }
+  if (segment_store_)
+    segment_store_->Put(data_name, value);
+  else
+    permanent_data_store_->Put(data_name, value);
+  disk_usage_tracker_.SetUsed(StoreDiskUsage());
 }
 
-std::vector<DataNameVariant> PmidNodeHandler::GetAllDataNames() const {
-  return permanent_data_store_.GetKeys();
+void PmidNodeHandler::DeleteValue(const DataNameVariant& data_name) {
+  if (segment_store_)
+    segment_store_->Delete(data_name);
+  else
+    permanent_data_store_->Delete(data_name);
+  disk_usage_tracker_.SetUsed(StoreDiskUsage());
 }
 
-DiskUsage PmidNodeHandler::AvailableSpace() const {
-  return disk_total_;
+// A SegmentStore's files hold more than its values, so the tracker is given their total size
+DiskUsage PmidNodeHandler::StoreDiskUsage() const {
+  return segment_store_ ? segment_store_->GetFootprint()
+                        : permanent_data_store_->GetCurrentDiskUsage();
 }
 
 }  // namespace vault
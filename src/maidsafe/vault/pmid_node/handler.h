@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_VAULT_PMID_NODE_HANDLER_H_
 #define MAIDSAFE_VAULT_PMID_NODE_HANDLER_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -29,11 +30,19 @@
 #include "maidsafe/common/data_types/data_name_variant.h"
 #include "maidsafe/nfs/types.h"
 #include "maidsafe/vault/types.h"
+#include "maidsafe/vault/pmid_node/chunk_view.h"
+#include "maidsafe/vault/pmid_node/disk_usage_tracker.h"
+#include "maidsafe/vault/pmid_node/segment_store.h"
 
 namespace maidsafe {
 
 namespace vault {
 
+// Chunks are held in a PermanentStore, or if Parameters::pmid_node_segment_store is set, in a
+// SegmentStore.  The store's limit is 'max_disk_usage' less the space reserved by the
+// DiskUsageTracker, and a Put is refused if it would exceed the tracker's free space.  The
+// tracker's used space is refreshed from the store after each Put and Delete, and whenever the
+// used or available space is asked for, since a SegmentStore's files also shrink as it compacts.
 class PmidNodeHandler {
  public:
   explicit PmidNodeHandler(const boost::filesystem::path vault_root_dir, DiskUsage max_disk_usage);
@@ -41,6 +50,10 @@ class PmidNodeHandler {
   template <typename Data>
   Data Get(const typename Data::Name& data_name);
 
+  // Returns the serialised chunk without parsing it, mapped from disk when held in a SegmentStore.
+  template <typename Data>
+  ChunkView GetSerialised(const typename Data::Name& data_name);
+
   template <typename Data>
   void Put(const Data& data);
 
@@ -50,32 +63,43 @@ class PmidNodeHandler {
   boost::filesystem::path GetDiskPath() const;
   std::vector<DataNameVariant> GetAllDataNames() const;
   DiskUsage AvailableSpace() const;
+  DiskUsage UsedSpace() const;
+  DiskUsage ReservedSpace() const;
 
  private:
-  boost::filesystem::space_info space_info_;
-  DiskUsage disk_total_;
-  DiskUsage permanent_size_;
-  data_stores::PermanentStore permanent_data_store_;
+  NonEmptyString GetValue(const DataNameVariant& data_name);
+  ChunkView GetView(const DataNameVariant& data_name);
+  void PutValue(const DataNameVariant& data_name, const NonEmptyString& value);
+  void DeleteValue(const DataNameVariant& data_name);
+  DiskUsage StoreDiskUsage() const;
+
+  mutable DiskUsageTracker disk_usage_tracker_;
+  // Only one of these is set
+  std::unique_ptr<data_stores::PermanentStore> permanent_data_store_;
+  std::unique_ptr<SegmentStore> segment_store_;
 };
 
 template <typename Data>
 Data PmidNodeHandler::Get(const typename Data::Name& data_name) {
   DataNameVariant data_name_variant(data_name);
-  Data data(data_name,
-            typename Data::serialised_type(permanent_data_store_.Get(data_name_variant)));
+  Data data(data_name, typename Data::serialised_type(GetValue(data_name_variant)));
   return data;
 }
 
+template <typename Data>
+ChunkView PmidNodeHandler::GetSerialised(const typename Data::Name& data_name) {
+  return GetView(DataNameVariant(data_name));
+}
 
 template <typename Data>
 void PmidNodeHandler::Put(const Data& data) {
   VLOG(nfs::Persona::kPmidNode, VisualiserAction::kStoreChunk, data.name().value);
-  permanent_data_store_.Put(DataNameVariant(data.name()), data.Serialise().data);
+  PutValue(DataNameVariant(data.name()), data.Serialise().data);
 }
 
 template <typename DataName>
 void PmidNodeHandler::Delete(const DataName& data_name) {
-  permanent_data_store_.Delete(DataNameVariant(data_name));
+  DeleteValue(DataNameVariant(data_name));
 }
 
 }  // namespace vault
@@ -0,0 +1,486 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/pmid_node/segment_store.h"
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+#include "boost/crc.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/functional/hash.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/vault/parameters.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace {
+
+// Each record is a header followed by the serialised key and the value.  The header holds, in
+// order: the magic number, the record type, the target segment, the key size, the value size, and
+// a CRC-32 of the header fields after the magic number along with the key and value.
+const uint32_t kRecordMagic(0x4d53534d);
+const size_t kHeaderSize(4 + 1 + 4 + 4 + 4 + 4);
+const size_t kCrcOffset(kHeaderSize - 4);
+const uint32_t kMaxKeySize(1024);
+const uint32_t kMaxValueSize(1 << 30);
+const char kSegmentPrefix[] = "segment_";
+
+void AppendUint32(uint32_t value, std::string& output) {
+  for (int i(0); i != 4; ++i)
+    output.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+uint32_t ReadUint32(const char* input) {
+  uint32_t value(0);
+  for (int i(3); i >= 0; --i)
+    value = (value << 8) | static_cast<unsigned char>(input[i]);
+  return value;
+}
+
+uint32_t Checksum(const char* header_fields, size_t header_fields_size, const std::string& key,
+                  const std::string& value) {
+  boost::crc_32_type crc;
+  crc.process_bytes(header_fields, header_fields_size);
+  crc.process_bytes(key.data(), key.size());
+  crc.process_bytes(value.data(), value.size());
+  return crc.checksum();
+}
+
+fs::path SegmentPath(const fs::path& disk_path, uint32_t number) {
+  std::string name(std::to_string(number));
+  return disk_path / (kSegmentPrefix + std::string(8 - std::min<size_t>(name.size(), 8), '0') +
+                      name);
+}
+
+// Returns false if 'filename' isn't that of a segment.
+bool ParseSegmentNumber(const std::string& filename, uint32_t& number) {
+  const size_t kPrefixSize(sizeof(kSegmentPrefix) - 1);
+  if (filename.size() <= kPrefixSize || filename.compare(0, kPrefixSize, kSegmentPrefix) != 0 ||
+      !std::all_of(std::begin(filename) + kPrefixSize, std::end(filename),
+                   [](char c) { return c >= '0' && c <= '9'; })) {
+    return false;
+  }
+  try {
+    number = static_cast<uint32_t>(std::stoul(filename.substr(kPrefixSize)));
+  }
+  catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+}  // unnamed namespace
+
+SegmentStore::Segment::Segment(uint32_t number_in, fs::path path_in)
+    : number(number_in),
+      path(std::move(path_in)),
+      size(0),
+      dead_bytes(0),
+      tombstone_bytes(),
+      obsolete(false) {}
+
+SegmentStore::Segment::~Segment() {
+  if (!obsolete)
+    return;
+  boost::system::error_code error_code;
+  fs::remove(path, error_code);
+  if (error_code)
+    LOG(kError) << "Failed to remove compacted segment " << path << ": " << error_code.message();
+}
+
+size_t SegmentStore::KeyHash::operator()(const Key& key) const {
+  size_t seed(0);
+  boost::hash_combine(seed, key.name.string());
+  boost::hash_combine(seed, static_cast<int>(key.type));
+  return seed;
+}
+
+SegmentStore::SegmentStore(const fs::path& disk_path, DiskUsage max_disk_usage)
+    : SegmentStore(disk_path, max_disk_usage, detail::Parameters::segment_store_max_segment_size,
+                   detail::Parameters::segment_store_compaction_threshold) {}
+
+SegmentStore::SegmentStore(const fs::path& disk_path, DiskUsage max_disk_usage,
+                           uint64_t max_segment_size, double compaction_threshold)
+    : kDiskPath_(disk_path),
+      kMaxDiskUsage_(max_disk_usage),
+      kMaxSegmentSize_(max_segment_size),
+      kCompactionThreshold_(compaction_threshold),
+      mutex_(),
+      segments_(),
+      active_segment_(),
+      active_stream_(),
+      index_(),
+      current_disk_usage_(0),
+      compaction_scheduled_(false),
+      compaction_mutex_(),
+      asio_service_(1) {
+  fs::create_directories(kDiskPath_);
+  Recover();
+}
+
+SegmentStore::~SegmentStore() {
+  asio_service_.Stop();
+}
+
+void SegmentStore::Put(const KeyType& key, const NonEmptyString& value) {
+  Record record;
+  record.type = RecordType::kPut;
+  record.key = Key(key).Serialise();
+  record.value = value.string();
+  Key index_key(key);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(index_.find(index_key));
+  uint64_t replaced_size(itr == std::end(index_) ? 0 : itr->second.value_size);
+  if (current_disk_usage_.data - replaced_size + record.value.size() > kMaxDiskUsage_.data) {
+    LOG(kError) << "Cannot store " << HexSubstr(index_key.name.string()) << " since it would "
+                << "exceed the disk usage limit of " << kMaxDiskUsage_.data << " bytes";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+  }
+  // The existing record is killed with a tombstone first, so that replaying the segments never
+  // revives it, whichever of them are later compacted.
+  if (itr != std::end(index_))
+    DeleteLocked(itr);
+  index_[index_key] = Append(record);
+  current_disk_usage_.data += record.value.size();
+}
+
+NonEmptyString SegmentStore::Get(const KeyType& key) const {
+  return GetView(key).ToNonEmptyString();
+}
+
+ChunkView SegmentStore::GetView(const KeyType& key) const {
+  Location location;
+  std::shared_ptr<Segment> segment;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(index_.find(Key(key)));
+    if (itr == std::end(index_))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+    location = itr->second;
+    segment = segments_.at(location.segment);
+  }
+  // Holding 'segment' keeps its file in place even if it's compacted meanwhile
+  auto path(segment->path);
+  return ChunkView(path, location.offset + location.record_size - location.value_size,
+                   location.value_size, std::move(segment));
+}
+
+void SegmentStore::Delete(const KeyType& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(index_.find(Key(key)));
+  if (itr == std::end(index_))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  DeleteLocked(itr);
+}
+
+std::vector<SegmentStore::KeyType> SegmentStore::GetKeys() const {
+  std::vector<KeyType> keys;
+  std::lock_guard<std::mutex> lock(mutex_);
+  keys.reserve(index_.size());
+  for (const auto& entry : index_)
+    keys.push_back(GetDataNameVariant(entry.first.type, entry.first.name));
+  return keys;
+}
+
+fs::path SegmentStore::GetDiskPath() const {
+  return kDiskPath_;
+}
+
+DiskUsage SegmentStore::GetCurrentDiskUsage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return current_disk_usage_;
+}
+
+DiskUsage SegmentStore::GetFootprint() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t footprint(0);
+  for (const auto& segment : segments_)
+    footprint += segment.second->size;
+  return DiskUsage(footprint);
+}
+
+size_t SegmentStore::Compact() {
+  std::lock_guard<std::mutex> compaction_lock(compaction_mutex_);
+  size_t compacted(0);
+  for (;;) {
+    std::shared_ptr<Segment> segment;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& candidate : segments_) {
+        if (candidate.second != active_segment_ && IsDueCompaction(*candidate.second)) {
+          segment = candidate.second;
+          break;
+        }
+      }
+      if (!segment) {
+        compaction_scheduled_ = false;
+        return compacted;
+      }
+    }
+    CompactSegment(segment);
+    ++compacted;
+  }
+}
+
+void SegmentStore::Recover() {
+  std::vector<uint32_t> numbers;
+  for (fs::directory_iterator itr(kDiskPath_); itr != fs::directory_iterator(); ++itr) {
+    uint32_t number(0);
+    if (fs::is_regular_file(itr->status()) &&
+        ParseSegmentNumber(itr->path().filename().string(), number)) {
+      numbers.push_back(number);
+    }
+  }
+  std::sort(std::begin(numbers), std::end(numbers));
+  // Held until the new active segment is started, since replaying may schedule a compaction
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto itr(std::begin(numbers)); itr != std::end(numbers); ++itr) {
+    auto segment(std::make_shared<Segment>(*itr, SegmentPath(kDiskPath_, *itr)));
+    segments_.insert(std::make_pair(*itr, segment));
+    ReplaySegment(segment, std::next(itr) == std::end(numbers));
+    if (IsDueCompaction(*segment))
+      ScheduleCompaction();
+  }
+  LOG(kInfo) << "SegmentStore recovered " << index_.size() << " entries from " << segments_.size()
+             << " segments in " << kDiskPath_;
+  StartNewSegment();
+}
+
+// Must be called with mutex_ held.  A torn record at the end of the last segment is left by an
+// interrupted write, and is truncated.  Anywhere else, the rest of the segment is counted as dead.
+void SegmentStore::ReplaySegment(const std::shared_ptr<Segment>& segment, bool is_last) {
+  uint64_t file_size(fs::file_size(segment->path));
+  std::ifstream stream(segment->path.string(), std::ios::binary);
+  Record record;
+  while (segment->size < file_size && ReadRecord(stream, record)) {
+    Location location;
+    location.segment = segment->number;
+    location.offset = segment->size;
+    location.record_size = static_cast<uint32_t>(record.size);
+    location.value_size = static_cast<uint32_t>(record.value.size());
+    segment->size += record.size;
+    Key key(record.key);
+    auto itr(index_.find(key));
+    if (record.type == RecordType::kPut) {
+      if (itr != std::end(index_)) {
+        Kill(itr->second);
+        current_disk_usage_.data -= itr->second.value_size;
+      }
+      index_[key] = location;
+      current_disk_usage_.data += location.value_size;
+    } else {
+      AddTombstone(*segment, record.target_segment, record.size);
+      if (itr != std::end(index_) && itr->second.segment == record.target_segment) {
+        Kill(itr->second);
+        current_disk_usage_.data -= itr->second.value_size;
+        index_.erase(itr);
+      }
+    }
+  }
+  if (segment->size == file_size)
+    return;
+  if (is_last) {
+    LOG(kWarning) << "Truncating " << file_size - segment->size << " bytes of incomplete record "
+                  << "from " << segment->path;
+    fs::resize_file(segment->path, segment->size);
+  } else {
+    LOG(kError) << "Ignoring " << file_size - segment->size << " corrupt bytes in "
+                << segment->path;
+    segment->dead_bytes += file_size - segment->size;
+    segment->size = file_size;
+  }
+}
+
+// Must be called with mutex_ held
+void SegmentStore::StartNewSegment() {
+  uint32_t number(segments_.empty() ? 0 : std::prev(std::end(segments_))->first + 1);
+  active_stream_.close();
+  active_stream_.clear();
+  active_segment_ = std::make_shared<Segment>(number, SegmentPath(kDiskPath_, number));
+  active_stream_.open(active_segment_->path.string(),
+                      std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!active_stream_) {
+    LOG(kError) << "Failed to create segment " << active_segment_->path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  segments_.insert(std::make_pair(number, active_segment_));
+}
+
+SegmentStore::Location SegmentStore::Append(const Record& record) {
+  std::string serialised(Serialise(record));
+  if (active_segment_->size != 0 && active_segment_->size + serialised.size() > kMaxSegmentSize_)
+    StartNewSegment();
+  if (!active_stream_.write(serialised.data(), serialised.size()) || !active_stream_.flush()) {
+    LOG(kError) << "Failed to append to segment " << active_segment_->path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  Location location;
+  location.segment = active_segment_->number;
+  location.offset = active_segment_->size;
+  location.record_size = static_cast<uint32_t>(serialised.size());
+  location.value_size = static_cast<uint32_t>(record.value.size());
+  active_segment_->size += serialised.size();
+  if (record.type == RecordType::kTombstone)
+    AddTombstone(*active_segment_, record.target_segment, serialised.size());
+  return location;
+}
+
+// A tombstone targeting its own segment, or one already removed, isn't needed beyond the segment
+void SegmentStore::AddTombstone(Segment& segment, uint32_t target_segment, uint64_t size) {
+  if (target_segment != segment.number && segments_.count(target_segment) != 0)
+    segment.tombstone_bytes[target_segment] += size;
+  else
+    segment.dead_bytes += size;
+}
+
+void SegmentStore::Kill(const Location& location) {
+  auto itr(segments_.find(location.segment));
+  assert(itr != std::end(segments_));
+  itr->second->dead_bytes += location.record_size;
+  if (itr->second != active_segment_ && IsDueCompaction(*itr->second))
+    ScheduleCompaction();
+}
+
+// The tombstones targeting 'segment' become dead along with it
+void SegmentStore::RemoveSegment(const std::shared_ptr<Segment>& segment) {
+  segment->obsolete = true;
+  segments_.erase(segment->number);
+  for (const auto& remaining : segments_) {
+    auto itr(remaining.second->tombstone_bytes.find(segment->number));
+    if (itr != std::end(remaining.second->tombstone_bytes)) {
+      remaining.second->dead_bytes += itr->second;
+      remaining.second->tombstone_bytes.erase(itr);
+    }
+  }
+}
+
+void SegmentStore::DeleteLocked(std::unordered_map<Key, Location, KeyHash>::iterator itr) {
+  Record tombstone;
+  tombstone.type = RecordType::kTombstone;
+  tombstone.target_segment = itr->second.segment;
+  tombstone.key = itr->first.Serialise();
+  Append(tombstone);
+  Kill(itr->second);
+  current_disk_usage_.data -= itr->second.value_size;
+  index_.erase(itr);
+}
+
+bool SegmentStore::IsDueCompaction(const Segment& segment) const {
+  return static_cast<double>(segment.dead_bytes) >=
+         kCompactionThreshold_ * static_cast<double>(segment.size);
+}
+
+void SegmentStore::ScheduleCompaction() {
+  if (compaction_scheduled_)
+    return;
+  compaction_scheduled_ = true;
+  asio_service_.service().post([this] {
+    try {
+      Compact();
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "SegmentStore compaction failed: " << e.what();
+      std::lock_guard<std::mutex> lock(mutex_);
+      compaction_scheduled_ = false;
+    }
+  });
+}
+
+// The segment is sealed, so can be read without holding mutex_.  Each record is carried over only
+// if it's still live, or for a tombstone, if the segment holding the record it killed remains.
+void SegmentStore::CompactSegment(const std::shared_ptr<Segment>& segment) {
+  std::ifstream stream(segment->path.string(), std::ios::binary);
+  Record record;
+  uint64_t offset(0), carried_bytes(0);
+  while (offset < segment->size && ReadRecord(stream, record)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (record.type == RecordType::kPut) {
+      auto itr(index_.find(Key(record.key)));
+      if (itr != std::end(index_) && itr->second.segment == segment->number &&
+          itr->second.offset == offset) {
+        itr->second = Append(record);
+        carried_bytes += record.size;
+      }
+    } else if (record.target_segment != segment->number &&
+               segments_.count(record.target_segment) != 0) {
+      Append(record);
+      carried_bytes += record.size;
+    }
+    offset += record.size;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  LOG(kVerbose) << "Compacted " << segment->path << ", carrying " << carried_bytes << " of "
+                << segment->size << " bytes";
+  RemoveSegment(segment);
+}
+
+std::string SegmentStore::Serialise(const Record& record) {
+  std::string serialised;
+  serialised.reserve(kHeaderSize + record.key.size() + record.value.size());
+  AppendUint32(kRecordMagic, serialised);
+  serialised.push_back(static_cast<char>(record.type));
+  AppendUint32(record.target_segment, serialised);
+  AppendUint32(static_cast<uint32_t>(record.key.size()), serialised);
+  AppendUint32(static_cast<uint32_t>(record.value.size()), serialised);
+  AppendUint32(Checksum(serialised.data() + 4, kCrcOffset - 4, record.key, record.value),
+               serialised);
+  serialised += record.key;
+  serialised += record.value;
+  return serialised;
+}
+
+bool SegmentStore::ReadRecord(std::istream& stream, Record& record) {
+  char header[kHeaderSize];
+  if (!stream.read(header, kHeaderSize) || ReadUint32(header) != kRecordMagic)
+    return false;
+  record.type = static_cast<RecordType>(header[4]);
+  if (record.type != RecordType::kPut && record.type != RecordType::kTombstone)
+    return false;
+  record.target_segment = ReadUint32(header + 5);
+  uint32_t key_size(ReadUint32(header + 9)), value_size(ReadUint32(header + 13));
+  if (key_size > kMaxKeySize || value_size > kMaxValueSize)
+    return false;
+  record.key.resize(key_size);
+  record.value.resize(value_size);
+  if ((key_size != 0 && !stream.read(&record.key[0], key_size)) ||
+      (value_size != 0 && !stream.read(&record.value[0], value_size))) {
+    return false;
+  }
+  if (Checksum(header + 4, kCrcOffset - 4, record.key, record.value) !=
+      ReadUint32(header + kCrcOffset)) {
+    return false;
+  }
+  record.size = kHeaderSize + key_size + value_size;
+  return true;
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,173 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_PMID_NODE_SEGMENT_STORE_H_
+#define MAIDSAFE_VAULT_PMID_NODE_SEGMENT_STORE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data_name_variant.h"
+
+#include "maidsafe/vault/key.h"
+#include "maidsafe/vault/pmid_node/chunk_view.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// Holds chunks in append-only segment files, rather than a file per chunk as PermanentStore does.
+// Each Put appends a record holding the key and value to the active segment, and each Delete
+// appends a tombstone naming the segment of the record it kills.  An in-memory index maps each key
+// to the location of its value, and is rebuilt on construction by replaying the segments in order.
+//
+// Once the active segment reaches 'max_segment_size' it is sealed and a new one started.  A sealed
+// segment whose dead bytes reach 'compaction_threshold' of its size is compacted in the background:
+// its live records, and any tombstones still needed, are appended to the active segment and the
+// segment file is removed.  Gets only hold the lock while looking up the index, so they can read a
+// segment as it's being compacted; its file is removed once the last such read or view is released.
+//
+// The disk usage limit applies to the size of the stored values, as for PermanentStore.
+class SegmentStore {
+ public:
+  typedef DataNameVariant KeyType;
+
+  // Segment size and compaction threshold are taken from Parameters::segment_store_max_segment_size
+  // and Parameters::segment_store_compaction_threshold.
+  SegmentStore(const boost::filesystem::path& disk_path, DiskUsage max_disk_usage);
+  SegmentStore(const boost::filesystem::path& disk_path, DiskUsage max_disk_usage,
+               uint64_t max_segment_size, double compaction_threshold);
+  ~SegmentStore();
+
+  // Replaces any existing value for 'key'.  Throws if the limit would be exceeded.
+  void Put(const KeyType& key, const NonEmptyString& value);
+  // Throws if 'key' isn't held.
+  NonEmptyString Get(const KeyType& key) const;
+  // As Get, but maps the value rather than copying it.  Throws if 'key' isn't held.
+  ChunkView GetView(const KeyType& key) const;
+  // Throws if 'key' isn't held.
+  void Delete(const KeyType& key);
+
+  std::vector<KeyType> GetKeys() const;
+  boost::filesystem::path GetDiskPath() const;
+  // The size of the stored values, against which the limit is applied
+  DiskUsage GetCurrentDiskUsage() const;
+  // The size of the segment files, including record headers, keys, tombstones and dead records not
+  // yet compacted away
+  DiskUsage GetFootprint() const;
+
+  // Compacts every sealed segment at or over the compaction threshold, returning how many were
+  // compacted.  Normally run in the background after a Delete.
+  size_t Compact();
+
+ private:
+  SegmentStore(const SegmentStore&);
+  SegmentStore& operator=(const SegmentStore&);
+  SegmentStore(SegmentStore&&);
+  SegmentStore& operator=(SegmentStore&&);
+
+  enum class RecordType : uint8_t { kPut = 1, kTombstone = 2 };
+
+  struct Record {
+    Record() : type(RecordType::kPut), target_segment(0), key(), value(), size(0) {}
+    RecordType type;
+    // For a tombstone, the segment holding the record it kills
+    uint32_t target_segment;
+    std::string key, value;
+    // Set by ReadRecord
+    uint64_t size;
+  };
+
+  // The file is removed on destruction once 'obsolete' has been set.  A tombstone is needed until
+  // the segment it targets is removed, so until then its bytes are held in 'tombstone_bytes' under
+  // the target's number rather than counted as dead.
+  struct Segment {
+    Segment(uint32_t number_in, boost::filesystem::path path_in);
+    ~Segment();
+    const uint32_t number;
+    const boost::filesystem::path path;
+    uint64_t size, dead_bytes;
+    std::map<uint32_t, uint64_t> tombstone_bytes;
+    bool obsolete;
+
+   private:
+    Segment(const Segment&);
+    Segment& operator=(const Segment&);
+  };
+
+  struct Location {
+    Location() : segment(0), offset(0), record_size(0), value_size(0) {}
+    uint32_t segment;
+    uint64_t offset;
+    uint32_t record_size, value_size;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  void Recover();
+  void ReplaySegment(const std::shared_ptr<Segment>& segment, bool is_last);
+  void StartNewSegment();
+  // The following must be called with mutex_ held
+  Location Append(const Record& record);
+  void AddTombstone(Segment& segment, uint32_t target_segment, uint64_t size);
+  void Kill(const Location& location);
+  void RemoveSegment(const std::shared_ptr<Segment>& segment);
+  void DeleteLocked(std::unordered_map<Key, Location, KeyHash>::iterator itr);
+  bool IsDueCompaction(const Segment& segment) const;
+  void ScheduleCompaction();
+
+  void CompactSegment(const std::shared_ptr<Segment>& segment);
+
+  static std::string Serialise(const Record& record);
+  // Reads the record at the current position of 'stream'.  Returns false at the end of the stream
+  // or on a truncated or corrupt record.
+  static bool ReadRecord(std::istream& stream, Record& record);
+
+  const boost::filesystem::path kDiskPath_;
+  const DiskUsage kMaxDiskUsage_;
+  const uint64_t kMaxSegmentSize_;
+  const double kCompactionThreshold_;
+  mutable std::mutex mutex_;
+  std::map<uint32_t, std::shared_ptr<Segment>> segments_;
+  std::shared_ptr<Segment> active_segment_;
+  std::ofstream active_stream_;
+  std::unordered_map<Key, Location, KeyHash> index_;
+  DiskUsage current_disk_usage_;
+  bool compaction_scheduled_;
+  std::mutex compaction_mutex_;
+  AsioService asio_service_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_PMID_NODE_SEGMENT_STORE_H_
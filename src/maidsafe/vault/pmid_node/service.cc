@@ -58,14 +58,14 @@ PmidNodeService::PmidNodeService(const passport::Pmid& /*pmid*/, routing::Routin
                                  nfs_client::DataGetter& data_getter,
                                  const fs::path& vault_root_dir, DiskUsage max_disk_usage)
     : routing_(routing),
-      accumulator_mutex_(),
+      accumulator_ingestion_(),
 #ifdef USE_MAL_BEHAVIOUR
       malfunc_behaviour_seed_(RandomUint32()),
 #endif
       dispatcher_(routing_),
       handler_(vault_root_dir, max_disk_usage),
-      active_(),
-      data_getter_(data_getter) {
+      data_getter_(data_getter),
+      worker_pool_() {
   StartUp();
   //  nfs_.GetElementList();  // TODO (Fraser) BEFORE_RELEASE Implementation needed
 }
@@ -82,7 +82,7 @@ void PmidNodeService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template<>
@@ -97,7 +97,7 @@ void PmidNodeService::HandleMessage(
                         return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -112,7 +112,7 @@ void PmidNodeService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template<>
@@ -127,7 +127,7 @@ void PmidNodeService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -163,7 +163,7 @@ void PmidNodeService::HandleMessage(
       accumulator_, [this](const MessageType & message, const MessageType::Sender & sender) {
                       return this->ValidateSender(message, sender);
                     },
-      add_request_predicate, this, accumulator_mutex_)(message, sender, receiver);
+      add_request_predicate, this, accumulator_ingestion_)(message, sender, receiver);
 }
 
 template <>
@@ -178,12 +178,17 @@ void PmidNodeService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 void PmidNodeService::HandleHealthRequest(const NodeId& pmid_manager_node_id,
                                           nfs::MessageId message_id) {
-  LOG(kVerbose) << "PmidNodeService::HandleHealthRequest " << message_id;
+  // The response has no field for it, so the queue depth is only logged here and given by
+  // GetStatistics.
+  LOG(kVerbose) << "PmidNodeService::HandleHealthRequest " << message_id << " with "
+                << worker_pool_.GetStatistics().QueueDepth() << " Gets and checks queued, "
+                << handler_.UsedSpace().data << " bytes used and "
+                << handler_.ReservedSpace().data << " reserved";
   dispatcher_.SendHealthResponse(handler_.AvailableSpace(), pmid_manager_node_id, message_id);
 }
 
@@ -265,6 +270,13 @@ void PmidNodeService::UpdateLocalStorage(const std::vector<DataNameVariant>& to_
   }
 }
 
+detail::ServiceStatistics PmidNodeService::GetStatistics() const {
+  detail::ServiceStatistics statistics;
+  statistics.accumulators["accumulator"] = accumulator_.GetStatistics();
+  statistics.worker_pools["worker_pool"] = worker_pool_.GetStatistics();
+  return statistics;
+}
+
 }  // namespace vault
 
 }  // namespace maidsafe
@@ -30,7 +30,6 @@
 #include "boost/filesystem/path.hpp"
 
 #include "maidsafe/common/types.h"
-#include "maidsafe/common/active.h"
 #include "maidsafe/common/visualiser_log.h"
 #include "maidsafe/common/data_types/data_type_values.h"
 #include "maidsafe/common/data_types/data_name_variant.h"
@@ -38,9 +37,12 @@
 #include "maidsafe/nfs/message_types.h"
 #include "maidsafe/nfs/client/data_getter.h"
 
+#include "maidsafe/vault/ingestion_queue.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/accumulator.h"
+#include "maidsafe/vault/statistics.h"
 #include "maidsafe/vault/types.h"
+#include "maidsafe/vault/worker_pool.h"
 #include "maidsafe/vault/data_manager/integrity_check_data.h"
 #include "maidsafe/vault/pmid_manager/pmid_manager.pb.h"
 #include "maidsafe/vault/pmid_node/handler.h"
@@ -154,6 +156,9 @@ class PmidNodeService {
 
   void HandleChurnEvent(std::shared_ptr<routing::MatrixChange> /*matrix_change*/) {}  // No-op
 
+  // Snapshot of the Accumulator and WorkerPool statistics, safe to call from any thread
+  detail::ServiceStatistics GetStatistics() const;
+
   template <typename Data>
   void HandleDelete(const typename Data::Name& data_name);
 
@@ -189,6 +194,8 @@ class PmidNodeService {
       const std::vector<GetPmidAccountResponseFromPmidManagerToPmidNode>& responses);
   template <typename Data>
   void HandlePut(const Data& data, nfs::MessageId message_id);
+  // Gets and integrity checks are queued on 'worker_pool_', Gets taking precedence.  A Get or check
+  // which is shed gets no response, so it times out at the DataManager.
   template <typename Data>
   void HandleGet(const typename Data::Name& data_name, const NodeId& data_manager_node_id,
                  nfs::MessageId message_id);
@@ -196,6 +203,13 @@ class PmidNodeService {
   void HandleIntegrityCheck(const typename Data::Name& data_name,
                             const NonEmptyString& random_string, const NodeId& sender,
                             nfs::MessageId message_id);
+  template <typename Data>
+  void DoHandleGet(const typename Data::Name& data_name, const NodeId& data_manager_node_id,
+                   nfs::MessageId message_id);
+  template <typename Data>
+  void DoHandleIntegrityCheck(const typename Data::Name& data_name,
+                              const NonEmptyString& random_string, const NodeId& sender,
+                              nfs::MessageId message_id);
 
   void HandleHealthRequest(const NodeId& pmid_manager_node_id, nfs::MessageId message_id);
 
@@ -216,15 +230,16 @@ class PmidNodeService {
                       const std::shared_ptr<NonEmptyString> content);
 
   routing::Routing& routing_;
-  std::mutex accumulator_mutex_;
+  detail::IngestionQueue accumulator_ingestion_;
 #ifdef USE_MAL_BEHAVIOUR
   uint32_t malfunc_behaviour_seed_;
 #endif
   Accumulator<Messages> accumulator_;
   PmidNodeDispatcher dispatcher_;
   PmidNodeHandler handler_;
-  Active active_;
   nfs_client::DataGetter& data_getter_;
+  // Last, so that its threads are joined before the members its tasks use are destroyed
+  detail::WorkerPool worker_pool_;
 };
 
 template <typename MessageType>
@@ -276,16 +291,31 @@ template <typename Data>
 void PmidNodeService::HandleGet(const typename Data::Name& data_name,
                                 const NodeId& data_manager_node_id,
                                 nfs::MessageId message_id) {
+  worker_pool_.Submit(detail::WorkPriority::kHigh,
+                      [=] {
+                        this->DoHandleGet<Data>(data_name, data_manager_node_id, message_id);
+                      },
+                      [=] {
+                        LOG(kWarning) << "PmidNodeService::HandleGet shed Get for "
+                                      << HexSubstr(data_name.value);
+                      });
+}
+
+template <typename Data>
+void PmidNodeService::DoHandleGet(const typename Data::Name& data_name,
+                                  const NodeId& data_manager_node_id,
+                                  nfs::MessageId message_id) {
   try {
-    auto data(handler_.Get<Data>(data_name));
+    // The stored chunk is already in serialised form, so is sent without being parsed.
+    auto chunk(handler_.GetSerialised<Data>(data_name));
 #ifdef USE_MAL_BEHAVIOUR
     LOG(kVerbose) << "PmidNodeService::HandleGet malfunc_behaviour_seed_ is "
                   << malfunc_behaviour_seed_;
     if ((malfunc_behaviour_seed_ % 4) == 0) {
       LOG(kVerbose) << "PmidNodeService::HandleGet generating an incorrect get response";
-      IntegrityCheckData integrity_check_data(RandomString(64), data.Serialise());
+      IntegrityCheckData integrity_check_data(RandomString(64), chunk.data(), chunk.size());
       nfs_vault::DataNameAndContentOrCheckResult data_or_check_result(
-          Data::Name::data_type::Tag::kValue, data.name().value, integrity_check_data.result());
+          Data::Name::data_type::Tag::kValue, data_name.value, integrity_check_data.result());
       dispatcher_.SendGetOrIntegrityCheckResponse(data_or_check_result, data_manager_node_id,
                                                   message_id);
       return;
@@ -293,9 +323,9 @@ void PmidNodeService::HandleGet(const typename Data::Name& data_name,
 #else
     nfs_vault::DataNameAndContentOrCheckResult
         data_or_check_result(Data::Name::data_type::Tag::kValue,
-                             data.name().value, data.Serialise());
-    LOG(kVerbose) << "PmidNodeService::HandleGet got " << HexSubstr(data.name().value)
-                  << " with content " << HexSubstr(data.Serialise().data);
+                             data_name.value, chunk.ToNonEmptyString());
+    LOG(kVerbose) << "PmidNodeService::HandleGet got " << HexSubstr(data_name.value)
+                  << " with " << chunk.size() << " bytes of content";
     dispatcher_.SendGetOrIntegrityCheckResponse(data_or_check_result, data_manager_node_id,
                                                 message_id);
 #endif
@@ -347,8 +377,24 @@ void PmidNodeService::HandleIntegrityCheck(const typename Data::Name& data_name,
                                            const NonEmptyString& random_string,
                                            const NodeId& data_manager_node_id,
                                            nfs::MessageId message_id) {
+  worker_pool_.Submit(detail::WorkPriority::kLow,
+                      [=] {
+                        this->DoHandleIntegrityCheck<Data>(data_name, random_string,
+                                                           data_manager_node_id, message_id);
+                      },
+                      [=] {
+                        LOG(kWarning) << "PmidNodeService::HandleIntegrityCheck shed check for "
+                                      << HexSubstr(data_name.value);
+                      });
+}
+
+template <typename Data>
+void PmidNodeService::DoHandleIntegrityCheck(const typename Data::Name& data_name,
+                                             const NonEmptyString& random_string,
+                                             const NodeId& data_manager_node_id,
+                                             nfs::MessageId message_id) {
   try {
-    auto data(handler_.Get<Data>(data_name));
+    auto chunk(handler_.GetSerialised<Data>(data_name));
     std::string random_seed(random_string.string());
 #ifdef USE_MAL_BEHAVIOUR
     LOG(kVerbose) << "PmidNodeService::HandleIntegrityCheck malfunc_behaviour_seed_ is "
@@ -358,12 +404,12 @@ void PmidNodeService::HandleIntegrityCheck(const typename Data::Name& data_name,
       random_seed = RandomString(64);
     }
 #endif
-    IntegrityCheckData integrity_check_data(random_seed, data.Serialise());
+    IntegrityCheckData integrity_check_data(random_seed, chunk.data(), chunk.size());
     nfs_vault::DataNameAndContentOrCheckResult
-        data_or_check_result(Data::Name::data_type::Tag::kValue, data.name().value,
+        data_or_check_result(Data::Name::data_type::Tag::kValue, data_name.value,
                                  integrity_check_data.result());
     LOG(kVerbose) << "PmidNodeService::HandleIntegrityCheck send back integrity_check_data for "
-                  << HexSubstr(data.name().value);
+                  << HexSubstr(data_name.value);
     dispatcher_.SendGetOrIntegrityCheckResponse(data_or_check_result, data_manager_node_id,
                                                 message_id);
   } catch (const maidsafe_error& error) {
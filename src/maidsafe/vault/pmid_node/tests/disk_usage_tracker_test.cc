@@ -0,0 +1,193 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/pmid_node/disk_usage_tracker.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/on_scope_exit.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/pmid_node/handler.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+uint64_t FilesSize(const boost::filesystem::path& directory) {
+  uint64_t size(0);
+  for (boost::filesystem::directory_iterator itr(directory);
+       itr != boost::filesystem::directory_iterator(); ++itr) {
+    size += boost::filesystem::file_size(itr->path());
+  }
+  return size;
+}
+
+}  // unnamed namespace
+
+TEST_CASE("DiskUsageTracker accounting", "[DiskUsageTracker][PmidNode][Unit]") {
+  uint64_t filesystem_available(10000), samples(0);
+  auto available_space([&]() -> uint64_t {
+    ++samples;
+    return filesystem_available;
+  });
+
+  SECTION("Limited by max disk usage") {
+    DiskUsageTracker tracker(DiskUsage(1000), 0.1, std::chrono::hours(1), available_space);
+    CHECK(samples == 1U);
+    CHECK(tracker.Reserved() == DiskUsage(100));
+    CHECK(tracker.StoreLimit() == DiskUsage(900));
+    CHECK(tracker.Free() == DiskUsage(900));
+    tracker.SetUsed(DiskUsage(400));
+    CHECK(tracker.Used() == DiskUsage(400));
+    CHECK(tracker.Free() == DiskUsage(500));
+    tracker.SetUsed(DiskUsage(950));
+    CHECK(tracker.Free() == DiskUsage(0));
+    tracker.SetUsed(DiskUsage(0));
+    CHECK(tracker.Free() == DiskUsage(900));
+    CHECK(samples == 1U);
+  }
+
+  SECTION("Limited by the filesystem") {
+    filesystem_available = 600;
+    DiskUsageTracker tracker(DiskUsage(1000), 0.1, std::chrono::hours(1), available_space);
+    CHECK(tracker.Free() == DiskUsage(500));
+    // Writes since the last sample are taken off the filesystem's space
+    tracker.SetUsed(DiskUsage(200));
+    CHECK(tracker.Free() == DiskUsage(300));
+    // but space freed isn't counted until the next
+    tracker.SetUsed(DiskUsage(100));
+    CHECK(tracker.Free() == DiskUsage(400));
+    filesystem_available = 700;
+    tracker.Reconcile();
+    CHECK(samples == 2U);
+    CHECK(tracker.Free() == DiskUsage(600));
+    filesystem_available = 50;
+    tracker.Reconcile();
+    CHECK(tracker.Free() == DiskUsage(0));
+  }
+
+  SECTION("Reconciles once the interval has elapsed") {
+    DiskUsageTracker tracker(DiskUsage(1000), 0.1, std::chrono::steady_clock::duration::zero(),
+                             available_space);
+    filesystem_available = 300;
+    CHECK(tracker.Free() == DiskUsage(200));
+    CHECK(samples == 2U);
+  }
+}
+
+TEST_CASE("PmidNodeHandler with a SegmentStore under churn",
+          "[DiskUsageTracker][SegmentStore][PmidNode][Behavioural]") {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault"));
+  const auto segment_store(detail::Parameters::pmid_node_segment_store);
+  const auto max_segment_size(detail::Parameters::segment_store_max_segment_size);
+  on_scope_exit restore_parameters([=] {
+    detail::Parameters::pmid_node_segment_store = segment_store;
+    detail::Parameters::segment_store_max_segment_size = max_segment_size;
+  });
+  detail::Parameters::pmid_node_segment_store = true;
+  // A single segment, so that background compaction leaves the files alone
+  detail::Parameters::segment_store_max_segment_size = 1 << 20;
+  PmidNodeHandler handler(*test_path, DiskUsage(1 << 20));
+
+  std::vector<ImmutableData> chunks;
+  for (int i(0); i != 20; ++i) {
+    chunks.emplace_back(NonEmptyString(RandomString(1000)));
+    handler.Put(chunks.back());
+    CHECK(handler.UsedSpace() == DiskUsage(FilesSize(handler.GetDiskPath())));
+  }
+  for (const auto& chunk : chunks)
+    handler.Delete(chunk.name());
+
+  // Nothing is live, but the deleted values and their tombstones are still on disk
+  CHECK(handler.GetAllDataNames().empty());
+  auto files_size(FilesSize(handler.GetDiskPath()));
+  CHECK(handler.UsedSpace() == DiskUsage(files_size));
+  CHECK(files_size > 20 * 1000U);
+  CHECK(handler.AvailableSpace().data ==
+        (1U << 20) - handler.ReservedSpace().data - files_size);
+}
+
+TEST_CASE("PmidNodeHandler reports space freed by SegmentStore compaction",
+          "[DiskUsageTracker][SegmentStore][PmidNode][Behavioural]") {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault"));
+  const auto segment_store(detail::Parameters::pmid_node_segment_store);
+  const auto max_segment_size(detail::Parameters::segment_store_max_segment_size);
+  const auto compaction_threshold(detail::Parameters::segment_store_compaction_threshold);
+  on_scope_exit restore_parameters([=] {
+    detail::Parameters::pmid_node_segment_store = segment_store;
+    detail::Parameters::segment_store_max_segment_size = max_segment_size;
+    detail::Parameters::segment_store_compaction_threshold = compaction_threshold;
+  });
+  detail::Parameters::pmid_node_segment_store = true;
+  // Small segments, so that there are many to compact
+  detail::Parameters::segment_store_max_segment_size = 4096;
+  const DiskUsage max_disk_usage(4 << 20);
+
+  {
+    // Fill the store and kill most of it, with compaction disabled
+    detail::Parameters::segment_store_compaction_threshold = 2.0;
+    PmidNodeHandler handler(*test_path, max_disk_usage);
+    std::vector<ImmutableData> chunks;
+    for (int i(0); i != 300; ++i) {
+      chunks.emplace_back(NonEmptyString(RandomString(1000)));
+      handler.Put(chunks.back());
+    }
+    for (int i(0); i != 300; ++i) {
+      if (i % 3 != 0)
+        handler.Delete(chunks[i].name());
+    }
+    CHECK(handler.UsedSpace() == DiskUsage(FilesSize(handler.GetDiskPath())));
+  }
+
+  // Reopening schedules compaction of every sealed segment, which then runs in the background
+  detail::Parameters::segment_store_compaction_threshold = 0.5;
+  PmidNodeHandler handler(*test_path, max_disk_usage);
+  auto size_before_compaction(FilesSize(handler.GetDiskPath()));
+  auto files_size(size_before_compaction);
+  for (int i(0); i != 500; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto new_files_size(FilesSize(handler.GetDiskPath()));
+    if (new_files_size == files_size && files_size < size_before_compaction)
+      break;
+    files_size = new_files_size;
+  }
+  REQUIRE(files_size < size_before_compaction);
+  CHECK(handler.UsedSpace() == DiskUsage(files_size));
+  CHECK(handler.AvailableSpace().data ==
+        max_disk_usage.data - handler.ReservedSpace().data - files_size);
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,167 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/pmid_node/segment_store.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+SegmentStore::KeyType MakeKey() {
+  return GetDataNameVariant(DataTagValue::kImmutableDataValue, Identity(RandomString(64)));
+}
+
+size_t SegmentCount(const fs::path& disk_path) {
+  size_t count(0);
+  for (fs::directory_iterator itr(disk_path); itr != fs::directory_iterator(); ++itr)
+    ++count;
+  return count;
+}
+
+}  // unnamed namespace
+
+TEST_CASE("SegmentStore put, get and delete", "[SegmentStore][PmidNode][Behavioural]") {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault"));
+  fs::path disk_path(*test_path / "segments");
+  SegmentStore store(disk_path, DiskUsage(1 << 20), 4096, 0.5);
+  auto key(MakeKey());
+  NonEmptyString value(RandomString(100));
+
+  CHECK_THROWS_AS(store.Get(key), maidsafe_error);
+  CHECK_THROWS_AS(store.Delete(key), maidsafe_error);
+  REQUIRE_NOTHROW(store.Put(key, value));
+  CHECK(store.Get(key) == value);
+  CHECK(store.GetCurrentDiskUsage() == DiskUsage(100));
+  CHECK(store.GetKeys().size() == 1U);
+
+  SECTION("Overwrite") {
+    NonEmptyString new_value(RandomString(50));
+    REQUIRE_NOTHROW(store.Put(key, new_value));
+    CHECK(store.Get(key) == new_value);
+    CHECK(store.GetCurrentDiskUsage() == DiskUsage(50));
+  }
+
+  SECTION("Delete") {
+    REQUIRE_NOTHROW(store.Delete(key));
+    CHECK_THROWS_AS(store.Get(key), maidsafe_error);
+    CHECK(store.GetCurrentDiskUsage() == DiskUsage(0));
+    CHECK(store.GetKeys().empty());
+  }
+
+  SECTION("View") {
+    auto view(store.GetView(key));
+    CHECK(std::string(view.data(), view.size()) == value.string());
+    CHECK(view.ToNonEmptyString() == value);
+    // The view outlives the record being deleted and its segment being compacted away.
+    REQUIRE_NOTHROW(store.Delete(key));
+    store.Compact();
+    CHECK(std::string(view.data(), view.size()) == value.string());
+    CHECK_THROWS_AS(store.GetView(key), maidsafe_error);
+  }
+
+  SECTION("Limit") {
+    CHECK_THROWS_AS(store.Put(MakeKey(), NonEmptyString(RandomString(1 << 20))), maidsafe_error);
+    CHECK(store.GetCurrentDiskUsage() == DiskUsage(100));
+  }
+}
+
+TEST_CASE("SegmentStore recovery and compaction", "[SegmentStore][PmidNode][Behavioural]") {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault"));
+  fs::path disk_path(*test_path / "segments");
+  std::vector<std::pair<SegmentStore::KeyType, NonEmptyString>> entries;
+  for (int i(0); i != 200; ++i)
+    entries.emplace_back(MakeKey(), NonEmptyString(RandomString(100)));
+
+  size_t segment_count(0);
+  {
+    SegmentStore store(disk_path, DiskUsage(1 << 20), 4096, 0.5);
+    for (const auto& entry : entries)
+      store.Put(entry.first, entry.second);
+    segment_count = SegmentCount(disk_path);
+    REQUIRE(segment_count > 2U);
+    for (size_t i(0); i < entries.size(); i += 2)
+      store.Delete(entries[i].first);
+    store.Compact();
+    CHECK(SegmentCount(disk_path) < segment_count);
+    for (size_t i(1); i < entries.size(); i += 2)
+      CHECK(store.Get(entries[i].first) == entries[i].second);
+  }
+
+  SECTION("Reopen") {
+    SegmentStore store(disk_path, DiskUsage(1 << 20), 4096, 0.5);
+    CHECK(store.GetKeys().size() == entries.size() / 2);
+    CHECK(store.GetCurrentDiskUsage() == DiskUsage(100 * entries.size() / 2));
+    for (size_t i(0); i < entries.size(); ++i) {
+      if (i % 2 == 0)
+        CHECK_THROWS_AS(store.Get(entries[i].first), maidsafe_error);
+      else
+        CHECK(store.Get(entries[i].first) == entries[i].second);
+    }
+  }
+
+  SECTION("Delete everything") {
+    {
+      SegmentStore store(disk_path, DiskUsage(1 << 20), 4096, 0.5);
+      for (size_t i(1); i < entries.size(); i += 2)
+        store.Delete(entries[i].first);
+      store.Compact();
+      CHECK(SegmentCount(disk_path) == 1U);
+    }
+    SegmentStore store(disk_path, DiskUsage(1 << 20), 4096, 0.5);
+    CHECK(store.GetKeys().empty());
+  }
+
+  SECTION("Torn write") {
+    // A threshold of 1.0 stops background compaction appending after the record to be torn.
+    {
+      SegmentStore store(disk_path, DiskUsage(1 << 20), 4096, 1.0);
+      store.Put(entries[0].first, entries[0].second);
+    }
+    fs::path last_segment;
+    for (fs::directory_iterator itr(disk_path); itr != fs::directory_iterator(); ++itr) {
+      if (itr->path() > last_segment)
+        last_segment = itr->path();
+    }
+    fs::resize_file(last_segment, fs::file_size(last_segment) - 10);
+    SegmentStore store(disk_path, DiskUsage(1 << 20), 4096, 1.0);
+    CHECK_THROWS_AS(store.Get(entries[0].first), maidsafe_error);
+    CHECK(store.Get(entries[1].first) == entries[1].second);
+  }
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
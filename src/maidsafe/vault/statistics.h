@@ -0,0 +1,68 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_STATISTICS_H_
+#define MAIDSAFE_VAULT_STATISTICS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "maidsafe/vault/histogram.h"
+#include "maidsafe/vault/pending_request_limits.h"
+#include "maidsafe/vault/worker_pool.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Kept by a Sync.  Times are measured from the arrival of an action's first entry.  'attempts'
+// records how many times each action from this node had been resent by the time it was resolved on
+// all peers.  'unresolved_count' is as at the time of the snapshot.
+struct SyncStatistics {
+  SyncStatistics()
+      : time_to_quorum(), time_to_all_peers(), attempts(), unresolved_count(0),
+        resolved_on_all_peers(0), dropped_after_max_attempts(0) {}
+  Histogram time_to_quorum;
+  Histogram time_to_all_peers;
+  Histogram attempts;
+  size_t unresolved_count;
+  uint64_t resolved_on_all_peers;
+  uint64_t dropped_after_max_attempts;
+};
+
+// A snapshot of a persona service's Accumulators, Syncs and WorkerPools, each named after the
+// member holding it.
+struct ServiceStatistics {
+  ServiceStatistics() : accumulators(), syncs(), worker_pools() {}
+  std::map<std::string, PendingRequestStatistics> accumulators;
+  std::map<std::string, SyncStatistics> syncs;
+  std::map<std::string, WorkerPoolStatistics> worker_pools;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_STATISTICS_H_
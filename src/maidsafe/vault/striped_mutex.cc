@@ -0,0 +1,74 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/striped_mutex.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+StripedMutex::StripedMutex(size_t stripe_count) : mutexes_() {
+  mutexes_.reserve(std::max(stripe_count, static_cast<size_t>(1)));
+  do {
+    mutexes_.emplace_back(new std::mutex);
+  } while (mutexes_.size() < stripe_count);
+}
+
+StripedMutex::Lock StripedMutex::LockName(const std::string& name) {
+  return Lock(*mutexes_[StripeIndex(name)]);
+}
+
+std::vector<StripedMutex::Lock> StripedMutex::LockNames(const std::vector<std::string>& names) {
+  std::vector<size_t> indices;
+  indices.reserve(names.size());
+  for (const auto& name : names)
+    indices.push_back(StripeIndex(name));
+  std::sort(std::begin(indices), std::end(indices));
+  indices.erase(std::unique(std::begin(indices), std::end(indices)), std::end(indices));
+  std::vector<Lock> locks;
+  locks.reserve(indices.size());
+  for (const auto& index : indices)
+    locks.emplace_back(*mutexes_[index]);
+  return locks;
+}
+
+std::vector<StripedMutex::Lock> StripedMutex::LockAll() {
+  std::vector<Lock> locks;
+  locks.reserve(mutexes_.size());
+  for (auto& mutex : mutexes_)
+    locks.emplace_back(*mutex);
+  return locks;
+}
+
+size_t StripedMutex::StripeIndex(const std::string& name) const {
+  if (mutexes_.size() == 1)
+    return 0;
+  return std::hash<std::string>()(name) % mutexes_.size();
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,65 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_STRIPED_MUTEX_H_
+#define MAIDSAFE_VAULT_STRIPED_MUTEX_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// A fixed set of mutexes, each guarding the names which hash to it.  Operations on names in
+// different stripes can run concurrently, while a single stripe behaves as one global mutex.
+// Where several stripes are needed at once, they are always locked in ascending index order.
+class StripedMutex {
+ public:
+  typedef std::unique_lock<std::mutex> Lock;
+
+  explicit StripedMutex(size_t stripe_count);
+
+  Lock LockName(const std::string& name);
+  std::vector<Lock> LockNames(const std::vector<std::string>& names);
+  std::vector<Lock> LockAll();
+  size_t StripeIndex(const std::string& name) const;
+  size_t stripe_count() const { return mutexes_.size(); }
+
+ private:
+  StripedMutex(const StripedMutex&);
+  StripedMutex& operator=(const StripedMutex&);
+  StripedMutex(StripedMutex&&);
+  StripedMutex& operator=(StripedMutex&&);
+
+  std::vector<std::unique_ptr<std::mutex>> mutexes_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_STRIPED_MUTEX_H_
@@ -20,14 +20,24 @@
 #define MAIDSAFE_VAULT_SYNC_H_
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <iterator>
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "maidsafe/common/node_id.h"
 
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/statistics.h"
+#include "maidsafe/vault/unresolved_action.h"
+
 namespace maidsafe {
 
 namespace vault {
@@ -36,6 +46,11 @@ namespace vault {
 // recording the corresponding unresolved_action to a Persona's database.  This should ensure that
 // all peers
 // hold similar, if not identical databases.
+// Unresolved actions are indexed by serialised key so that adding one only examines those sharing
+// its key.  Each has a retry deadline, first Parameters::sync_retry_initial_interval after it's
+// added and then doubling up to Parameters::sync_retry_max_interval.  An action is dropped once
+// it has reached its deadline Parameters::max_sync_attempts times without being resolved on all
+// peers.  Times to resolution, resend attempts and drops are kept in a SyncStatistics.
 template <typename UnresolvedAction>
 class Sync {
  public:
@@ -59,10 +74,12 @@ class Sync {
   // is provided
   // with just this node's ID inserted, even if the master copy has several other peers' IDs.
   std::vector<std::unique_ptr<UnresolvedAction>> GetUnresolvedActions() const;
-  // Calling this will increment the sync counter and delete actions that reach the
-  // 'kSyncCounterMax_' limit.  Actions which are resolved by all peers (i.e. have 4 messages) are
-  // also pruned here.
-  void IncrementSyncAttempts();
+  // Returns copies of this node's actions whose retry deadline is at or before 'now', to be
+  // resent, and sets their next deadline.  Actions which have used all their attempts, or which
+  // are resolved by all peers (i.e. have 4 messages), are pruned here.
+  std::vector<std::unique_ptr<UnresolvedAction>> GetActionsDueForResend(
+      std::chrono::steady_clock::time_point now);
+  detail::SyncStatistics GetStatistics() const;
 
   static const nfs::MessageAction kActionId = UnresolvedAction::ActionType::kActionId;
 
@@ -70,12 +87,44 @@ class Sync {
   Sync(Sync&&);
   Sync(const Sync&);
   Sync& operator=(Sync other);
-  bool CanBeErased(const UnresolvedAction& unresolved_action) const;
+
+  typedef std::chrono::steady_clock::time_point TimePoint;
+  struct Entry;
+  typedef std::list<Entry> Entries;
+  typedef std::multimap<TimePoint, typename Entries::iterator> RetryQueue;
+  struct Entry {
+    Entry(std::unique_ptr<UnresolvedAction> unresolved_action_in, std::string index_key_in,
+          TimePoint first_added_in)
+        : unresolved_action(std::move(unresolved_action_in)),
+          index_key(std::move(index_key_in)),
+          first_added(first_added_in),
+          attempts(0),
+          retry_interval(),
+          retry_itr() {}
+    std::unique_ptr<UnresolvedAction> unresolved_action;
+    std::string index_key;
+    TimePoint first_added;
+    int attempts;
+    std::chrono::milliseconds retry_interval;
+    typename RetryQueue::iterator retry_itr;
+  };
+  // Entries sharing a key, in insertion order
+  typedef std::unordered_map<std::string, std::vector<typename Entries::iterator>> Index;
+
+  void ScheduleFirstRetry(typename Entries::iterator entry);
+  void OnEntryAppended(typename Entries::iterator entry, bool resolved, TimePoint now);
+  void Erase(typename Entries::iterator entry);
 
   mutable std::mutex mutex_;
-  std::vector<std::unique_ptr<UnresolvedAction>> unresolved_actions_;
-  NodeId node_id_;
-  static const int32_t kSyncCounterMax_ = 10;  // TODO(dirvine) decide how to decide on this number.
+  Entries unresolved_actions_;
+  Index index_;
+  RetryQueue retry_queue_;
+  // Entries resolved on all peers since the last GetActionsDueForResend
+  std::vector<typename Entries::iterator> resolved_on_all_peers_;
+  detail::InlineNodeId node_id_;
+  detail::SyncStatistics statistics_;
+  const std::chrono::milliseconds kInitialRetryInterval_, kMaxRetryInterval_;
+  const int kMaxSyncAttempts_;
 };
 
 // ==================== Implementation =============================================================
@@ -83,47 +132,44 @@ namespace detail {
 
 template <typename UnresolvedAction>
 bool IsFromThisNode(const UnresolvedAction& unresolved_action) {
-  return (unresolved_action.this_node_and_entry_id != nullptr);
+  return unresolved_action.HasThisNodeEntry();
 }
 
 template <typename UnresolvedAction>
 bool IsRecorded(const UnresolvedAction& new_action, const UnresolvedAction& existing_action) {
-  assert(IsFromThisNode(new_action) ? new_action.peer_and_entry_ids.empty()
-                                    : new_action.peer_and_entry_ids.size() == 1U);
+  assert(IsFromThisNode(new_action) ? new_action.PeerCount() == 0U
+                                    : new_action.PeerCount() == 1U);
   if (IsFromThisNode(new_action)) {
-    if (!existing_action.this_node_and_entry_id)
+    if (!existing_action.HasThisNodeEntry())
       return false;
-    assert(new_action.this_node_and_entry_id->first ==
-           existing_action.this_node_and_entry_id->first);
-    return (new_action.this_node_and_entry_id->second ==
-              existing_action.this_node_and_entry_id->second);
+    assert(new_action.this_node_entry().node_id == existing_action.this_node_entry().node_id);
+    return new_action.this_node_entry().entry_id == existing_action.this_node_entry().entry_id;
   }
+  return existing_action.HasPeerEntry(new_action.first_peer_entry());
+}
 
-  auto new_coming(new_action.peer_and_entry_ids.front());
-  return std::any_of(std::begin(existing_action.peer_and_entry_ids),
-                     std::end(existing_action.peer_and_entry_ids),
-                     [&new_coming](const std::pair<NodeId, int32_t> &
-                                   test) { return test == new_coming; });
+template <typename UnresolvedAction>
+size_t TotalReceived(const UnresolvedAction& unresolved_action) {
+  return unresolved_action.received.count();
 }
 
 template <typename UnresolvedAction>
 bool IsResolved(const UnresolvedAction& unresolved_action) {
   // Received syncs from at least majority of peers(including itself)
   // Shall have tri-state : unresolved, resolved, already-resolved
-  // However, as IsResolved get called only once, here use strict "==" to differentiate
-  uint16_t total_received = static_cast<uint16_t>(unresolved_action.peer_and_entry_ids.size() +
-           (unresolved_action.this_node_and_entry_id ? 1U : 0U));
+  // However, as each entry is appended once and IsResolved is checked after every append, the
+  // strict "==" reports the quorum only on the append which reaches it.
+  size_t total_received(TotalReceived(unresolved_action));
   LOG(kVerbose) << "IsResolved  total_received : " << total_received;
   return (total_received == ((routing::Parameters::group_size / 2) + 1U));
 }
 
 template <typename UnresolvedAction>
 bool IsResolvedOnAllPeers(const UnresolvedAction& unresolved_action) {
-  bool result(unresolved_action.this_node_and_entry_id &&
-              (unresolved_action.peer_and_entry_ids.size() ==
-                 (routing::Parameters::group_size - 1U)));
-  LOG(kVerbose) << "IsResolvedOnAllPeers " << result << " peer_and_entry_ids.size() : "
-                << unresolved_action.peer_and_entry_ids.size();
+  bool result(unresolved_action.HasThisNodeEntry() &&
+              (unresolved_action.PeerCount() == (routing::Parameters::group_size - 1U)));
+  LOG(kVerbose) << "IsResolvedOnAllPeers " << result << " peer count : "
+                << unresolved_action.PeerCount();
   return result;
 }
 
@@ -132,35 +178,22 @@ void AppendUnresolvedActionEntry(const UnresolvedAction& new_action,
                                  UnresolvedAction& existing_action,
                                  std::unique_ptr<UnresolvedAction>& resolved_action) {
   assert(IsFromThisNode(new_action)
-         ? !existing_action.this_node_and_entry_id
-         : existing_action.peer_and_entry_ids.size() < (routing::Parameters::group_size -1U));
+         ? !existing_action.HasThisNodeEntry()
+         : existing_action.PeerCount() < (routing::Parameters::group_size - 1U));
 
-  if (IsFromThisNode(new_action)) {
-    existing_action.this_node_and_entry_id =
-        std::make_shared<std::pair<NodeId, int32_t>>(*new_action.this_node_and_entry_id);
-  } else {
-    existing_action.peer_and_entry_ids.push_back(new_action.peer_and_entry_ids.front());
-  }
+  if (IsFromThisNode(new_action))
+    existing_action.SetThisNodeEntry(new_action.this_node_entry());
+  else
+    existing_action.AddPeerEntry(new_action.first_peer_entry());
   if (IsResolved(existing_action))
     resolved_action.reset(new UnresolvedAction(existing_action));
 }
 
-template <typename UnresolvedAction>
-void AddNewUnresolvedAction(const UnresolvedAction& new_action,
-    std::vector<std::unique_ptr<UnresolvedAction>>& unresolved_actions) {
-  std::unique_ptr<UnresolvedAction> unresolved_action_ptr(new UnresolvedAction(new_action));
-  unresolved_actions.push_back(std::move(unresolved_action_ptr));
-}
-
 template <typename UnresolvedAction>
 bool HaveEntryFromPeer(const UnresolvedAction& new_action,
                        const UnresolvedAction& existing_action) {
-  assert(!new_action.this_node_and_entry_id && "to be used only for assessing action from peers");
-  for (const auto& i : existing_action.peer_and_entry_ids) {
-    if (i.first == new_action.peer_and_entry_ids.front().first)
-      return true;
-  }
-  return false;
+  assert(!new_action.HasThisNodeEntry() && "to be used only for assessing action from peers");
+  return existing_action.HasEntryFromPeer(new_action.first_peer_entry().node_id);
 }
 
 }  // namespace detail
@@ -170,60 +203,79 @@ const nfs::MessageAction Sync<UnresolvedAction>::kActionId;
 
 template <typename UnresolvedAction>
 Sync<UnresolvedAction>::Sync(NodeId node_id)
-    : mutex_(), unresolved_actions_(), node_id_(node_id) {}
+    : mutex_(),
+      unresolved_actions_(),
+      index_(),
+      retry_queue_(),
+      resolved_on_all_peers_(),
+      node_id_(node_id),
+      statistics_(),
+      kInitialRetryInterval_(detail::Parameters::sync_retry_initial_interval),
+      kMaxRetryInterval_(detail::Parameters::sync_retry_max_interval),
+      kMaxSyncAttempts_(detail::Parameters::max_sync_attempts) {
+  assert(routing::Parameters::group_size <= UnresolvedAction::kMaxGroupSize);
+}
 
 template <typename UnresolvedAction>
 std::unique_ptr<UnresolvedAction> Sync<UnresolvedAction>::AddUnresolvedAction(
     const UnresolvedAction& unresolved_action) {
+  std::string index_key(unresolved_action.key.Serialise());
   std::lock_guard<std::mutex> lock(mutex_);
+  auto now(std::chrono::steady_clock::now());
   std::unique_ptr<UnresolvedAction> resolved_action;
-  auto found(std::begin(unresolved_actions_));
-  for (;;) {
-    found = std::find_if(found, std::end(unresolved_actions_),
-                         [&unresolved_action](const std::unique_ptr<UnresolvedAction>& test) {
-                             return ((test->key == unresolved_action.key) &&
-                                     (test->action == unresolved_action.action));
-                         });
-    if (found == std::end(unresolved_actions_)) {  // not found
-      if (unresolved_action.WasSeen(node_id_)) {
-        LOG(kWarning) << "AddAction " << kActionId << " received an async msg for erased entry";
-        break;  // done here
-      }
-      LOG(kVerbose) << "AddAction " << kActionId << " inserted as first entry of unresolved";
-      detail::AddNewUnresolvedAction(unresolved_action, unresolved_actions_);
-      break;  // done here
-    }
+  auto& same_key_entries(index_[index_key]);
+  for (const auto& entry : same_key_entries) {
+    auto& found(*entry->unresolved_action);
+    if (!(found.action == unresolved_action.action))
+      continue;
 
     // found same action and key
-    if (detail::IsRecorded(unresolved_action, (**found))) {
+    if (detail::IsRecorded(unresolved_action, found)) {
       LOG(kVerbose) << "AddAction " << kActionId << " dropped silently as it was recorded";
-      break;  // done here
+      return std::move(resolved_action);
     }
     LOG(kVerbose) << "AddAction " << kActionId << " not recorded from the sender";
 
     // check if already received from self and add
     if (detail::IsFromThisNode(unresolved_action)) {
-      if (!(*found)->this_node_and_entry_id) {
+      if (!found.HasThisNodeEntry()) {
         LOG(kVerbose) << "AddAction " << kActionId << " appended to unresolved";
-        detail::AppendUnresolvedActionEntry(unresolved_action, **found, resolved_action);
-        break;  // done here
-      } else {  // It must be different entry id so add separate unresolved entry
-        assert((*found)->this_node_and_entry_id != unresolved_action.this_node_and_entry_id);
-        ++found;
-        continue;
+        detail::AppendUnresolvedActionEntry(unresolved_action, found, resolved_action);
+        OnEntryAppended(entry, resolved_action != nullptr, now);
+        // This node has only just sent its copy, so its retries start afresh
+        retry_queue_.erase(entry->retry_itr);
+        ScheduleFirstRetry(entry);
+        return std::move(resolved_action);
       }
+      // It must be different entry id so add separate unresolved entry
+      assert(found.this_node_entry().entry_id != unresolved_action.this_node_entry().entry_id);
+      continue;
     }
 
     // check if already received 3 entries from other nodes if not then add or else continue
-    if (((*found)->peer_and_entry_ids.size() < (routing::Parameters::group_size - 1U)) &&
-            !detail::HaveEntryFromPeer(unresolved_action, **found)) {
+    if ((found.PeerCount() < (routing::Parameters::group_size - 1U)) &&
+            !detail::HaveEntryFromPeer(unresolved_action, found)) {
       LOG(kVerbose) << "AddAction " << kActionId << " appended to unresolved";
-      detail::AppendUnresolvedActionEntry(unresolved_action, **found, resolved_action);
-      break;
+      detail::AppendUnresolvedActionEntry(unresolved_action, found, resolved_action);
+      OnEntryAppended(entry, resolved_action != nullptr, now);
+      return std::move(resolved_action);
     }
+  }
 
-    ++found;
-  }  // loop only if not acted on action
+  // not found
+  if (unresolved_action.WasSeen(node_id_)) {
+    LOG(kWarning) << "AddAction " << kActionId << " received an async msg for erased entry";
+    if (same_key_entries.empty())
+      index_.erase(index_key);
+    return std::move(resolved_action);
+  }
+  LOG(kVerbose) << "AddAction " << kActionId << " inserted as first entry of unresolved";
+  unresolved_actions_.emplace_back(
+      std::unique_ptr<UnresolvedAction>(new UnresolvedAction(unresolved_action)),
+      std::move(index_key), now);
+  auto entry(std::prev(std::end(unresolved_actions_)));
+  same_key_entries.push_back(entry);
+  ScheduleFirstRetry(entry);
   return std::move(resolved_action);
 }
 
@@ -232,12 +284,14 @@ std::vector<std::unique_ptr<UnresolvedAction>>
     Sync<UnresolvedAction>::GetUnresolvedActions() const {
   std::lock_guard<std::mutex> lock(mutex_);
   std::vector<std::unique_ptr<UnresolvedAction>> result;
-  for (const auto& unresolved_action : unresolved_actions_) {
+  for (const auto& entry : unresolved_actions_) {
+    const auto& unresolved_action(entry.unresolved_action);
     if (detail::IsResolvedOnAllPeers(*unresolved_action))
       continue;
     if (detail::IsFromThisNode(*unresolved_action)) {
       LOG(kVerbose) << "GetUnresolvedActions " << kActionId << " found one unresolved record";
       std::unique_ptr<UnresolvedAction> action_ptr(new UnresolvedAction(*unresolved_action));
+      action_ptr->sync_counter = entry.attempts;
       result.push_back(std::move(action_ptr));
     }
   }
@@ -245,27 +299,84 @@ std::vector<std::unique_ptr<UnresolvedAction>>
 }
 
 template <typename UnresolvedAction>
-bool Sync<UnresolvedAction>::CanBeErased(const UnresolvedAction& unresolved_action) const {
-  bool result(unresolved_action.sync_counter > kSyncCounterMax_ ||
-              detail::IsResolvedOnAllPeers(unresolved_action));
-  LOG(kVerbose) << "Action " << kActionId << " CanBeErased " << result;
+std::vector<std::unique_ptr<UnresolvedAction>> Sync<UnresolvedAction>::GetActionsDueForResend(
+    std::chrono::steady_clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& entry : resolved_on_all_peers_) {
+    LOG(kVerbose) << "Action " << kActionId << " erased as resolved on all peers";
+    statistics_.attempts.Record(static_cast<uint64_t>(entry->attempts));
+    ++statistics_.resolved_on_all_peers;
+    Erase(entry);
+  }
+  resolved_on_all_peers_.clear();
+
+  std::vector<std::unique_ptr<UnresolvedAction>> result;
+  while (!retry_queue_.empty() && std::begin(retry_queue_)->first <= now) {
+    auto entry(std::begin(retry_queue_)->second);
+    retry_queue_.erase(std::begin(retry_queue_));
+    assert(entry->unresolved_action->PeerCount() <= routing::Parameters::group_size - 1U);
+    if (++entry->attempts > kMaxSyncAttempts_) {
+      LOG(kVerbose) << "Action " << kActionId << " erased after " << kMaxSyncAttempts_
+                    << " sync attempts";
+      entry->retry_itr = std::end(retry_queue_);
+      ++statistics_.dropped_after_max_attempts;
+      Erase(entry);
+      continue;
+    }
+    if (detail::IsFromThisNode(*entry->unresolved_action)) {
+      std::unique_ptr<UnresolvedAction> action_ptr(new UnresolvedAction(*entry->unresolved_action));
+      action_ptr->sync_counter = entry->attempts;
+      result.push_back(std::move(action_ptr));
+    }
+    entry->retry_interval = std::min(entry->retry_interval * 2, kMaxRetryInterval_);
+    entry->retry_itr = retry_queue_.insert(std::make_pair(now + entry->retry_interval, entry));
+  }
   return result;
 }
 
 template <typename UnresolvedAction>
-void Sync<UnresolvedAction>::IncrementSyncAttempts() {
+detail::SyncStatistics Sync<UnresolvedAction>::GetStatistics() const {
   std::lock_guard<std::mutex> lock(mutex_);
-  auto itr = std::begin(unresolved_actions_);
-  while (itr != std::end(unresolved_actions_)) {
-    assert((*itr)->peer_and_entry_ids.size() <= routing::Parameters::group_size - 1U);
-    ++(*itr)->sync_counter;
-    if (CanBeErased(**itr))
-      itr = unresolved_actions_.erase(itr);
-    else
-      ++itr;
+  auto statistics(statistics_);
+  statistics.unresolved_count = unresolved_actions_.size();
+  return statistics;
+}
+
+// Must be called with mutex_ held
+template <typename UnresolvedAction>
+void Sync<UnresolvedAction>::ScheduleFirstRetry(typename Entries::iterator entry) {
+  entry->attempts = 0;
+  entry->retry_interval = kInitialRetryInterval_;
+  entry->retry_itr = retry_queue_.insert(
+      std::make_pair(std::chrono::steady_clock::now() + entry->retry_interval, entry));
+}
+
+// Must be called with mutex_ held
+template <typename UnresolvedAction>
+void Sync<UnresolvedAction>::OnEntryAppended(typename Entries::iterator entry, bool resolved,
+                                             TimePoint now) {
+  if (resolved)
+    statistics_.time_to_quorum.Record(now - entry->first_added);
+  if (detail::IsResolvedOnAllPeers(*entry->unresolved_action)) {
+    statistics_.time_to_all_peers.Record(now - entry->first_added);
+    resolved_on_all_peers_.push_back(entry);
   }
 }
 
+template <typename UnresolvedAction>
+void Sync<UnresolvedAction>::Erase(typename Entries::iterator entry) {
+  if (entry->retry_itr != std::end(retry_queue_))
+    retry_queue_.erase(entry->retry_itr);
+  auto index_itr(index_.find(entry->index_key));
+  assert(index_itr != std::end(index_));
+  auto& same_key_entries(index_itr->second);
+  same_key_entries.erase(std::find(std::begin(same_key_entries), std::end(same_key_entries),
+                                   entry));
+  if (same_key_entries.empty())
+    index_.erase(index_itr);
+  unresolved_actions_.erase(entry);
+}
+
 }  // namespace vault
 
 }  // namespace maidsafe
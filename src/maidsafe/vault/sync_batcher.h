@@ -0,0 +1,174 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_SYNC_BATCHER_H_
+#define MAIDSAFE_VAULT_SYNC_BATCHER_H_
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/vault/group_key.h"
+#include "maidsafe/vault/key.h"
+#include "maidsafe/vault/metadata_key.h"
+#include "maidsafe/vault/sync.pb.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Name of the group a sync message for 'key' is sent to
+inline std::string SyncGroupName(const Key& key) { return key.name.string(); }
+
+template <typename GroupName>
+std::string SyncGroupName(const GroupKey<GroupName>& key) {
+  return key.group_name()->string();
+}
+
+template <typename GroupName>
+std::string SyncGroupName(const MetadataKey<GroupName>& key) {
+  return key.group_name()->string();
+}
+
+// Stands in for a persona's dispatcher when sending sync messages, collecting them by destination
+// group so that each group is sent a single protobuf::SyncBatch.  A group's batch is sent early if
+// adding a message would take it over 'max_batch_bytes'; otherwise batches are held until Flush.
+template <typename Dispatcher>
+class SyncBatcher {
+ public:
+  SyncBatcher(Dispatcher& dispatcher, size_t max_batch_bytes)
+      : dispatcher_(dispatcher), kMaxBatchBytes_(max_batch_bytes), mutex_(), batches_() {}
+
+  template <typename KeyType>
+  void SendSync(const KeyType& key, const std::string& serialised_sync);
+  void Flush();
+
+ private:
+  typedef std::function<void(const std::string& serialised_sync_batch)> SendFunctor;
+  typedef std::vector<std::pair<SendFunctor, std::string>> ReadyBatches;
+
+  SyncBatcher(const SyncBatcher&);
+  SyncBatcher& operator=(const SyncBatcher&);
+  SyncBatcher(SyncBatcher&&);
+  SyncBatcher& operator=(SyncBatcher&&);
+
+  struct Batch {
+    Batch() : send(), proto_sync_batch(), bytes(0) {}
+    SendFunctor send;
+    protobuf::SyncBatch proto_sync_batch;
+    size_t bytes;
+  };
+
+  // Must be called with mutex_ held
+  static void TakeBatch(Batch& batch, ReadyBatches& ready_batches);
+  static void Send(const ReadyBatches& ready_batches);
+
+  Dispatcher& dispatcher_;
+  const size_t kMaxBatchBytes_;
+  std::mutex mutex_;
+  std::map<std::string, Batch> batches_;
+};
+
+template <typename Dispatcher>
+template <typename KeyType>
+void SyncBatcher<Dispatcher>::SendSync(const KeyType& key, const std::string& serialised_sync) {
+  ReadyBatches ready_batches;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Batch& batch(batches_[SyncGroupName(key)]);
+    if (!batch.send) {
+      Dispatcher& dispatcher(dispatcher_);
+      batch.send = [&dispatcher, key](const std::string& serialised_sync_batch) {
+        dispatcher.SendSync(key, serialised_sync_batch);
+      };
+    }
+    if (batch.proto_sync_batch.serialised_syncs_size() != 0 &&
+        batch.bytes + serialised_sync.size() > kMaxBatchBytes_) {
+      TakeBatch(batch, ready_batches);
+    }
+    batch.proto_sync_batch.add_serialised_syncs(serialised_sync);
+    batch.bytes += serialised_sync.size();
+  }
+  Send(ready_batches);
+}
+
+template <typename Dispatcher>
+void SyncBatcher<Dispatcher>::Flush() {
+  ReadyBatches ready_batches;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& batch : batches_)
+      TakeBatch(batch.second, ready_batches);
+    batches_.clear();
+  }
+  Send(ready_batches);
+}
+
+template <typename Dispatcher>
+void SyncBatcher<Dispatcher>::TakeBatch(Batch& batch, ReadyBatches& ready_batches) {
+  ready_batches.emplace_back(batch.send, batch.proto_sync_batch.SerializeAsString());
+  batch.proto_sync_batch.Clear();
+  batch.bytes = 0;
+}
+
+template <typename Dispatcher>
+void SyncBatcher<Dispatcher>::Send(const ReadyBatches& ready_batches) {
+  for (const auto& ready_batch : ready_batches)
+    ready_batch.first(ready_batch.second);
+}
+
+// Applies each sync in a received batch in turn.  One which can't be parsed, or for which 'apply'
+// throws, is logged and skipped, so that it doesn't cost the entries after it from other groups.
+template <typename Functor>
+void ApplySyncBatch(const protobuf::SyncBatch& proto_sync_batch, const std::string& context,
+                    Functor apply) {
+  for (const auto& serialised_sync : proto_sync_batch.serialised_syncs()) {
+    protobuf::Sync proto_sync;
+    if (!proto_sync.ParseFromString(serialised_sync)) {
+      LOG(kError) << context << " can't parse sync";
+      continue;
+    }
+    try {
+      apply(proto_sync);
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << context << " failed to apply sync of action type "
+                  << proto_sync.action_type() << ": " << boost::diagnostic_information(e);
+    }
+  }
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_SYNC_BATCHER_H_
@@ -0,0 +1,94 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_SYNC_RETRY_TIMER_H_
+#define MAIDSAFE_VAULT_SYNC_RETRY_TIMER_H_
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "boost/asio/steady_timer.hpp"
+
+#include "maidsafe/common/asio_service.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Runs a service's resend of due sync actions every 'interval' on its AsioService.  The functor
+// is never invoked once the timer has been destroyed; destruction waits for a running invocation.
+class SyncRetryTimer {
+ public:
+  typedef std::function<void(std::chrono::steady_clock::time_point now)> Functor;
+
+  SyncRetryTimer(AsioService& asio_service, std::chrono::milliseconds interval, Functor functor)
+      : state_(std::make_shared<State>(asio_service, interval, std::move(functor))) {
+    Schedule(state_);
+  }
+
+  ~SyncRetryTimer() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->stopped = true;
+    boost::system::error_code ignored;
+    state_->timer.cancel(ignored);
+  }
+
+ private:
+  SyncRetryTimer(const SyncRetryTimer&);
+  SyncRetryTimer& operator=(const SyncRetryTimer&);
+  SyncRetryTimer(SyncRetryTimer&&);
+  SyncRetryTimer& operator=(SyncRetryTimer&&);
+
+  // Shared with pending handlers, which may outlive the timer
+  struct State {
+    State(AsioService& asio_service, std::chrono::milliseconds interval_in, Functor functor_in)
+        : mutex(), stopped(false), interval(interval_in), functor(std::move(functor_in)),
+          timer(asio_service.service()) {}
+    std::mutex mutex;
+    bool stopped;
+    const std::chrono::milliseconds interval;
+    const Functor functor;
+    boost::asio::steady_timer timer;
+  };
+
+  static void Schedule(const std::shared_ptr<State>& state) {
+    state->timer.expires_from_now(state->interval);
+    state->timer.async_wait([state](const boost::system::error_code& error) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (state->stopped || error == boost::asio::error::operation_aborted)
+        return;
+      state->functor(std::chrono::steady_clock::now());
+      Schedule(state);
+    });
+  }
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_SYNC_RETRY_TIMER_H_
@@ -19,10 +19,18 @@
 
 #include "maidsafe/vault/accumulator.h"
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/data_types/data_type_values.h"
+#include "maidsafe/common/data_types/immutable_data.h"
 #include "maidsafe/nfs/types.h"
 #include "maidsafe/nfs/client/messages.pb.h"
 #include "maidsafe/vault/message_types.h"
@@ -52,6 +60,14 @@ class ContentStringVisitor : public boost::static_visitor<std::string> {
   }
 };
 
+IntegrityCheckRequestFromDataManagerToPmidNode MakeIntegrityCheck(
+    nfs::MessageId message_id, const ImmutableData::Name& data_name,
+    const std::string& random_string) {
+  return IntegrityCheckRequestFromDataManagerToPmidNode(
+      message_id, IntegrityCheckRequestFromDataManagerToPmidNode::Contents(
+                      data_name, NonEmptyString(random_string)));
+}
+
 // bool errors_eq(maidsafe_error l_e, maidsafe_error r_e) {
 //  return l_e.code() == r_e.code();
 // }
@@ -109,6 +125,221 @@ TEST(AccumulatorTest, BEH_AddSingleResult) {
 }
 
 
+TEST(AccumulatorTest, BEH_PendingRequests) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator accumulator(std::chrono::seconds(60), 300, 300);
+  PmidNodeAccumulator::AddRequestChecker checker(3);
+  routing::GroupId group_id(NodeId(NodeId::kRandomId));
+  std::vector<routing::GroupSource> group_sources;
+  for (int i(0); i != 3; ++i)
+    group_sources.emplace_back(group_id, routing::SingleId(NodeId(NodeId::kRandomId)));
+  GetPmidAccountResponseFromPmidManagerToPmidNode message;
+  message.id = nfs::MessageId(RandomUint32() % 1000);
+
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, group_sources[0], checker));
+  // A repeat from the same sender isn't counted again
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, group_sources[0], checker));
+  EXPECT_EQ(1U, accumulator.Get(message, group_sources[0]).size());
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, group_sources[1], checker));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kSuccess,
+            accumulator.AddPendingRequest(message, group_sources[2], checker));
+  EXPECT_EQ(3U, accumulator.Get(message, group_sources[0]).size());
+
+  // Only requests from the same group are matched
+  routing::GroupSource other_group_source(routing::GroupId(NodeId(NodeId::kRandomId)),
+                                          group_sources[0].sender_id);
+  EXPECT_TRUE(accumulator.Get(message, other_group_source).empty());
+
+  // Once full, each new request displaces the oldest
+  GetPmidAccountResponseFromPmidManagerToPmidNode other_message;
+  for (int i(0); i != 297; ++i) {
+    other_message.id = nfs::MessageId(message.id.data + 1 + i);
+    accumulator.AddPendingRequest(other_message, group_sources[0], checker);
+  }
+  EXPECT_EQ(3U, accumulator.Get(message, group_sources[0]).size());
+  other_message.id = nfs::MessageId(message.id.data + 1000);
+  accumulator.AddPendingRequest(other_message, group_sources[0], checker);
+  EXPECT_EQ(2U, accumulator.Get(message, group_sources[0]).size());
+  accumulator.AddPendingRequest(other_message, group_sources[1], checker);
+  accumulator.AddPendingRequest(other_message, group_sources[2], checker);
+  EXPECT_TRUE(accumulator.Get(message, group_sources[0]).empty());
+  EXPECT_EQ(3U, accumulator.Get(other_message, group_sources[0]).size());
+  // Requests which had reached quorum aren't counted as dropped
+  auto statistics(accumulator.GetStatistics());
+  EXPECT_EQ(303U, statistics.added);
+  EXPECT_EQ(0U, statistics.evicted_before_quorum);
+  EXPECT_EQ(0U, statistics.expired_before_quorum);
+  EXPECT_EQ(300U, statistics.capacity);
+  EXPECT_EQ(300U, statistics.pending_count);
+  EXPECT_EQ(2U, statistics.time_to_quorum.Count());
+}
+
+TEST(AccumulatorTest, BEH_PendingRequestExpiryAndEviction) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator accumulator(std::chrono::seconds(1), 2, 2);
+  PmidNodeAccumulator::AddRequestChecker checker(3);
+  routing::GroupSource group_source(routing::GroupId(NodeId(NodeId::kRandomId)),
+                                    routing::SingleId(NodeId(NodeId::kRandomId)));
+  GetPmidAccountResponseFromPmidManagerToPmidNode message;
+  message.id = nfs::MessageId(RandomUint32() % 1000);
+  accumulator.AddPendingRequest(message, group_source, checker);
+  EXPECT_EQ(1U, accumulator.Get(message, group_source).size());
+
+  // Once older than the ttl, a request is expired by the next arrival
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  GetPmidAccountResponseFromPmidManagerToPmidNode other_message;
+  other_message.id = nfs::MessageId(message.id.data + 1);
+  accumulator.AddPendingRequest(other_message, group_source, checker);
+  EXPECT_TRUE(accumulator.Get(message, group_source).empty());
+  EXPECT_EQ(1U, accumulator.GetStatistics().expired_before_quorum);
+
+  // Beyond capacity, the oldest is evicted
+  for (int i(2); i != 4; ++i) {
+    other_message.id = nfs::MessageId(message.id.data + i);
+    accumulator.AddPendingRequest(other_message, group_source, checker);
+  }
+  auto statistics(accumulator.GetStatistics());
+  EXPECT_EQ(4U, statistics.added);
+  EXPECT_EQ(1U, statistics.expired_before_quorum);
+  EXPECT_EQ(1U, statistics.evicted_before_quorum);
+}
+
+TEST(AccumulatorTest, BEH_QuorumRequiresMatchingContent) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator accumulator(std::chrono::seconds(60), 300, 300);
+  PmidNodeAccumulator::AddRequestChecker checker(3);
+  routing::GroupId group_id(NodeId(NodeId::kRandomId));
+  std::vector<routing::GroupSource> group_sources;
+  for (int i(0); i != 4; ++i)
+    group_sources.emplace_back(group_id, routing::SingleId(NodeId(NodeId::kRandomId)));
+  nfs::MessageId message_id(RandomUint32() % 1000);
+  ImmutableData::Name data_name(Identity(RandomString(64)));
+  auto message(MakeIntegrityCheck(message_id, data_name, "agreed"));
+  auto differing_message(MakeIntegrityCheck(message_id, data_name, "disputed"));
+
+  // Three copies sharing a message id, but only two with the same content, aren't a quorum
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, group_sources[0], checker));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(differing_message, group_sources[1], checker));
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kWaiting,
+            accumulator.AddPendingRequest(message, group_sources[2], checker));
+  EXPECT_EQ(3U, accumulator.Get(message, group_sources[0]).size());
+  EXPECT_EQ(0U, accumulator.GetStatistics().time_to_quorum.Count());
+
+  // A third identical copy is
+  EXPECT_EQ(PmidNodeAccumulator::AddResult::kSuccess,
+            accumulator.AddPendingRequest(message, group_sources[3], checker));
+  EXPECT_EQ(1U, accumulator.GetStatistics().time_to_quorum.Count());
+}
+
+TEST(AccumulatorTest, BEH_IdenticalCopiesShareOneInstance) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator accumulator(std::chrono::seconds(60), 300, 300);
+  // Keeps the instances last passed to the checker
+  std::vector<std::shared_ptr<const PmidNodeServiceMessages>> instances;
+  PmidNodeAccumulator::AddCheckerFunctor checker(
+      [&](const PmidNodeAccumulator::Requests& requests) {
+        instances = requests.instances;
+        return PmidNodeAccumulator::AddResult::kWaiting;
+      });
+  routing::GroupId group_id(NodeId(NodeId::kRandomId));
+  std::vector<routing::GroupSource> group_sources;
+  for (int i(0); i != 4; ++i)
+    group_sources.emplace_back(group_id, routing::SingleId(NodeId(NodeId::kRandomId)));
+  nfs::MessageId message_id(RandomUint32() % 1000);
+  ImmutableData::Name data_name(Identity(RandomString(64)));
+  auto message(MakeIntegrityCheck(message_id, data_name, "agreed"));
+  auto differing_message(MakeIntegrityCheck(message_id, data_name, "disputed"));
+
+  accumulator.AddPendingRequest(message, group_sources[0], checker);
+  accumulator.AddPendingRequest(differing_message, group_sources[1], checker);
+  accumulator.AddPendingRequest(message, group_sources[2], checker);
+  accumulator.AddPendingRequest(message, group_sources[3], checker);
+
+  ASSERT_EQ(4U, instances.size());
+  EXPECT_EQ(instances[0], instances[2]);
+  EXPECT_EQ(instances[0], instances[3]);
+  EXPECT_NE(instances[0], instances[1]);
+  // Held once by the Accumulator for each copy, plus once for each entry in 'instances'
+  EXPECT_EQ(6, instances[0].use_count());
+  EXPECT_EQ(2, instances[1].use_count());
+
+  // Each copy still reads back with its own content
+  auto requests(accumulator.Get(message, group_sources[0]));
+  ASSERT_EQ(4U, requests.size());
+  EXPECT_EQ("agreed", boost::apply_visitor(ContentStringVisitor(), requests[0]));
+  EXPECT_EQ("disputed", boost::apply_visitor(ContentStringVisitor(), requests[1]));
+  EXPECT_EQ("agreed", boost::apply_visitor(ContentStringVisitor(), requests[2]));
+  EXPECT_EQ("agreed", boost::apply_visitor(ContentStringVisitor(), requests[3]));
+}
+
+TEST(AccumulatorTest, BEH_PendingRequestBytesLimit) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator::AddCheckerFunctor checker([](const PmidNodeAccumulator::Requests&) {
+    return PmidNodeAccumulator::AddResult::kWaiting;
+  });
+  routing::GroupId group_id(NodeId(NodeId::kRandomId));
+  std::vector<routing::GroupSource> group_sources;
+  for (int i(0); i != 3; ++i)
+    group_sources.emplace_back(group_id, routing::SingleId(NodeId(NodeId::kRandomId)));
+  ImmutableData::Name data_name(Identity(RandomString(64)));
+  std::vector<IntegrityCheckRequestFromDataManagerToPmidNode> messages;
+  for (uint32_t i(0); i != 3; ++i)
+    messages.push_back(MakeIntegrityCheck(nfs::MessageId(i), data_name, RandomString(1000)));
+  PmidNodeAccumulator accumulator(
+      std::chrono::seconds(60), 300, 300,
+      messages[0].Serialise().size() + messages[1].Serialise().size());
+
+  // Copies sharing one instance count its size once, so both requests fit
+  for (int i(0); i != 2; ++i) {
+    for (const auto& group_source : group_sources)
+      accumulator.AddPendingRequest(messages[i], group_source, checker);
+  }
+  EXPECT_EQ(3U, accumulator.Get(messages[0], group_sources[0]).size());
+  EXPECT_EQ(3U, accumulator.Get(messages[1], group_sources[0]).size());
+
+  // A third request evicts every copy of the oldest to make room
+  accumulator.AddPendingRequest(messages[2], group_sources[0], checker);
+  EXPECT_TRUE(accumulator.Get(messages[0], group_sources[0]).empty());
+  EXPECT_EQ(3U, accumulator.Get(messages[1], group_sources[0]).size());
+  EXPECT_EQ(1U, accumulator.Get(messages[2], group_sources[0]).size());
+  EXPECT_EQ(3U, accumulator.GetStatistics().evicted_before_quorum);
+}
+
+TEST(AccumulatorTest, FUNC_AddPendingRequestCostAtCapacity) {
+  typedef Accumulator<PmidNodeServiceMessages> PmidNodeAccumulator;
+  PmidNodeAccumulator accumulator;
+  PmidNodeAccumulator::AddRequestChecker checker(3);
+  routing::GroupId group_id(NodeId(NodeId::kRandomId));
+  std::vector<routing::GroupSource> group_sources;
+  for (int i(0); i != 3; ++i)
+    group_sources.emplace_back(group_id, routing::SingleId(NodeId(NodeId::kRandomId)));
+  GetPmidAccountResponseFromPmidManagerToPmidNode message;
+  // Each request arrives from all three senders, as from a group
+  auto add_requests([&](uint32_t first_id, uint32_t count) {
+    for (uint32_t id(first_id); id != first_id + count; ++id) {
+      message.id = nfs::MessageId(id);
+      for (const auto& group_source : group_sources)
+        accumulator.AddPendingRequest(message, group_source, checker);
+    }
+  });
+  add_requests(0, 100);
+
+  const uint32_t kRequestCount(100000);
+  auto start(std::chrono::steady_clock::now());
+  add_requests(100, kRequestCount);
+  auto duration(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start));
+  LOG(kInfo) << "AddPendingRequest at capacity took "
+             << duration.count() / (kRequestCount * group_sources.size()) << " ns per message";
+  EXPECT_EQ(3U, accumulator.Get(message, group_sources[0]).size());
+}
+
+
 // TEST(AccumulatorTest, BEH_PushSingleResult) {
 //  nfs::Message message = MakeMessage();
 //  nfs::Reply reply(CommonErrors::success);
@@ -0,0 +1,139 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/churn_ranges.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/node_id.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+bool CloserToTarget(const NodeId& lhs, const NodeId& rhs, const NodeId& target) {
+  for (size_t i(0); i != NodeId::kSize; ++i) {
+    unsigned char lhs_distance(static_cast<unsigned char>(lhs.string()[i] ^ target.string()[i]));
+    unsigned char rhs_distance(static_cast<unsigned char>(rhs.string()[i] ^ target.string()[i]));
+    if (lhs_distance != rhs_distance)
+      return lhs_distance < rhs_distance;
+  }
+  return false;
+}
+
+bool IsClose(const NodeId& node, std::vector<NodeId> matrix, const NodeId& target,
+             size_t close_count) {
+  std::sort(std::begin(matrix), std::end(matrix), [&](const NodeId& lhs, const NodeId& rhs) {
+    return CloserToTarget(lhs, rhs, target);
+  });
+  matrix.resize(std::min(matrix.size(), close_count));
+  return std::find(std::begin(matrix), std::end(matrix), node) != std::end(matrix);
+}
+
+bool InRanges(const NodeId& target, const std::vector<detail::ChurnRanges::Range>& ranges) {
+  return std::any_of(std::begin(ranges), std::end(ranges),
+                     [&](const detail::ChurnRanges::Range& range) {
+    return range.first <= target.string() && target.string() <= range.second;
+  });
+}
+
+// Returns a name sharing the first 'prefix_bytes' bytes of 'node'
+NodeId Near(const NodeId& node, size_t prefix_bytes) {
+  std::string name(NodeId(NodeId::kRandomId).string());
+  std::copy(node.string().begin(), node.string().begin() + prefix_bytes, name.begin());
+  return NodeId(name);
+}
+
+}  // unnamed namespace
+
+TEST(ChurnRangesTest, BEH_CoversAffectedNames) {
+  const size_t kCloseCount(4);
+  detail::ChurnRanges churn_ranges(kCloseCount, 0);
+  const NodeId kCentre(NodeId::kRandomId);
+  std::vector<NodeId> matrix;
+  for (int i(0); i != 32; ++i)
+    matrix.push_back(Near(kCentre, 1));
+  churn_ranges.Update(matrix, std::vector<NodeId>(), false);
+
+  const NodeId kLost(matrix.back());
+  const std::vector<NodeId> kOldMatrix(matrix);
+  matrix.pop_back();
+  const NodeId kNew(Near(kCentre, 1));
+  matrix.push_back(kNew);
+  auto ranges(churn_ranges.Update(std::vector<NodeId>(1, kNew), std::vector<NodeId>(1, kLost),
+                                  false));
+  ASSERT_FALSE(ranges.empty());
+  for (size_t i(1); i < ranges.size(); ++i)
+    EXPECT_LT(ranges[i - 1].second, ranges[i].first);
+
+  int affected_count(0), checked_count(0);
+  for (int i(0); i != 5000; ++i) {
+    NodeId target(Near(kCentre, 1));
+    bool affected(IsClose(kLost, kOldMatrix, target, kCloseCount) ||
+                  IsClose(kNew, matrix, target, kCloseCount));
+    bool in_ranges(InRanges(target, ranges));
+    if (affected) {
+      ++affected_count;
+      EXPECT_TRUE(in_ranges) << DebugId(target);
+    }
+    if (in_ranges)
+      ++checked_count;
+  }
+  // Only names near the changed nodes are checked
+  EXPECT_GT(affected_count, 0);
+  EXPECT_LT(checked_count, 5000);
+}
+
+TEST(ChurnRangesTest, BEH_FullCheck) {
+  detail::ChurnRanges churn_ranges(4, 3);
+  const auto kAllNames(detail::ChurnRanges::AllNames());
+  std::vector<NodeId> nodes;
+  for (int i(0); i != 16; ++i)
+    nodes.emplace_back(NodeId::kRandomId);
+  // Every name is affected while fewer than four nodes are known
+  auto ranges(churn_ranges.Update(std::vector<NodeId>(1, nodes.front()), std::vector<NodeId>(),
+                                  false));
+  ASSERT_EQ(1U, ranges.size());
+  EXPECT_EQ(kAllNames, ranges.front());
+
+  churn_ranges.Update(nodes, std::vector<NodeId>(), false);
+  // Third event
+  ranges = churn_ranges.Update(std::vector<NodeId>(), std::vector<NodeId>(1, nodes.back()), false);
+  ASSERT_EQ(1U, ranges.size());
+  EXPECT_EQ(kAllNames, ranges.front());
+
+  ranges = churn_ranges.Update(std::vector<NodeId>(), std::vector<NodeId>(), true);
+  ASSERT_EQ(1U, ranges.size());
+  EXPECT_EQ(kAllNames, ranges.front());
+  // No changes
+  EXPECT_TRUE(churn_ranges.Update(std::vector<NodeId>(), std::vector<NodeId>(), false).empty());
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
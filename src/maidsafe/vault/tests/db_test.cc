@@ -18,6 +18,13 @@
 
 #include "maidsafe/vault/db.h"
 
+#include <fstream>
+#include <future>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "leveldb/db.h"
 #include "leveldb/options.h"
 
@@ -31,6 +38,7 @@
 
 #include "maidsafe/vault/data_manager/value.h"
 #include "maidsafe/vault/key.h"
+#include "maidsafe/vault/transfer_chunks.h"
 #include "maidsafe/vault/version_handler/value.h"
 
 namespace maidsafe {
@@ -129,6 +137,109 @@ TEST_CASE("Db commit", "[Db][Unit]") {
   }
 }
 
+TEST_CASE("Db commit batch", "[Db][Unit]") {
+  typedef Db<Key, TestDbValue>::CommitFunctor CommitFunctor;
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest"));
+  Db<Key, TestDbValue> db(*test_path);
+  std::vector<Key> keys;
+  for (auto i(0); i != 100; ++i)
+    keys.emplace_back(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+
+  std::vector<std::pair<Key, CommitFunctor>> batch;
+  for (const auto& key : keys)
+    batch.emplace_back(key, TestDbActionPutValue("new_value"));
+  auto deleted_values(db.CommitBatch(batch));
+  REQUIRE(deleted_values.size() == keys.size());
+  for (auto i(0U); i != keys.size(); ++i) {
+    CHECK(!deleted_values[i]);
+    CHECK(db.Get(keys[i]).value == "new_value");
+  }
+
+  // Later functors for a key see the result of earlier ones in the same batch
+  batch.clear();
+  batch.emplace_back(keys[0], TestDbActionModifyValue("modified_value"));
+  batch.emplace_back(keys[0], TestDbActionDeleteValue());
+  batch.emplace_back(keys[1], TestDbActionDeleteValue());
+  batch.emplace_back(keys[1], TestDbActionPutValue("put_after_delete"));
+  batch.emplace_back(keys[2], TestDbActionModifyValue("modified_value"));
+  deleted_values = db.CommitBatch(batch);
+  REQUIRE(deleted_values.size() == batch.size());
+  REQUIRE(deleted_values[1]);
+  CHECK(deleted_values[1]->value == "modified_value");
+  REQUIRE(deleted_values[2]);
+  CHECK(deleted_values[2]->value == "new_value");
+  CHECK_THROWS_AS(db.Get(keys[0]), maidsafe_error);
+  CHECK(db.Get(keys[1]).value == "put_after_delete");
+  CHECK(db.Get(keys[2]).value == "modified_value");
+
+  // A throwing functor leaves the db untouched
+  batch.clear();
+  batch.emplace_back(keys[3], TestDbActionDeleteValue());
+  batch.emplace_back(keys[4], TestDbActionPutValue("not_written"));
+  batch.emplace_back(keys[0], TestDbActionModifyValue("modified_value"));
+  CHECK_THROWS_AS(db.CommitBatch(batch), maidsafe_error);
+  CHECK(db.Get(keys[3]).value == "new_value");
+  CHECK(db.Get(keys[4]).value == "new_value");
+  CHECK_THROWS_AS(db.Get(keys[0]), maidsafe_error);
+}
+
+TEST_CASE("Db durable reopen", "[Db][Unit]") {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest"));
+  const boost::filesystem::path kDbPath(*test_path / "db");
+  detail::DbOptions options;
+  options.durable = true;
+  std::vector<Key> keys;
+  for (auto i(0); i != 100; ++i)
+    keys.emplace_back(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  {
+    Db<Key, TestDbValue> db(kDbPath, options);
+    CHECK(!db.Recovered());
+    for (const auto& key : keys)
+      db.Commit(key, TestDbActionPutValue("new_value"));
+    db.Commit(keys.back(), TestDbActionDeleteValue());
+  }
+  REQUIRE(boost::filesystem::exists(kDbPath));
+  {
+    Db<Key, TestDbValue> db(kDbPath, options);
+    CHECK(db.Recovered());
+    for (auto i(0U); i != keys.size() - 1; ++i)
+      CHECK(db.Get(keys[i]).value == "new_value");
+    CHECK_THROWS_AS(db.Get(keys.back()), maidsafe_error);
+  }
+
+  // A db with an unknown format version isn't opened
+  {
+    leveldb::DB* raw_db(nullptr);
+    REQUIRE(leveldb::DB::Open(leveldb::Options(), kDbPath.string(), &raw_db).ok());
+    std::unique_ptr<leveldb::DB> leveldb(raw_db);
+    REQUIRE(leveldb->Put(leveldb::WriteOptions(), "", "0").ok());
+  }
+  CHECK_THROWS_AS(Db<Key, TestDbValue>(kDbPath, options), maidsafe_error);
+
+  // A corrupt db is repaired rather than discarded
+  {
+    leveldb::DB* raw_db(nullptr);
+    REQUIRE(leveldb::DB::Open(leveldb::Options(), kDbPath.string(), &raw_db).ok());
+    std::unique_ptr<leveldb::DB> leveldb(raw_db);
+    REQUIRE(leveldb->Put(leveldb::WriteOptions(), "", "1").ok());
+  }
+  {
+    std::ofstream current_file((kDbPath / "CURRENT").string(), std::ios::trunc);
+    current_file << "garbage";
+  }
+  {
+    Db<Key, TestDbValue> db(kDbPath, options);
+    CHECK(db.Recovered());
+    CHECK(db.Get(keys.front()).value == "new_value");
+  }
+
+  // A non-durable db is removed on destruction
+  options.durable = false;
+  boost::filesystem::remove_all(kDbPath);
+  { Db<Key, TestDbValue> db(kDbPath, options); }
+  CHECK(!boost::filesystem::exists(kDbPath));
+}
+
 TEST_CASE("Db transfer info", "[Db][Unit]") {
   maidsafe::test::TestPath test_path1(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest1"));
   Db<Key, DataManagerValue> data_manager_db(*test_path1);
@@ -139,7 +250,38 @@ TEST_CASE("Db transfer info", "[Db][Unit]") {
   version_handler_db.GetTransferInfo(matrix_change);
 }
 
-// parallel test
+TEST_CASE("Db parallel commit", "[Db][Unit]") {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest"));
+  detail::DbOptions options;
+  options.lock_stripe_count = 4;
+  Db<Key, TestDbValue> db(*test_path, options);
+  const Key kSharedKey(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  db.Commit(kSharedKey, TestDbActionPutValue("0"));
+  const int kThreadCount(8), kIterations(50);
+  std::vector<Key> keys;
+  for (auto i(0); i != kThreadCount; ++i)
+    keys.emplace_back(Identity(NodeId(NodeId::kRandomId).string()), DataTagValue::kMaidValue);
+  // Catch assertions aren't thread-safe, so results are only checked once all threads finish
+  std::vector<std::future<void>> futures;
+  for (auto i(0); i != kThreadCount; ++i) {
+    futures.push_back(std::async(std::launch::async, [&, i] {
+      for (auto j(0); j != kIterations; ++j) {
+        db.Commit(keys[i], TestDbActionPutValue(std::to_string(j)));
+        db.Commit(kSharedKey, [](std::unique_ptr<TestDbValue>& value) {
+          value->value = std::to_string(std::stoi(value->value) + 1);
+          return detail::DbAction::kPut;
+        });
+        if (j != kIterations - 1)
+          db.Commit(keys[i], TestDbActionDeleteValue());
+      }
+    }));
+  }
+  for (auto& future : futures)
+    future.get();
+  for (const auto& key : keys)
+    CHECK(db.Get(key).value == std::to_string(kIterations - 1));
+  CHECK(db.Get(kSharedKey).value == std::to_string(kThreadCount * kIterations));
+}
 
 
 
@@ -210,6 +352,42 @@ TEST_CASE("Db transfer info", "[Db][Unit]") {
 //  }
 // }
 
+TEST_CASE("Transfer chunks", "[Db][Unit]") {
+  typedef std::pair<std::string, std::string> Entry;
+  const size_t kMaxChunkBytes(1000);
+  const NodeId kHolder0(NodeId::kRandomId), kHolder1(NodeId::kRandomId);
+  std::map<NodeId, std::vector<std::vector<Entry>>> sent_chunks;
+  detail::TransferChunks<Entry> chunks(kMaxChunkBytes,
+      [&](const NodeId& new_holder, std::vector<Entry>&& chunk) {
+        sent_chunks[new_holder].push_back(std::move(chunk));
+      });
+  const size_t kEntryCount(2000);
+  for (size_t i(0); i != kEntryCount; ++i) {
+    const std::string kKey(RandomString(64)), kValue(RandomString(i % 10 == 0 ? 2000 : 20));
+    chunks.Add(i % 2 == 0 ? kHolder0 : kHolder1, kKey, Entry(kKey, kValue),
+               kKey.size() + kValue.size());
+  }
+  chunks.Flush();
+
+  REQUIRE(sent_chunks.size() == 2U);
+  size_t entry_count(0);
+  for (const auto& holder_chunks : sent_chunks) {
+    for (const auto& chunk : holder_chunks.second) {
+      REQUIRE(!chunk.empty());
+      entry_count += chunk.size();
+      size_t chunk_bytes(0);
+      for (const auto& entry : chunk)
+        chunk_bytes += entry.first.size() + entry.second.size();
+      // An entry larger than the limit is sent alone
+      CHECK((chunk_bytes <= kMaxChunkBytes || chunk.size() == 1U));
+      // A chunk always ends at a boundary key
+      for (size_t i(0); i + 1 < chunk.size(); ++i)
+        CHECK(!detail::TransferChunks<Entry>::IsBoundary(chunk[i].first));
+    }
+  }
+  CHECK(entry_count == kEntryCount);
+}
+
 }  // namespace test
 
 }  // namespace vault
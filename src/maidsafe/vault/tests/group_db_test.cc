@@ -18,6 +18,9 @@
 
 #include "maidsafe/vault/group_db.h"
 
+#include <set>
+#include <vector>
+
 #include "boost/progress.hpp"
 
 #include "leveldb/db.h"
@@ -346,6 +349,199 @@ TEST(GroupDbTest, FUNC_PmidManagerGroupDb) {
   });
 }
 
+TEST(GroupDbTest, BEH_ValueCache) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_GroupDbTest"));
+  detail::DbOptions options;
+  options.value_cache_capacity = 10;
+  GroupDb<MaidManager> maid_group_db(UniqueDbPath(*test_path), options);
+  auto maid(MakeMaid());
+  MaidName maid_name(maid.name());
+  maid_group_db.AddGroup(maid_name, CreateMaidManagerMetadata(maid));
+  std::vector<GroupKey<MaidName>> keys;
+  for (auto i(0); i != 20; ++i) {
+    keys.emplace_back(maid_name, Identity(NodeId(NodeId::kRandomId).string()),
+                      DataTagValue::kMaidValue);
+    maid_group_db.Commit(keys.back(), TestGroupDbActionPutValue());
+  }
+  EXPECT_EQ(0U, maid_group_db.value_cache_hits());
+  EXPECT_EQ(20U, maid_group_db.value_cache_misses());
+
+  // The last 10 committed values are cached, the rest are read through on first access
+  MaidManagerValue expected_value;
+  expected_value.Put(100);
+  for (auto itr(keys.rbegin()); itr != keys.rend(); ++itr)
+    EXPECT_TRUE(maid_group_db.GetValue(*itr) == expected_value);
+  EXPECT_EQ(10U, maid_group_db.value_cache_hits());
+  EXPECT_EQ(30U, maid_group_db.value_cache_misses());
+
+  // Writes go through the cache
+  expected_value.Put(100);
+  maid_group_db.Commit(keys.front(), TestGroupDbActionModifyValue());
+  EXPECT_EQ(11U, maid_group_db.value_cache_hits());
+  EXPECT_TRUE(maid_group_db.GetValue(keys.front()) == expected_value);
+  EXPECT_EQ(12U, maid_group_db.value_cache_hits());
+
+  // Deleting the group invalidates its cached values
+  maid_group_db.DeleteGroup(maid_name);
+  maid_group_db.AddGroup(maid_name, CreateMaidManagerMetadata(maid));
+  EXPECT_THROW(maid_group_db.GetValue(keys.front()), maidsafe_error);
+
+  // A zero capacity disables the cache
+  options.value_cache_capacity = 0;
+  GroupDb<MaidManager> uncached_group_db(UniqueDbPath(*test_path), options);
+  uncached_group_db.AddGroup(maid_name, CreateMaidManagerMetadata(maid));
+  uncached_group_db.Commit(keys.front(), TestGroupDbActionPutValue());
+  uncached_group_db.GetValue(keys.front());
+  EXPECT_EQ(0U, uncached_group_db.value_cache_hits());
+  EXPECT_EQ(0U, uncached_group_db.value_cache_misses());
+}
+
+TEST(GroupDbTest, BEH_DeleteGroups) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_GroupDbTest"));
+  GroupDb<MaidManager> maid_group_db(UniqueDbPath(*test_path));
+  std::vector<MaidName> maid_names;
+  std::vector<GroupKey<MaidName>> keys;
+  for (auto i(0); i != 10; ++i) {
+    auto maid(MakeMaid());
+    maid_names.push_back(maid.name());
+    maid_group_db.AddGroup(maid_names.back(), CreateMaidManagerMetadata(maid));
+    for (auto j(0); j != 10; ++j) {
+      keys.emplace_back(maid_names.back(), Identity(NodeId(NodeId::kRandomId).string()),
+                        DataTagValue::kMaidValue);
+      maid_group_db.Commit(keys.back(), TestGroupDbActionPutValue());
+    }
+  }
+
+  // Deleting groups, including adjacent ones, leaves the others' entries untouched
+  for (size_t i(0); i < maid_names.size(); i += 3) {
+    maid_group_db.DeleteGroup(maid_names[i]);
+    if (i + 1 < maid_names.size())
+      maid_group_db.DeleteGroup(maid_names[i + 1]);
+  }
+  for (size_t i(0); i != maid_names.size(); ++i) {
+    if (i % 3 == 2) {
+      EXPECT_EQ(10U, maid_group_db.GetContents(maid_names[i]).kv_pairs.size());
+      EXPECT_NO_THROW(maid_group_db.GetValue(keys[i * 10]));
+    } else {
+      EXPECT_THROW(maid_group_db.GetMetadata(maid_names[i]), maidsafe_error);
+      EXPECT_THROW(maid_group_db.GetValue(keys[i * 10]), maidsafe_error);
+    }
+  }
+}
+
+TEST(GroupDbTest, BEH_GroupIdAllocator) {
+  detail::GroupIdAllocator allocator(1);
+  std::set<uint32_t> ids;
+  for (auto i(0); i != 255; ++i) {
+    auto id(allocator.Allocate());
+    EXPECT_NE(0U, id);
+    EXPECT_TRUE(ids.insert(id).second);
+  }
+  EXPECT_EQ(255U, allocator.size());
+  EXPECT_THROW(allocator.Allocate(), maidsafe_error);
+  allocator.Release(100);
+  allocator.Release(100);
+  EXPECT_EQ(254U, allocator.size());
+  EXPECT_EQ(100U, allocator.Allocate());
+  EXPECT_THROW(allocator.Allocate(), maidsafe_error);
+
+  // Reserved ids are skipped
+  detail::GroupIdAllocator reloaded_allocator(2);
+  reloaded_allocator.Reserve(1);
+  reloaded_allocator.Reserve(3);
+  EXPECT_EQ(2U, reloaded_allocator.Allocate());
+  EXPECT_EQ(4U, reloaded_allocator.Allocate());
+  EXPECT_EQ(4U, reloaded_allocator.size());
+}
+
+TEST(GroupDbTest, FUNC_PrefixWidth) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_GroupDbTest"));
+  detail::DbOptions options;
+  for (options.prefix_width = 1; options.prefix_width != 5; ++options.prefix_width) {
+    GroupDb<MaidManager> maid_group_db(UniqueDbPath(*test_path), options);
+    RunMaidManagerGroupDbTest(maid_group_db);
+    GroupDb<PmidManager> pmid_group_db(UniqueDbPath(*test_path), options);
+    RunPmidManagerGroupDbTest(pmid_group_db);
+  }
+
+  // A width of 1 allows 255 groups
+  options.prefix_width = 1;
+  GroupDb<PmidManager> pmid_group_db(UniqueDbPath(*test_path), options);
+  std::vector<PmidName> pmid_names;
+  for (auto i(0); i != 255; ++i) {
+    pmid_names.emplace_back(Identity(NodeId(NodeId::kRandomId).string()));
+    pmid_group_db.AddGroup(pmid_names.back(), CreatePmidManagerMetadata(pmid_names.back()));
+  }
+  PmidName extra_pmid_name(Identity(NodeId(NodeId::kRandomId).string()));
+  EXPECT_THROW(pmid_group_db.AddGroup(extra_pmid_name, CreatePmidManagerMetadata(extra_pmid_name)),
+               maidsafe_error);
+  pmid_group_db.DeleteGroup(pmid_names.front());
+  EXPECT_NO_THROW(pmid_group_db.AddGroup(extra_pmid_name,
+                                         CreatePmidManagerMetadata(extra_pmid_name)));
+}
+
+TEST(GroupDbTest, FUNC_DurableReopen) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_GroupDbTest"));
+  const boost::filesystem::path kDbPath(UniqueDbPath(*test_path));
+  detail::DbOptions options;
+  options.durable = true;
+  options.prefix_width = 2;
+  auto maid(MakeMaid());
+  MaidName maid_name(maid.name());
+  MaidManagerMetadata expected_metadata(CreateMaidManagerMetadata(maid));
+  MaidManagerValue expected_value;
+  expected_value.Put(100);
+  std::vector<GroupKey<MaidName>> keys;
+  for (auto i(0); i != 100; ++i)
+    keys.emplace_back(maid_name, Identity(NodeId(NodeId::kRandomId).string()),
+                      DataTagValue::kMaidValue);
+  auto removed_maid(MakeMaid());
+  MaidName removed_maid_name(removed_maid.name());
+  {
+    GroupDb<MaidManager> maid_group_db(kDbPath, options);
+    maid_group_db.AddGroup(maid_name, expected_metadata);
+    maid_group_db.AddGroup(removed_maid_name, CreateMaidManagerMetadata(removed_maid));
+    for (const auto& key : keys) {
+      maid_group_db.Commit(key, TestGroupDbActionPutValue());
+      expected_metadata.PutData(100);
+    }
+    maid_group_db.DeleteGroup(removed_maid_name);
+  }
+
+  auto check_contents([&](GroupDb<MaidManager>& maid_group_db) {
+    EXPECT_TRUE(maid_group_db.GetMetadata(maid_name) == expected_metadata);
+    EXPECT_THROW(maid_group_db.GetMetadata(removed_maid_name), maidsafe_error);
+    EXPECT_EQ(keys.size(), maid_group_db.GetContents(maid_name).kv_pairs.size());
+    for (const auto& key : keys)
+      EXPECT_TRUE(maid_group_db.GetValue(key) == expected_value);
+  });
+
+  {
+    GroupDb<MaidManager> maid_group_db(kDbPath, options);
+    check_contents(maid_group_db);
+  }
+  // Reopening with a different prefix width re-keys the db
+  options.prefix_width = 4;
+  {
+    GroupDb<MaidManager> maid_group_db(kDbPath, options);
+    check_contents(maid_group_db);
+    // New groups don't collide with migrated ones
+    maid_group_db.AddGroup(removed_maid_name, CreateMaidManagerMetadata(removed_maid));
+    EXPECT_TRUE(maid_group_db.GetContents(removed_maid_name).kv_pairs.empty());
+    maid_group_db.DeleteGroup(removed_maid_name);
+  }
+  {
+    GroupDb<MaidManager> maid_group_db(kDbPath, options);
+    check_contents(maid_group_db);
+  }
+  EXPECT_FALSE(boost::filesystem::exists(kDbPath.string() + ".migrating"));
+
+  // A non-durable db is removed on destruction
+  options.durable = false;
+  { GroupDb<MaidManager> maid_group_db(kDbPath, options); }
+  EXPECT_FALSE(boost::filesystem::exists(kDbPath));
+}
+
 TEST(GroupDbTest, BEH_TransferInfo) {
   maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_GroupDbTest"));
   GroupDb<MaidManager> maid_group_db(UniqueDbPath(*test_path));
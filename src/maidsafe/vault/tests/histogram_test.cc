@@ -0,0 +1,77 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/histogram.h"
+
+#include <chrono>
+#include <cstdint>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+TEST(HistogramTest, BEH_Empty) {
+  detail::Histogram histogram;
+  EXPECT_EQ(0U, histogram.Count());
+  EXPECT_EQ(0U, histogram.Min());
+  EXPECT_EQ(0U, histogram.Max());
+  EXPECT_EQ(0.0, histogram.Mean());
+  EXPECT_EQ(0U, histogram.ValueAtPercentile(50.0));
+}
+
+TEST(HistogramTest, BEH_Percentiles) {
+  detail::Histogram histogram;
+  for (uint64_t value(1); value <= 1000; ++value)
+    histogram.Record(value);
+  EXPECT_EQ(1000U, histogram.Count());
+  EXPECT_EQ(1U, histogram.Min());
+  EXPECT_EQ(1000U, histogram.Max());
+  EXPECT_DOUBLE_EQ(500.5, histogram.Mean());
+  // Small values are exact, larger ones within a sixteenth of their power of two
+  EXPECT_EQ(1U, histogram.ValueAtPercentile(0.0));
+  EXPECT_EQ(10U, histogram.ValueAtPercentile(1.0));
+  EXPECT_LE(500U, histogram.ValueAtPercentile(50.0));
+  EXPECT_GE(500U + 500U / 16, histogram.ValueAtPercentile(50.0));
+  EXPECT_LE(990U, histogram.ValueAtPercentile(99.0));
+  EXPECT_GE(990U + 990U / 16, histogram.ValueAtPercentile(99.0));
+  EXPECT_EQ(1000U, histogram.ValueAtPercentile(100.0));
+
+  // Values beyond the top bucket are still reported as the maximum
+  histogram.Record(~uint64_t(0));
+  EXPECT_EQ(~uint64_t(0), histogram.ValueAtPercentile(100.0));
+}
+
+TEST(HistogramTest, BEH_Durations) {
+  detail::Histogram histogram;
+  histogram.Record(std::chrono::milliseconds(3));
+  histogram.Record(std::chrono::microseconds(-1));
+  EXPECT_EQ(2U, histogram.Count());
+  EXPECT_EQ(0U, histogram.Min());
+  EXPECT_EQ(3000U, histogram.Max());
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,189 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/ingestion_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+// Stands in for an Accumulator: a bounded list of pending requests, scanned on every add
+class FakeAccumulator {
+ public:
+  FakeAccumulator() : pending_() {}
+  bool Add(uint64_t request) {
+    bool exists(std::find(std::begin(pending_), std::end(pending_), request) !=
+                std::end(pending_));
+    if (!exists) {
+      pending_.push_back(request);
+      if (pending_.size() > 300)
+        pending_.pop_front();
+    }
+    return !exists;
+  }
+
+ private:
+  std::deque<uint64_t> pending_;
+};
+
+// Returns the time taken for 'producer_count' threads to each run 'tasks_per_producer' tasks.
+std::chrono::milliseconds RunProducers(detail::IngestionQueue& ingestion, int producer_count,
+                                       int tasks_per_producer, FakeAccumulator& accumulator,
+                                       std::atomic<int>& continuations_run) {
+  std::vector<std::thread> producers;
+  auto start(std::chrono::steady_clock::now());
+  for (int producer(0); producer != producer_count; ++producer) {
+    producers.emplace_back([&, producer] {
+      for (int i(0); i != tasks_per_producer; ++i) {
+        uint64_t request((static_cast<uint64_t>(producer) << 32) + i);
+        ingestion.Run([&accumulator, &continuations_run,
+                       request]() -> detail::IngestionQueue::Continuation {
+          if (!accumulator.Add(request))
+            return detail::IngestionQueue::Continuation();
+          return [&continuations_run] { ++continuations_run; };
+        });
+      }
+    });
+  }
+  for (auto& producer : producers)
+    producer.join();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+}
+
+}  // unnamed namespace
+
+TEST(IngestionQueueTest, BEH_MpscQueue) {
+  detail::MpscQueue<int> queue;
+  int value(0);
+  EXPECT_FALSE(queue.TryPop(value));
+  const int kProducerCount(4), kPushesPerProducer(10000);
+  std::vector<std::thread> producers;
+  for (int producer(0); producer != kProducerCount; ++producer) {
+    producers.emplace_back([&, producer] {
+      for (int i(0); i != kPushesPerProducer; ++i)
+        queue.Push(producer * kPushesPerProducer + i);
+    });
+  }
+  for (auto& producer : producers)
+    producer.join();
+
+  // Each producer's values come out in the order it pushed them
+  std::vector<int> last_popped(kProducerCount, -1);
+  int popped_count(0);
+  while (queue.TryPop(value)) {
+    int producer(value / kPushesPerProducer);
+    EXPECT_LT(last_popped[producer], value);
+    last_popped[producer] = value;
+    ++popped_count;
+  }
+  EXPECT_EQ(kProducerCount * kPushesPerProducer, popped_count);
+}
+
+TEST(IngestionQueueTest, BEH_RunsEveryTaskExclusively) {
+  for (bool queued : {false, true}) {
+    detail::IngestionQueue ingestion(queued, 16);
+    EXPECT_EQ(queued, ingestion.queued());
+    // Not atomic, so lost updates would show tasks overlapping
+    int task_count(0);
+    std::atomic<int> continuations_run(0);
+    std::vector<std::thread> producers;
+    for (int producer(0); producer != 8; ++producer) {
+      producers.emplace_back([&] {
+        for (int i(0); i != 5000; ++i) {
+          ingestion.Run([&]() -> detail::IngestionQueue::Continuation {
+            ++task_count;
+            return [&] { ++continuations_run; };
+          });
+        }
+      });
+    }
+    for (auto& producer : producers)
+      producer.join();
+    EXPECT_EQ(40000, task_count);
+    EXPECT_EQ(40000, continuations_run);
+  }
+}
+
+TEST(IngestionQueueTest, BEH_ThrowingTask) {
+  for (bool queued : {false, true}) {
+    detail::IngestionQueue ingestion(queued, 16);
+    int continuations_run(0);
+    auto good_task([&]() -> detail::IngestionQueue::Continuation {
+      return [&] { ++continuations_run; };
+    });
+    auto throwing_task([]() -> detail::IngestionQueue::Continuation {
+      throw std::runtime_error("task failed");
+    });
+    auto throwing_continuation_task([]() -> detail::IngestionQueue::Continuation {
+      return [] { throw std::runtime_error("continuation failed"); };
+    });
+    EXPECT_NO_THROW(ingestion.Run(good_task));
+    if (queued) {
+      // Logged and dropped by the drainer
+      EXPECT_NO_THROW(ingestion.Run(throwing_task));
+      EXPECT_NO_THROW(ingestion.Run(throwing_continuation_task));
+    } else {
+      // Propagated to the caller
+      EXPECT_THROW(ingestion.Run(throwing_task), std::runtime_error);
+      EXPECT_THROW(ingestion.Run(throwing_continuation_task), std::runtime_error);
+    }
+    // The queue is still usable afterwards
+    EXPECT_NO_THROW(ingestion.Run(good_task));
+    EXPECT_EQ(2, continuations_run);
+  }
+}
+
+TEST(IngestionQueueTest, FUNC_CompareModes) {
+  const int kTasks(200000);
+  for (int producer_count : {1, 2, 4, 8}) {
+    for (bool queued : {false, true}) {
+      detail::IngestionQueue ingestion(queued, 64);
+      FakeAccumulator accumulator;
+      std::atomic<int> continuations_run(0);
+      auto duration(RunProducers(ingestion, producer_count, kTasks / producer_count,
+                                 accumulator, continuations_run));
+      EXPECT_EQ(kTasks / producer_count * producer_count, continuations_run);
+      LOG(kInfo) << (queued ? "Queued" : "Locked") << " ingestion with " << producer_count
+                 << " producer(s) ran " << kTasks << " tasks in " << duration.count() << " ms";
+    }
+  }
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,69 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/data_manager/integrity_check_data.h"
+
+#include <algorithm>
+#include <string>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+TEST(IntegrityCheckDataTest, BEH_HasherMatchesJoinedHash) {
+  const std::string kRandomInput(IntegrityCheckData::GetRandomInput());
+  for (size_t size : {1U, 127U, 128U, 129U, 1024U * 1024U}) {
+    const NonEmptyString kValue(RandomString(size));
+    const IntegrityCheckData::Result kExpected(
+        crypto::Hash<crypto::SHA512>(kValue.string() + kRandomInput));
+    EXPECT_EQ(kExpected, IntegrityCheckData(kRandomInput, kValue).result());
+    EXPECT_EQ(kExpected, IntegrityCheckData(kRandomInput, kValue.string().data(),
+                                            kValue.string().size()).result());
+    // Fed in uneven pieces
+    IntegrityCheckData::Hasher hasher(kRandomInput);
+    for (size_t offset(0), piece(1); offset < size; offset += piece, piece = piece * 3 + 1)
+      hasher.Update(kValue.string().data() + offset, std::min(piece, size - offset));
+    EXPECT_EQ(kExpected, hasher.Finalise());
+    EXPECT_THROW(hasher.Finalise(), maidsafe_error);
+  }
+}
+
+TEST(IntegrityCheckDataTest, BEH_Validate) {
+  const NonEmptyString kValue(RandomString(1000));
+  IntegrityCheckData check(IntegrityCheckData::GetRandomInput());
+  EXPECT_FALSE(check.Validate(kValue));
+  IntegrityCheckData::Hasher hasher(check.random_input());
+  hasher.Update(kValue.string().data(), kValue.string().size());
+  check.SetResult(hasher.Finalise());
+  EXPECT_TRUE(check.Validate(kValue));
+  EXPECT_FALSE(check.Validate(NonEmptyString(RandomString(1000))));
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
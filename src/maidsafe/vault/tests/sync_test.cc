@@ -20,6 +20,15 @@
 
 #include <atomic>
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <new>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "boost/progress.hpp"
 
@@ -42,6 +51,11 @@
 #include "maidsafe/vault/data_manager/action_put.h"
 #include "maidsafe/vault/group_key.h"
 #include "maidsafe/vault/key.h"
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/sync_batcher.h"
+#include "maidsafe/vault/sync_retry_timer.h"
+#include "maidsafe/vault/utils.h"
+#include "maidsafe/vault/sync.pb.h"
 #include "maidsafe/vault/maid_manager/maid_manager.h"
 #include "maidsafe/vault/maid_manager/metadata.h"
 #include "maidsafe/vault/maid_manager/action_put.h"
@@ -51,6 +65,22 @@
 #include "maidsafe/vault/version_handler/value.h"
 #include "maidsafe/vault/tests/tests_utils.h"
 
+namespace {
+
+// Counts this binary's allocations, so that a test can check a section of code makes none
+std::atomic<uint64_t> g_allocation_count(0);
+
+}  // unnamed namespace
+
+void* operator new(std::size_t size) {
+  ++g_allocation_count;
+  if (void* memory = std::malloc(size == 0 ? 1 : size))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
 namespace maidsafe {
 
 namespace vault {
@@ -70,7 +100,7 @@ struct PersonaNode {
   std::unique_ptr<UnresolvedActionType> ReceiveUnresolvedAction(
       const UnresolvedActionType& unresolved_action) {
     auto received_unresolved_action = UnresolvedActionType(unresolved_action.Serialise(),
-        unresolved_action.this_node_and_entry_id->first, node_id);
+        unresolved_action.this_node_entry().node_id.ToNodeId(), node_id);
     auto resolved(sync.AddUnresolvedAction(received_unresolved_action));
     if (resolved)
       ++resolved_count;
@@ -331,6 +361,229 @@ TEST(SyncTest, BEH_MultipleParallelRandomAction) {
   ApplySyncToPersona(persona_node, keys);
 }
 
+TEST(SyncTest, BEH_GetActionsDueForResend) {
+  typedef std::unique_ptr<PersonaNode<MaidManager::UnresolvedPut>> PersonaNodePtr;
+  std::vector<PersonaNodePtr> persona_nodes(routing::Parameters::group_size);
+  std::generate(std::begin(persona_nodes), std::end(persona_nodes),
+                [] { return PersonaNodePtr(new PersonaNodePtr::element_type); });
+  auto keys(CreateKeys(2));
+
+  // Resolved on all peers is pruned at the next check
+  for (const auto& persona_node : persona_nodes) {
+    persona_nodes.front()->ReceiveUnresolvedAction(
+        persona_node->CreateUnresolvedAction(keys.front()));
+  }
+  // Only held by this node, so resent until it has used all its attempts
+  persona_nodes.front()->ReceiveUnresolvedAction(
+      persona_nodes.front()->CreateUnresolvedAction(keys.back()));
+
+  auto& sync(persona_nodes.front()->sync);
+  EXPECT_EQ(1U, sync.GetUnresolvedActions().size());
+  auto now(std::chrono::steady_clock::now());
+  EXPECT_TRUE(sync.GetActionsDueForResend(now).empty());
+  EXPECT_EQ(1U, sync.GetUnresolvedActions().size());
+
+  // Each check is far enough apart for the action to be due again whatever its backoff
+  for (int i(0); i != detail::Parameters::max_sync_attempts; ++i) {
+    now += std::chrono::hours(1);
+    auto due_actions(sync.GetActionsDueForResend(now));
+    ASSERT_EQ(1U, due_actions.size());
+    EXPECT_TRUE(due_actions.front()->key == keys.back());
+    EXPECT_EQ(i + 1, due_actions.front()->sync_counter);
+    EXPECT_TRUE(sync.GetActionsDueForResend(now).empty());
+  }
+  now += std::chrono::hours(1);
+  EXPECT_TRUE(sync.GetActionsDueForResend(now).empty());
+  EXPECT_TRUE(sync.GetUnresolvedActions().empty());
+  auto statistics(sync.GetStatistics());
+  EXPECT_EQ(1U, statistics.resolved_on_all_peers);
+  EXPECT_EQ(1U, statistics.time_to_quorum.Count());
+  EXPECT_EQ(1U, statistics.time_to_all_peers.Count());
+  EXPECT_EQ(1U, statistics.attempts.Count());
+  EXPECT_EQ(1U, statistics.dropped_after_max_attempts);
+  EXPECT_EQ(0U, statistics.unresolved_count);
+
+  // A new action for the same key is held afresh
+  persona_nodes.front()->ReceiveUnresolvedAction(
+      persona_nodes.front()->CreateUnresolvedAction(keys.back()));
+  EXPECT_EQ(1U, sync.GetUnresolvedActions().size());
+}
+
+TEST(SyncTest, BEH_ResolvedOnceAtQuorum) {
+  typedef std::unique_ptr<PersonaNode<MaidManager::UnresolvedPut>> PersonaNodePtr;
+  std::vector<PersonaNodePtr> persona_nodes(routing::Parameters::group_size);
+  std::generate(std::begin(persona_nodes), std::end(persona_nodes),
+                [] { return PersonaNodePtr(new PersonaNodePtr::element_type); });
+  auto key(CreateKeys(1).front());
+  auto& receiver(*persona_nodes.front());
+  for (size_t i(0); i != persona_nodes.size(); ++i) {
+    auto unresolved_action(persona_nodes[i]->CreateUnresolvedAction(key));
+    auto resolved(receiver.ReceiveUnresolvedAction(unresolved_action));
+    EXPECT_EQ(i == routing::Parameters::group_size / 2, resolved != nullptr);
+    if (resolved) {
+      EXPECT_TRUE(resolved->HasThisNodeEntry());
+      EXPECT_EQ(i, resolved->PeerCount());
+    }
+    // A repeat from the same node is ignored
+    EXPECT_FALSE(receiver.ReceiveUnresolvedAction(unresolved_action));
+  }
+  EXPECT_EQ(1, receiver.resolved_count);
+  EXPECT_TRUE(receiver.sync.GetUnresolvedActions().empty());
+}
+
+struct FakeSyncDispatcher {
+  FakeSyncDispatcher() : sent() {}
+  void SendSync(const MaidManager::Key& key, const std::string& serialised_sync_batch) {
+    protobuf::SyncBatch proto_sync_batch;
+    EXPECT_TRUE(proto_sync_batch.ParseFromString(serialised_sync_batch));
+    sent.push_back(std::make_pair(key.group_name(), proto_sync_batch.serialised_syncs_size()));
+  }
+  std::vector<std::pair<MaidName, int>> sent;
+};
+
+TEST(SyncTest, BEH_SyncBatcher) {
+  const int kGroupCount(4), kKeyCount(40);
+  auto keys(CreateKeys(kKeyCount, kGroupCount));
+  const std::string kSerialisedSync(RandomString(100));
+  FakeSyncDispatcher dispatcher;
+  {
+    // One batch per group, sent on Flush
+    detail::SyncBatcher<FakeSyncDispatcher> sync_batcher(dispatcher, 1024 * 1024);
+    for (const auto& key : keys)
+      sync_batcher.SendSync(key, kSerialisedSync);
+    EXPECT_TRUE(dispatcher.sent.empty());
+    sync_batcher.Flush();
+    ASSERT_EQ(static_cast<size_t>(kGroupCount), dispatcher.sent.size());
+    std::set<MaidName> group_names;
+    for (const auto& sent : dispatcher.sent) {
+      EXPECT_EQ(kKeyCount / kGroupCount, sent.second);
+      group_names.insert(sent.first);
+    }
+    EXPECT_EQ(static_cast<size_t>(kGroupCount), group_names.size());
+    sync_batcher.Flush();
+    EXPECT_EQ(static_cast<size_t>(kGroupCount), dispatcher.sent.size());
+  }
+  dispatcher.sent.clear();
+  {
+    // A batch is sent early rather than exceed the size limit
+    detail::SyncBatcher<FakeSyncDispatcher> sync_batcher(dispatcher,
+                                                         3 * kSerialisedSync.size());
+    for (int i(0); i != 7; ++i)
+      sync_batcher.SendSync(keys.front(), kSerialisedSync);
+    ASSERT_EQ(2U, dispatcher.sent.size());
+    EXPECT_EQ(3, dispatcher.sent.front().second);
+    sync_batcher.Flush();
+    ASSERT_EQ(3U, dispatcher.sent.size());
+    EXPECT_EQ(1, dispatcher.sent.back().second);
+  }
+}
+
+TEST(SyncTest, BEH_ApplySyncBatchSkipsBadEntries) {
+  auto keys(CreateKeys(2));
+  // The node's own actions, as received back from its group
+  PersonaNode<MaidManager::UnresolvedPut> node;
+  protobuf::SyncBatch proto_sync_batch;
+  auto add_sync([&](const std::string& serialised_unresolved_action) {
+    protobuf::Sync proto_sync;
+    proto_sync.set_action_type(static_cast<int32_t>(ActionMaidManagerPut::kActionId));
+    proto_sync.set_serialised_unresolved_action(serialised_unresolved_action);
+    proto_sync_batch.add_serialised_syncs(proto_sync.SerializeAsString());
+  });
+  add_sync(node.CreateUnresolvedAction(keys.front()).Serialise());
+  // Can't be parsed as a Sync
+  proto_sync_batch.add_serialised_syncs(std::string());
+  // A Sync whose action can't be parsed, so applying it throws
+  add_sync("garbage");
+  add_sync(node.CreateUnresolvedAction(keys.back()).Serialise());
+
+  int applied(0);
+  EXPECT_NO_THROW(detail::ApplySyncBatch(proto_sync_batch, "BEH_ApplySyncBatchSkipsBadEntries",
+      [&](const protobuf::Sync& proto_sync) {
+        node.sync.AddUnresolvedAction(MaidManager::UnresolvedPut(
+            proto_sync.serialised_unresolved_action(), node.node_id, node.node_id));
+        ++applied;
+      }));
+  EXPECT_EQ(2, applied);
+  auto unresolved_actions(node.sync.GetUnresolvedActions());
+  ASSERT_EQ(2U, unresolved_actions.size());
+  std::set<MaidManager::Key> applied_keys;
+  for (const auto& unresolved_action : unresolved_actions)
+    applied_keys.insert(unresolved_action->key);
+  EXPECT_EQ(1U, applied_keys.count(keys.front()));
+  EXPECT_EQ(1U, applied_keys.count(keys.back()));
+}
+
+// Mirrors a service's DoSync and its SyncRetryTimer tick: new actions are only sent when the tick
+// flushes the batcher, so those created between ticks share one batch per group.
+TEST(SyncTest, BEH_NewActionsBatchedUntilTick) {
+  const int kGroupCount(3), kKeyCount(12);
+  auto keys(CreateKeys(kKeyCount, kGroupCount));
+  PersonaNode<MaidManager::UnresolvedPut> persona_node;
+  FakeSyncDispatcher dispatcher;
+  detail::SyncBatcher<FakeSyncDispatcher> sync_batcher(dispatcher, 1024 * 1024);
+  for (const auto& key : keys)
+    detail::SendSyncAction(sync_batcher, persona_node.CreateUnresolvedAction(key));
+  EXPECT_TRUE(dispatcher.sent.empty());
+
+  AsioService asio_service(1);
+  std::promise<void> ticked;
+  bool first_tick(true);
+  {
+    detail::SyncRetryTimer sync_retry_timer(
+        asio_service, std::chrono::milliseconds(10),
+        [&](std::chrono::steady_clock::time_point now) {
+          detail::ResendDueSyncs(sync_batcher, persona_node.sync, now);
+          sync_batcher.Flush();
+          if (first_tick) {
+            first_tick = false;
+            ticked.set_value();
+          }
+        });
+    ticked.get_future().wait();
+  }
+  asio_service.Stop();
+
+  ASSERT_EQ(static_cast<size_t>(kGroupCount), dispatcher.sent.size());
+  std::set<MaidName> group_names;
+  for (const auto& sent : dispatcher.sent) {
+    EXPECT_EQ(kKeyCount / kGroupCount, sent.second);
+    group_names.insert(sent.first);
+  }
+  EXPECT_EQ(static_cast<size_t>(kGroupCount), group_names.size());
+}
+
+TEST(SyncTest, BEH_UnresolvedActionSlotsDoNotAllocate) {
+  typedef MaidManager::UnresolvedPut UnresolvedPut;
+  auto maid(MakeMaid());
+  MaidManager::Key key(MaidName(maid.name()), Identity(NodeId(NodeId::kRandomId).string()),
+                       DataTagValue::kMaidValue);
+  std::vector<NodeId> node_ids(routing::Parameters::group_size);
+  std::generate(std::begin(node_ids), std::end(node_ids),
+                [] { return NodeId(NodeId::kRandomId); });
+  UnresolvedPut unresolved_action(key, UnresolvedPut::ActionType(100), node_ids[0]);
+  for (size_t i(1); i != node_ids.size(); ++i) {
+    unresolved_action.AddPeerEntry(
+        UnresolvedPut::Entry(node_ids[i], static_cast<int32_t>(i)));
+  }
+  detail::InlineNodeId peer_id(node_ids.back());
+
+  // Constructing, copying and searching the slots allocates nothing
+  auto allocation_count(g_allocation_count.load());
+  std::array<UnresolvedPut::Entry, UnresolvedPut::kMaxGroupSize> empty_entries;
+  std::array<UnresolvedPut::Entry, UnresolvedPut::kMaxGroupSize> entries(
+      unresolved_action.entries);
+  EXPECT_TRUE(unresolved_action.HasEntryFromPeer(peer_id));
+  EXPECT_FALSE(unresolved_action.WasSeen(peer_id));
+  EXPECT_EQ(allocation_count, g_allocation_count.load());
+  EXPECT_TRUE(entries[1] == unresolved_action.first_peer_entry());
+  EXPECT_FALSE(empty_entries[1] == unresolved_action.first_peer_entry());
+
+  // A received copy's seen list is parsed into its slots intact
+  UnresolvedPut received(unresolved_action.Serialise(), node_ids[0], node_ids[1]);
+  for (const auto& node_id : node_ids)
+    EXPECT_TRUE(received.WasSeen(detail::InlineNodeId(node_id)));
+}
+
 }  // namespace test
 
 }  // namespace vault
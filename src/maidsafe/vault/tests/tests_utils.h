@@ -166,8 +166,10 @@ void AddLocalActionAndSendGroupActions(
   for (uint32_t index(0); index < unresolved_actions.size(); ++index) {
     auto proto_sync(CreateProtoSync(UnresolvedActionType::ActionType::kActionId,
                                     unresolved_actions[index].Serialise()));
+    protobuf::SyncBatch proto_sync_batch;
+    proto_sync_batch.add_serialised_syncs(proto_sync.SerializeAsString());
     auto sync_message(CreateMessage<PersonaSyncType>(
-                          nfs_vault::Content(proto_sync.SerializeAsString())));
+                          nfs_vault::Content(proto_sync_batch.SerializeAsString())));
     service->HandleMessage(sync_message, group_source[index], group_source[index].group_id);
   }
 }
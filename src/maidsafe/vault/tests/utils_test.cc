@@ -54,6 +54,16 @@ testing::AssertionResult CheckToAndFromFixedWidthString() {
       if (input != recovered)
         return testing::AssertionFailure() << "Recovered value (" << recovered
                                            << ") != initial value (" << input << ")";
+      if (detail::ToFixedWidthString(input, width) != fixed_width_string)
+        return testing::AssertionFailure() << "Runtime width output differs for " << input;
+      if (detail::FromFixedWidthString(fixed_width_string, width) != input)
+        return testing::AssertionFailure() << "Runtime width recovery differs for " << input;
+      detail::FixedWidthKey fixed_width_key;
+      fixed_width_key.AppendNumber(input, width);
+      if (fixed_width_key.string() != fixed_width_string)
+        return testing::AssertionFailure() << "Fixed-width key output differs for " << input;
+      if (detail::ReadFixedWidth(fixed_width_key.data(), width) != input)
+        return testing::AssertionFailure() << "Fixed-width key recovery differs for " << input;
     }
   }
   return testing::AssertionSuccess();
@@ -67,6 +77,27 @@ TEST(UtilsTest, BEH_FixedWidthStringSize3) { CheckToAndFromFixedWidthString<3>()
 
 TEST(UtilsTest, BEH_FixedWidthStringSize4) { CheckToAndFromFixedWidthString<4>(); }
 
+TEST(UtilsTest, BEH_FixedWidthKey) {
+  const std::string kName(RandomString(NodeId::kSize));
+  const uint32_t kGroupId(RandomUint32() % 65536);
+  detail::FixedWidthKey fixed_width_key, other_key;
+  EXPECT_EQ(0U, fixed_width_key.size());
+  fixed_width_key.AppendNumber(kGroupId, 2);
+  fixed_width_key.Append(kName.data(), kName.size());
+  fixed_width_key.AppendNumber(7, detail::PaddedWidth::value);
+  ASSERT_EQ(2U + NodeId::kSize + detail::PaddedWidth::value, fixed_width_key.size());
+  EXPECT_EQ(detail::ToFixedWidthString(kGroupId, 2) + kName +
+                detail::ToFixedWidthString<detail::PaddedWidth::value>(7),
+            fixed_width_key.string());
+  EXPECT_EQ(fixed_width_key.string(), fixed_width_key.slice().ToString());
+  EXPECT_EQ(kGroupId, detail::ReadFixedWidth(fixed_width_key.data(), 2));
+
+  EXPECT_NE(fixed_width_key, other_key);
+  other_key.Append(fixed_width_key.data(), fixed_width_key.size());
+  EXPECT_EQ(fixed_width_key, other_key);
+  EXPECT_EQ(detail::FixedWidthKeyHash()(fixed_width_key), detail::FixedWidthKeyHash()(other_key));
+}
+
 }  // namespace test
 
 }  // namespace vault
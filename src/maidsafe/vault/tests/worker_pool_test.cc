@@ -0,0 +1,116 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/worker_pool.h"
+
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+// Occupies the pool's only thread until the returned promise is set
+std::promise<void> BlockWorker(detail::WorkerPool& pool) {
+  std::promise<void> release, started;
+  auto released(release.get_future().share());
+  pool.Submit(detail::WorkPriority::kHigh, [&started, released] {
+    started.set_value();
+    released.wait();
+  });
+  started.get_future().wait();
+  return release;
+}
+
+}  // unnamed namespace
+
+TEST(WorkerPoolTest, BEH_HigherPriorityRunsFirst) {
+  std::mutex mutex;
+  std::vector<int> order;
+  std::promise<void> done;
+  {
+    detail::WorkerPool pool(1, 10);
+    auto release(BlockWorker(pool));
+    auto record([&](int value) {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(value);
+    });
+    pool.Submit(detail::WorkPriority::kLow, [&] { record(4); });
+    pool.Submit(detail::WorkPriority::kNormal, [&] { record(3); });
+    pool.Submit(detail::WorkPriority::kHigh, [&] { record(1); });
+    pool.Submit(detail::WorkPriority::kLow, [&] {
+      record(5);
+      done.set_value();
+    });
+    pool.Submit(detail::WorkPriority::kHigh, [&] { record(2); });
+    EXPECT_EQ(5U, pool.GetStatistics().QueueDepth());
+    release.set_value();
+    done.get_future().wait();
+    auto statistics(pool.GetStatistics());
+    EXPECT_EQ(0U, statistics.QueueDepth());
+    EXPECT_EQ(1U, statistics.completed[static_cast<size_t>(detail::WorkPriority::kNormal)]);
+  }
+  EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5}), order);
+}
+
+TEST(WorkerPoolTest, BEH_ShedLowerPriorityWhenFull) {
+  int ran(0), low_shed(0), high_shed(0);
+  {
+    detail::WorkerPool pool(1, 2);
+    auto release(BlockWorker(pool));
+    pool.Submit(detail::WorkPriority::kLow, [&] { ++ran; }, [&] { ++low_shed; });
+    pool.Submit(detail::WorkPriority::kLow, [&] { ++ran; }, [&] { ++low_shed; });
+    // Displaces a queued low priority task
+    pool.Submit(detail::WorkPriority::kHigh, [&] { ++ran; }, [&] { ++high_shed; });
+    EXPECT_EQ(1, low_shed);
+    // Refused, since nothing queued has a lower priority
+    pool.Submit(detail::WorkPriority::kLow, [&] { ++ran; }, [&] { ++low_shed; });
+    EXPECT_EQ(2, low_shed);
+    pool.Submit(detail::WorkPriority::kHigh, [&] { ++ran; }, [&] { ++high_shed; });
+    pool.Submit(detail::WorkPriority::kHigh, [&] { ++ran; }, [&] { ++high_shed; });
+    EXPECT_EQ(3, low_shed);
+    EXPECT_EQ(1, high_shed);
+    auto statistics(pool.GetStatistics());
+    EXPECT_EQ(2U, statistics.queued[static_cast<size_t>(detail::WorkPriority::kHigh)]);
+    EXPECT_EQ(3U, statistics.shed[static_cast<size_t>(detail::WorkPriority::kLow)]);
+    EXPECT_EQ(1U, statistics.shed[static_cast<size_t>(detail::WorkPriority::kHigh)]);
+    std::promise<void> done;
+    release.set_value();
+    // Can't be queued until one of the two high priority tasks has been taken
+    while (pool.GetStatistics().QueueDepth() == 2)
+      std::this_thread::yield();
+    pool.Submit(detail::WorkPriority::kLow, [&] { done.set_value(); });
+    done.get_future().wait();
+  }
+  EXPECT_EQ(2, ran);
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,125 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_TRANSFER_CHUNKS_H_
+#define MAIDSAFE_VAULT_TRANSFER_CHUNKS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "leveldb/slice.h"
+
+#include "maidsafe/common/node_id.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Splits the entries being transferred to each new holder into chunks of at most
+// 'max_chunk_bytes', an entry larger than that being sent alone, so that only one partial chunk
+// per holder is held at a time.  A chunk also ends after any entry whose key hashes to a boundary,
+// on average every kBoundaryInterval entries, so that old holders streaming the same entries in
+// the same order split them identically.
+template <typename Entry>
+class TransferChunks {
+ public:
+  typedef std::function<void(const NodeId& new_holder, std::vector<Entry>&& chunk)> ChunkFunctor;
+
+  TransferChunks(size_t max_chunk_bytes, ChunkFunctor functor)
+      : kMaxChunkBytes_(max_chunk_bytes), functor_(std::move(functor)), chunks_() {}
+
+  void Add(const NodeId& new_holder, const leveldb::Slice& key, Entry&& entry,
+           size_t entry_bytes);
+  // Sends all remaining partial chunks
+  void Flush();
+  static bool IsBoundary(const leveldb::Slice& key);
+
+ private:
+  TransferChunks(const TransferChunks&);
+  TransferChunks& operator=(const TransferChunks&);
+  TransferChunks(TransferChunks&&);
+  TransferChunks& operator=(TransferChunks&&);
+
+  struct Chunk {
+    Chunk() : entries(), bytes(0) {}
+    std::vector<Entry> entries;
+    size_t bytes;
+  };
+
+  void Send(const NodeId& new_holder, Chunk& chunk);
+
+  static const uint32_t kBoundaryInterval = 256;
+  const size_t kMaxChunkBytes_;
+  ChunkFunctor functor_;
+  std::map<NodeId, Chunk> chunks_;
+};
+
+template <typename Entry>
+void TransferChunks<Entry>::Add(const NodeId& new_holder, const leveldb::Slice& key,
+                                Entry&& entry, size_t entry_bytes) {
+  Chunk& chunk(chunks_[new_holder]);
+  if (!chunk.entries.empty() && chunk.bytes + entry_bytes > kMaxChunkBytes_)
+    Send(new_holder, chunk);
+  chunk.entries.push_back(std::move(entry));
+  chunk.bytes += entry_bytes;
+  if (IsBoundary(key))
+    Send(new_holder, chunk);
+}
+
+template <typename Entry>
+void TransferChunks<Entry>::Flush() {
+  for (auto& chunk : chunks_) {
+    if (!chunk.second.entries.empty())
+      Send(chunk.first, chunk.second);
+  }
+  chunks_.clear();
+}
+
+// 32-bit FNV-1a, so that all platforms agree
+template <typename Entry>
+bool TransferChunks<Entry>::IsBoundary(const leveldb::Slice& key) {
+  uint32_t hash(2166136261U);
+  for (size_t i(0); i != key.size(); ++i) {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 16777619U;
+  }
+  return hash % kBoundaryInterval == 0;
+}
+
+template <typename Entry>
+void TransferChunks<Entry>::Send(const NodeId& new_holder, Chunk& chunk) {
+  std::vector<Entry> entries;
+  entries.swap(chunk.entries);
+  chunk.bytes = 0;
+  functor_(new_holder, std::move(entries));
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_TRANSFER_CHUNKS_H_
@@ -19,11 +19,13 @@
 #ifndef MAIDSAFE_VAULT_UNRESOLVED_ACTION_H_
 #define MAIDSAFE_VAULT_UNRESOLVED_ACTION_H_
 
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <cstdint>
 #include <string>
 #include <type_traits>
 #include <utility>
-#include <vector>
 
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/common/error.h"
@@ -35,10 +37,53 @@ namespace maidsafe {
 
 namespace vault {
 
+namespace detail {
+
+// A NodeId's bytes held inline, so that an UnresolvedAction's fixed slots can be constructed and
+// copied without allocating.
+class InlineNodeId {
+ public:
+  InlineNodeId() : bytes_() {}
+  explicit InlineNodeId(const NodeId& node_id) : bytes_() { Assign(node_id.string()); }
+  // Throws parsing_error unless 'id_string' is NodeId::kSize bytes
+  explicit InlineNodeId(const std::string& id_string) : bytes_() { Assign(id_string); }
+  NodeId ToNodeId() const { return NodeId(Identity(string())); }
+  std::string string() const { return std::string(std::begin(bytes_), std::end(bytes_)); }
+  bool operator==(const InlineNodeId& other) const { return bytes_ == other.bytes_; }
+
+ private:
+  void Assign(const std::string& id_string) {
+    if (id_string.size() != bytes_.size())
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    std::copy(std::begin(id_string), std::end(id_string), std::begin(bytes_));
+  }
+
+  std::array<char, NodeId::kSize> bytes_;
+};
+
+}  // namespace detail
+
+// The entries for an action from this node and its peers are held inline, in a fixed array of
+// slots sized for the largest close group.  Slot 0 is this node's; peers' entries fill the
+// following slots in arrival order.  'received' marks the filled slots.  Node ids are held as
+// detail::InlineNodeId, so that neither the slots nor the seen list allocate.
 template <typename Key, typename Action>
 struct UnresolvedAction {
   typedef Action ActionType;
   typedef Key KeyType;
+  struct Entry {
+    Entry() : node_id(), entry_id(0) {}
+    Entry(const NodeId& node_id_in, int32_t entry_id_in)
+        : node_id(node_id_in), entry_id(entry_id_in) {}
+    bool operator==(const Entry& other) const {
+      return entry_id == other.entry_id && node_id == other.node_id;
+    }
+    detail::InlineNodeId node_id;
+    int32_t entry_id;
+  };
+  // Must be at least routing::Parameters::group_size
+  static const size_t kMaxGroupSize = 8;
+
   UnresolvedAction(const std::string& serialised_copy, const NodeId& sender_id,
                    const NodeId& this_node_id);
   UnresolvedAction(const UnresolvedAction& other);
@@ -46,16 +91,31 @@ struct UnresolvedAction {
   UnresolvedAction(const Key& key_in, const Action& action_in, const NodeId& this_node_id);
   std::string Serialise() const;
   bool IsReadyForSync() const;
-  bool WasSeen(const NodeId& node_id) const;
+  bool WasSeen(const detail::InlineNodeId& node_id) const;
+
+  bool HasThisNodeEntry() const { return received[0]; }
+  // Only valid if HasThisNodeEntry()
+  const Entry& this_node_entry() const { return entries[0]; }
+  void SetThisNodeEntry(const Entry& entry);
+  size_t PeerCount() const { return received.count() - (received[0] ? 1U : 0U); }
+  // The entry of the first peer to have sent one, for an action received from a peer
+  const Entry& first_peer_entry() const { return entries[1]; }
+  void AddPeerEntry(const Entry& entry);
+  bool HasEntryFromPeer(const detail::InlineNodeId& peer_id) const;
+  bool HasPeerEntry(const Entry& entry) const;
+
   Key key;
   Action action;
-  std::shared_ptr<std::pair<NodeId, int32_t>> this_node_and_entry_id;
-  std::vector<std::pair<NodeId, int32_t>> peer_and_entry_ids;
+  std::array<Entry, kMaxGroupSize> entries;
+  std::bitset<kMaxGroupSize> received;
   int sync_counter;
 
  private:
   UnresolvedAction& operator=(UnresolvedAction other);
-  std::vector<NodeId> seen_list;
+  void AddToSeenList(const detail::InlineNodeId& node_id);
+  // Nodes which held an entry when the sender serialised this action
+  std::array<detail::InlineNodeId, kMaxGroupSize> seen_list;
+  size_t seen_count;
 
   // Helpers to handle Action class with/without Serialise() member function.
   template <typename T, typename Signature>
@@ -106,87 +166,128 @@ UnresolvedAction<Key, Action>::UnresolvedAction(const std::string& serialised_co
                                                 const NodeId& sender_id, const NodeId& this_node_id)
     : key(),
       action(ParseAction<Action>(serialised_copy)),
-      this_node_and_entry_id(),
-      peer_and_entry_ids(),
+      entries(),
+      received(),
       sync_counter(0),
-      seen_list() {
+      seen_list(),
+      seen_count(0) {
   protobuf::UnresolvedAction proto_unresolved_action;
   proto_unresolved_action.ParseFromString(serialised_copy);
   key = Key(proto_unresolved_action.serialised_key());
-  if (sender_id == this_node_id) {
-    this_node_and_entry_id = std::make_shared<std::pair<NodeId, int32_t>>(
-        this_node_id, proto_unresolved_action.entry_id());
-  } else {
-    peer_and_entry_ids.push_back(std::make_pair(sender_id, proto_unresolved_action.entry_id()));
-  }
+  if (sender_id == this_node_id)
+    SetThisNodeEntry(Entry(this_node_id, proto_unresolved_action.entry_id()));
+  else
+    AddPeerEntry(Entry(sender_id, proto_unresolved_action.entry_id()));
+  if (static_cast<size_t>(proto_unresolved_action.seen_list_size()) > kMaxGroupSize)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
   for (auto& i : proto_unresolved_action.seen_list())
-    seen_list.push_back(NodeId(Identity(i)));
+    AddToSeenList(detail::InlineNodeId(i));
 }
 
 template <typename Key, typename Action>
 UnresolvedAction<Key, Action>::UnresolvedAction(const UnresolvedAction& other)
     : key(other.key),
       action(other.action),
-      this_node_and_entry_id(),
-      peer_and_entry_ids(other.peer_and_entry_ids),
+      entries(other.entries),
+      received(other.received),
       sync_counter(other.sync_counter),
-      seen_list(other.seen_list) {
-  if (other.this_node_and_entry_id)
-    this_node_and_entry_id = std::make_shared<std::pair<NodeId, int32_t>>(
-                                 other.this_node_and_entry_id->first,
-                                 other.this_node_and_entry_id->second);
-}
+      seen_list(other.seen_list),
+      seen_count(other.seen_count) {}
 
 template <typename Key, typename Action>
 UnresolvedAction<Key, Action>::UnresolvedAction(UnresolvedAction&& other)
     : key(std::move(other.key)),
       action(std::move(other.action)),
-      this_node_and_entry_id(std::move(other.this_node_and_entry_id)),
-      peer_and_entry_ids(std::move(other.peer_and_entry_ids)),
+      entries(std::move(other.entries)),
+      received(std::move(other.received)),
       sync_counter(std::move(other.sync_counter)),
-      seen_list(std::move(other.seen_list)) {}
+      seen_list(std::move(other.seen_list)),
+      seen_count(std::move(other.seen_count)) {}
 
 template <typename Key, typename Action>
 UnresolvedAction<Key, Action>::UnresolvedAction(const Key& key_in, const Action& action_in,
                                                 const NodeId& this_node_id)
     : key(key_in),
       action(action_in),
-      this_node_and_entry_id(std::make_shared<std::pair<NodeId, int32_t>>(
-          [this_node_id]()->std::pair<NodeId, int32_t> {
-            static int32_t entry_id_sequence_number(RandomInt32());
-            return std::make_pair(this_node_id, ++entry_id_sequence_number);
-          }())),
-      peer_and_entry_ids(),
+      entries(),
+      received(),
       sync_counter(0),
-      seen_list() {}
+      seen_list(),
+      seen_count(0) {
+  static int32_t entry_id_sequence_number(RandomInt32());
+  SetThisNodeEntry(Entry(this_node_id, ++entry_id_sequence_number));
+}
 
 template <typename Key, typename Action>
 std::string UnresolvedAction<Key, Action>::Serialise() const {
   protobuf::UnresolvedAction proto_unresolved_action;
   proto_unresolved_action.set_serialised_key(key.Serialise());
   SerialiseAction<Action>(proto_unresolved_action);
-  proto_unresolved_action.set_entry_id(this_node_and_entry_id->second);
-  if (this_node_and_entry_id)
-    proto_unresolved_action.add_seen_list(this_node_and_entry_id->first.string());
-  for (const auto& peer : peer_and_entry_ids)
-    proto_unresolved_action.add_seen_list(peer.first.string());
+  assert(HasThisNodeEntry());
+  proto_unresolved_action.set_entry_id(this_node_entry().entry_id);
+  for (size_t i(0); i != kMaxGroupSize; ++i) {
+    if (received[i])
+      proto_unresolved_action.add_seen_list(entries[i].node_id.string());
+  }
   return proto_unresolved_action.SerializeAsString();
 }
 
 template <typename Key, typename Action>
 bool UnresolvedAction<Key, Action>::IsReadyForSync() const {
   // TODO(Fraser#5#): 2013-07-22 - Confirm sync_counter limit and remove magic number
-  return this_node_and_entry_id && sync_counter < 10;
+  return HasThisNodeEntry() && sync_counter < 10;
+}
+
+template <typename Key, typename Action>
+bool UnresolvedAction<Key, Action>::WasSeen(const detail::InlineNodeId& node_id) const {
+  if (HasThisNodeEntry() && (node_id == this_node_entry().node_id))
+    return seen_count != 1;
+  auto seen_end(std::begin(seen_list) + seen_count);
+  return std::find(std::begin(seen_list), seen_end, node_id) != seen_end;
+}
+
+template <typename Key, typename Action>
+void UnresolvedAction<Key, Action>::SetThisNodeEntry(const Entry& entry) {
+  entries[0] = entry;
+  received.set(0);
+}
+
+template <typename Key, typename Action>
+void UnresolvedAction<Key, Action>::AddPeerEntry(const Entry& entry) {
+  size_t slot(PeerCount() + 1);
+  assert(slot < kMaxGroupSize);
+  entries[slot] = entry;
+  received.set(slot);
+}
+
+template <typename Key, typename Action>
+bool UnresolvedAction<Key, Action>::HasEntryFromPeer(
+    const detail::InlineNodeId& peer_id) const {
+  for (size_t slot(1); slot != kMaxGroupSize && received[slot]; ++slot) {
+    if (entries[slot].node_id == peer_id)
+      return true;
+  }
+  return false;
 }
 
 template <typename Key, typename Action>
-bool UnresolvedAction<Key, Action>::WasSeen(const NodeId& node_id) const {
-  if (this_node_and_entry_id && (node_id == this_node_and_entry_id->first))
-    return seen_list.size() != 1;
-  auto found(std::find(seen_list.begin(), seen_list.end(), node_id));
-  return found != seen_list.end();
+bool UnresolvedAction<Key, Action>::HasPeerEntry(const Entry& entry) const {
+  for (size_t slot(1); slot != kMaxGroupSize && received[slot]; ++slot) {
+    if (entries[slot] == entry)
+      return true;
+  }
+  return false;
 }
 
+template <typename Key, typename Action>
+void UnresolvedAction<Key, Action>::AddToSeenList(const detail::InlineNodeId& node_id) {
+  assert(seen_count < kMaxGroupSize);
+  seen_list[seen_count++] = node_id;
+}
+
+template <typename Key, typename Action>
+const size_t UnresolvedAction<Key, Action>::kMaxGroupSize;
+
 }  // namespace vault
 
 }  // namespace maidsafe
@@ -23,6 +23,7 @@
 #include "boost/filesystem/operations.hpp"
 #include "leveldb/status.h"
 
+#include "maidsafe/common/log.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/nfs/types.h"
 #include "maidsafe/vault/parameters.h"
@@ -134,6 +135,15 @@ boost::filesystem::path UniqueDbPath(const boost::filesystem::path& vault_root_d
   return (db_root_path / boost::filesystem::unique_path());
 }
 
+boost::filesystem::path PersonaDbPath(const boost::filesystem::path& vault_root_dir,
+                                      const std::string& db_name) {
+  if (!detail::Parameters::durable_dbs)
+    return UniqueDbPath(vault_root_dir);
+  boost::filesystem::path db_root_path(vault_root_dir / "db");
+  detail::InitialiseDirectory(db_root_path);
+  return db_root_path / db_name;
+}
+
 std::unique_ptr<leveldb::DB> InitialiseLevelDb(const boost::filesystem::path& db_path) {
   if (boost::filesystem::exists(db_path))
     boost::filesystem::remove_all(db_path);
@@ -148,6 +158,30 @@ std::unique_ptr<leveldb::DB> InitialiseLevelDb(const boost::filesystem::path& db
   return std::move(std::unique_ptr<leveldb::DB>(db));
 }
 
+std::unique_ptr<leveldb::DB> OpenLevelDb(const boost::filesystem::path& db_path,
+                                         bool* repaired) {
+  if (repaired)
+    *repaired = false;
+  leveldb::DB* db(nullptr);
+  leveldb::Options options;
+  options.create_if_missing = true;
+  leveldb::Status status(leveldb::DB::Open(options, db_path.string(), &db));
+  if (status.IsCorruption()) {
+    LOG(kWarning) << "Repairing corrupt db at " << db_path << " : " << status.ToString();
+    status = leveldb::RepairDB(db_path.string(), options);
+    if (status.ok())
+      status = leveldb::DB::Open(options, db_path.string(), &db);
+    if (status.ok() && repaired)
+      *repaired = true;
+  }
+  if (!status.ok()) {
+    LOG(kError) << "Failed to open db at " << db_path << " : " << status.ToString();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  assert(db);
+  return std::unique_ptr<leveldb::DB>(db);
+}
+
 nfs::MessageId HashStringToMessageId(const std::string& input) {
   std::hash<std::string> hash_fn;
   return nfs::MessageId(static_cast<nfs::MessageId::value_type>(hash_fn(input)));
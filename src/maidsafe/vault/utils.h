@@ -19,6 +19,8 @@
 #ifndef MAIDSAFE_VAULT_UTILS_H_
 #define MAIDSAFE_VAULT_UTILS_H_
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -190,8 +192,18 @@ struct GroupOrKeyType<PersonaType, typename ToVoid<typename PersonaType::GroupNa
 // Returns a unique path in vault_root_dir / "db" dir
 boost::filesystem::path UniqueDbPath(const boost::filesystem::path& vault_root_dir);
 
+// Path of the db named 'db_name' under 'vault_root_dir' if Parameters::durable_dbs, else a new
+// UniqueDbPath
+boost::filesystem::path PersonaDbPath(const boost::filesystem::path& vault_root_dir,
+                                      const std::string& db_name);
+
 std::unique_ptr<leveldb::DB> InitialiseLevelDb(const boost::filesystem::path& db_path);
 
+// Opens the db at 'db_path' keeping any existing contents, or creates it if missing.  A corrupt db
+// is repaired with leveldb::RepairDB before being opened, in which case 'repaired' is set if given.
+std::unique_ptr<leveldb::DB> OpenLevelDb(const boost::filesystem::path& db_path,
+                                         bool* repaired = nullptr);
+
 
 
 // ============================ sync utils =========================================================
@@ -209,33 +221,20 @@ void SendSync(Dispatcher& dispatcher,
   }
 }
 
-template <typename Dispatcher, typename UnresolvedAction, typename NewUnresolvedAction>
-void IncrementAttemptsAndSendSync(Dispatcher& dispatcher,
-                                  Sync<UnresolvedAction>& sync_type,
-                                  const NewUnresolvedAction& unresolved_action,
-                                  typename std::enable_if<std::is_same<UnresolvedAction,
-                                  NewUnresolvedAction>::value >::type* = 0) {
-  sync_type.IncrementSyncAttempts();
-  auto unresolved_actions(sync_type.GetUnresolvedActions());
-  std::unique_ptr<UnresolvedAction> unresolved_action_ptr(new UnresolvedAction(unresolved_action));
-  unresolved_actions.push_back(std::move(unresolved_action_ptr));
-//  LOG(kVerbose) << "IncrementAttemptsAndSendSync, for MaidManagerSerive, has "
-//                << unresolved_actions.size() << " unresolved_actions";
+// Sends a newly created action.  When 'dispatcher' is a service's SyncBatcher, the action goes out
+// with the rest of its group's batch on the next SyncRetryTimer tick.  Its Sync holds it once it's
+// received back from the group, and from then on it's resent by ResendDueSyncs until resolved.
+template <typename Dispatcher, typename UnresolvedAction>
+void SendSyncAction(Dispatcher& dispatcher, const UnresolvedAction& unresolved_action) {
+  std::vector<std::unique_ptr<UnresolvedAction>> unresolved_actions;
+  unresolved_actions.emplace_back(new UnresolvedAction(unresolved_action));
   SendSync(dispatcher, unresolved_actions);
 }
 
-
-template <typename Dispatcher, typename UnresolvedAction, typename NewUnresolvedAction>
-void IncrementAttemptsAndSendSync(Dispatcher& dispatcher,
-                                  Sync<UnresolvedAction>& sync_type,
-                                  const NewUnresolvedAction& /*unresolved_action*/,
-                                  typename std::enable_if<!std::is_same<UnresolvedAction,
-                                  NewUnresolvedAction>::value >::type* = 0) {
-  sync_type.IncrementSyncAttempts();
-  auto unresolved_actions(sync_type.GetUnresolvedActions());
-//  LOG(kVerbose) << "IncrementAttemptsAndSendSync, for MaidManagerSerive, has "
-//                << unresolved_actions.size() << " unresolved_actions";
-  SendSync(dispatcher, unresolved_actions);
+template <typename Dispatcher, typename UnresolvedAction>
+void ResendDueSyncs(Dispatcher& dispatcher, Sync<UnresolvedAction>& sync_type,
+                    std::chrono::steady_clock::time_point now) {
+  SendSync(dispatcher, sync_type.GetActionsDueForResend(now));
 }
 
 }  // namespace detail
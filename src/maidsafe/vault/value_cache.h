@@ -0,0 +1,142 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_VALUE_CACHE_H_
+#define MAIDSAFE_VAULT_VALUE_CACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Bounded, thread-safe LRU cache of deserialised db values keyed by their db key.  A capacity of 0
+// disables the cache.  Values are move-only, so Get hands out a copy made by reparsing the cached
+// value, while Take removes the cached value itself for the caller to modify and re-Insert.
+template <typename Value, typename DbKey = std::string, typename Hash = std::hash<DbKey>>
+class ValueCache {
+ public:
+  explicit ValueCache(size_t capacity)
+      : kCapacity_(capacity), mutex_(), entries_(), index_(), hits_(0), misses_(0) {}
+
+  std::unique_ptr<Value> Get(const DbKey& db_key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(Find(db_key));
+    if (itr == std::end(index_))
+      return nullptr;
+    entries_.splice(std::begin(entries_), entries_, itr->second);
+    return std::unique_ptr<Value>(new Value(itr->second->second->Serialise()));
+  }
+
+  std::unique_ptr<Value> Take(const DbKey& db_key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(Find(db_key));
+    if (itr == std::end(index_))
+      return nullptr;
+    std::unique_ptr<Value> value(std::move(itr->second->second));
+    entries_.erase(itr->second);
+    index_.erase(itr);
+    return value;
+  }
+
+  void Insert(const DbKey& db_key, std::unique_ptr<Value> value) {
+    if (kCapacity_ == 0 || !value)
+      return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(index_.find(db_key));
+    if (itr != std::end(index_)) {
+      itr->second->second = std::move(value);
+      entries_.splice(std::begin(entries_), entries_, itr->second);
+      return;
+    }
+    entries_.emplace_front(db_key, std::move(value));
+    index_.insert(std::make_pair(db_key, std::begin(entries_)));
+    if (entries_.size() > kCapacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+  void Erase(const DbKey& db_key) {
+    if (kCapacity_ == 0)
+      return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(index_.find(db_key));
+    if (itr == std::end(index_))
+      return;
+    entries_.erase(itr->second);
+    index_.erase(itr);
+  }
+
+  bool enabled() const { return kCapacity_ != 0; }
+
+  uint64_t hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+  }
+
+  uint64_t misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+  }
+
+ private:
+  typedef std::list<std::pair<DbKey, std::unique_ptr<Value>>> Entries;
+  typedef std::unordered_map<DbKey, typename Entries::iterator, Hash> Index;
+
+  ValueCache(const ValueCache&);
+  ValueCache& operator=(const ValueCache&);
+  ValueCache(ValueCache&&);
+  ValueCache& operator=(ValueCache&&);
+
+  // Must be called with mutex_ held.  Doesn't count lookups while the cache is disabled.
+  typename Index::iterator Find(const DbKey& db_key) {
+    if (kCapacity_ == 0)
+      return std::end(index_);
+    auto itr(index_.find(db_key));
+    if (itr == std::end(index_))
+      ++misses_;
+    else
+      ++hits_;
+    return itr;
+  }
+
+  const size_t kCapacity_;
+  mutable std::mutex mutex_;
+  Entries entries_;
+  Index index_;
+  uint64_t hits_, misses_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_VALUE_CACHE_H_
@@ -33,6 +33,7 @@
 #include "maidsafe/vault/db.h"
 #include "maidsafe/vault/key.h"
 #include "maidsafe/vault/operation_handlers.h"
+#include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/sync.h"
 #include "maidsafe/vault/unresolved_action.pb.h"
 #include "maidsafe/vault/utils.h"
@@ -63,17 +64,30 @@ VersionHandlerService::VersionHandlerService(const passport::Pmid& pmid,
                                              const boost::filesystem::path& vault_root_dir)
     : routing_(routing),
       dispatcher_(routing),
-      accumulator_mutex_(),
+      sync_batcher_(dispatcher_, detail::Parameters::max_sync_batch_bytes),
+      accumulator_ingestion_(),
       matrix_change_mutex_(),
       stopped_(false),
       accumulator_(),
       matrix_change_(),
-      db_(UniqueDbPath(vault_root_dir)),
+      db_(PersonaDbPath(vault_root_dir, "version_handler")),
       kThisNodeId_(routing_.kNodeId()),
       sync_create_version_tree_(NodeId(pmid.name()->string())),
       sync_put_versions_(NodeId(pmid.name()->string())),
       sync_delete_branch_until_fork_(NodeId(pmid.name()->string())),
-      account_transfer_() {}
+      account_transfer_(),
+      asio_service_(1),
+      sync_retry_timer_(asio_service_, detail::Parameters::sync_retry_check_interval,
+                        [this](std::chrono::steady_clock::time_point now) {
+                          ResendDueSyncs(now);
+                        }) {}
+
+void VersionHandlerService::ResendDueSyncs(std::chrono::steady_clock::time_point now) {
+  detail::ResendDueSyncs(sync_batcher_, sync_create_version_tree_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_put_versions_, now);
+  detail::ResendDueSyncs(sync_batcher_, sync_delete_branch_until_fork_, now);
+  sync_batcher_.Flush();
+}
 
 template<>
 void VersionHandlerService::HandleMessage(
@@ -87,7 +101,7 @@ void VersionHandlerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template<>
@@ -101,7 +115,7 @@ void VersionHandlerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template<>
@@ -116,7 +130,7 @@ void VersionHandlerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template<>
@@ -130,7 +144,7 @@ void VersionHandlerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template<>
@@ -145,7 +159,7 @@ void VersionHandlerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template<>
@@ -161,7 +175,7 @@ void VersionHandlerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template<>
@@ -176,7 +190,7 @@ void VersionHandlerService::HandleMessage(
                       return this->ValidateSender(message, sender);
                     },
       Accumulator<Messages>::AddRequestChecker(RequiredRequests(message)), this,
-      accumulator_mutex_)(message, sender, receiver);
+      accumulator_ingestion_)(message, sender, receiver);
 }
 
 template<>
@@ -185,27 +199,37 @@ void VersionHandlerService::HandleMessage(
     const typename SynchroniseFromVersionHandlerToVersionHandler::Sender& sender,
     const typename SynchroniseFromVersionHandlerToVersionHandler::Receiver& /*receiver*/) {
   LOG(kVerbose) << "VersionHandler::HandleMessage SynchroniseFromVersionHandlerToVersionHandler";
-  protobuf::Sync proto_sync;
-  if (!proto_sync.ParseFromString(message.contents->data))
+  protobuf::SyncBatch proto_sync_batch;
+  if (!proto_sync_batch.ParseFromString(message.contents->data)) {
+    LOG(kError) << "SynchroniseFromVersionHandlerToVersionHandler can't parse content";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  detail::ApplySyncBatch(proto_sync_batch, "SynchroniseFromVersionHandlerToVersionHandler",
+                         [&](const protobuf::Sync& proto_sync) {
+                           HandleSync(proto_sync, sender, message.id);
+                         });
+}
 
+void VersionHandlerService::HandleSync(const protobuf::Sync& proto_sync,
+                                       const routing::GroupSource& sender,
+                                       nfs::MessageId message_id) {
   switch (static_cast<nfs::MessageAction>(proto_sync.action_type())) {
     case ActionVersionHandlerCreateVersionTree::kActionId: {
       VersionHandler::UnresolvedCreateVersionTree unresolved_action(
                                                       proto_sync.serialised_unresolved_action(),
                                                       sender.sender_id, routing_.kNodeId());
-      LOG(kVerbose) << "VersionHandlerSync -- CreateVersionTree: " << message.id;
+      LOG(kVerbose) << "VersionHandlerSync -- CreateVersionTree: " << message_id;
       auto resolved_action(sync_create_version_tree_.AddUnresolvedAction(unresolved_action));
       if (resolved_action) {
         try {
-          LOG(kInfo) << "VersionHandlerSync -- CreateVersionTree -Commit: " << message.id;
+          LOG(kInfo) << "VersionHandlerSync -- CreateVersionTree -Commit: " << message_id;
           db_.Commit(resolved_action->key, resolved_action->action);
           dispatcher_.SendCreateVersionTreeResponse(
               resolved_action->action.originator, resolved_action->key,
               maidsafe_error(CommonErrors::success), resolved_action->action.message_id);
         }
         catch (const maidsafe_error& error) {
-          LOG(kError) << message.id << " Failed to create version: "
+          LOG(kError) << message_id << " Failed to create version: "
                       << boost::diagnostic_information(error);
           dispatcher_.SendCreateVersionTreeResponse(
               resolved_action->action.originator, resolved_action->key, error,
@@ -218,11 +242,11 @@ void VersionHandlerService::HandleMessage(
       VersionHandler::UnresolvedPutVersion unresolved_action(
                                                proto_sync.serialised_unresolved_action(),
                                                sender.sender_id, routing_.kNodeId());
-      LOG(kVerbose) << "VersionHandlerSync: " << message.id;
+      LOG(kVerbose) << "VersionHandlerSync: " << message_id;
       auto resolved_action(sync_put_versions_.AddUnresolvedAction(unresolved_action));
       if (resolved_action) {
         try {
-          LOG(kInfo) << "VersionHandlerSync-Commit: " << message.id;
+          LOG(kInfo) << "VersionHandlerSync-Commit: " << message_id;
           db_.Commit(resolved_action->key, resolved_action->action);
           StructuredDataVersions::VersionName tip_of_tree;
           if (resolved_action->action.tip_of_tree) {
@@ -233,7 +257,7 @@ void VersionHandlerService::HandleMessage(
           }
         }
         catch (const maidsafe_error& error) {
-          LOG(kError) << message.id << " Failed to put version: "
+          LOG(kError) << message_id << " Failed to put version: "
                       << boost::diagnostic_information(error);
           dispatcher_.SendPutVersionResponse(
               resolved_action->action.originator, resolved_action->key,
@@ -317,10 +341,7 @@ void VersionHandlerService::HandleCreateVersionTree(const VersionHandler::Key& k
 
 template <typename UnresolvedAction>
 void VersionHandlerService::DoSync(const UnresolvedAction& unresolved_action) {
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_create_version_tree_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_put_versions_, unresolved_action);
-  detail::IncrementAttemptsAndSendSync(dispatcher_, sync_delete_branch_until_fork_,
-                                       unresolved_action);
+  detail::SendSyncAction(sync_batcher_, unresolved_action);
 }
 
 // void VersionHandlerService::ValidateClientSender(const nfs::Message& message) const {
@@ -412,10 +433,14 @@ void VersionHandlerService::HandleChurnEvent(
 //   matrix_change->Print();
   matrix_change_ = *matrix_change;
 
-  Db<VersionHandler::Key, VersionHandler::Value>::TransferInfo transfer_info(
-      db_.GetTransferInfo(matrix_change));
-  for (auto& transfer : transfer_info)
-    TransferAccount(transfer.first, transfer.second);
+  // Entries recovered from a previous run are kept unless out of range for this node
+  if (db_.Recovered())
+    LOG(kInfo) << "VersionHandlerService checking recovered entries against close group";
+  db_.GetTransferInfo(matrix_change,
+      [this](const NodeId& new_holder,
+             std::vector<Db<VersionHandler::Key, VersionHandler::Value>::KvPair>&& chunk) {
+        TransferAccount(new_holder, chunk);
+      });
 //   LOG(kVerbose) << "HandleChurnEvent matrix_change_ containing following info after : ";
 //   matrix_change_.Print();
 
@@ -456,6 +481,7 @@ void VersionHandlerService::TransferAccount(const NodeId& dest,
     LOG(kWarning) << "VersionHandler account just received";
     return;
   }
+  assert(!accounts.empty());
   std::vector<std::string> actions;
   for (auto& account : accounts) {
     VLOG(nfs::Persona::kVersionHandler, VisualiserAction::kAccountTransfer, account.first.name,
@@ -465,7 +491,9 @@ void VersionHandlerService::TransferAccount(const NodeId& dest,
     kv_msg.set_value(account.second.Serialise());
     actions.push_back(kv_msg.SerializeAsString());
   }
-  nfs::MessageId message_id(HashStringToMessageId(dest.string()));
+  // Holders send the same chunks, so a chunk's first key identifies it
+  nfs::MessageId message_id(HashStringToMessageId(
+      dest.string() + accounts.front().first.Serialise()));
   VersionHandler::UnresolvedAccountTransfer account_transfer(
       passport::PublicPmid::Name(Identity(dest.string())), message_id, actions);
   LOG(kVerbose) << "VersionHandlerService::TransferAccount send account_transfer";
@@ -492,6 +520,15 @@ void VersionHandlerService::TransferAccount(const NodeId& dest,
 //    //}
 // }
 
+detail::ServiceStatistics VersionHandlerService::GetStatistics() const {
+  detail::ServiceStatistics statistics;
+  statistics.accumulators["accumulator"] = accumulator_.GetStatistics();
+  statistics.syncs["create_version_tree"] = sync_create_version_tree_.GetStatistics();
+  statistics.syncs["put_versions"] = sync_put_versions_.GetStatistics();
+  statistics.syncs["delete_branch_until_fork"] = sync_delete_branch_until_fork_.GetStatistics();
+  return statistics;
+}
+
 }  // namespace vault
 
 }  // namespace maidsafe
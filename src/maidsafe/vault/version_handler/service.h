@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_VAULT_VERSION_HANDLER_SERVICE_H_
 #define MAIDSAFE_VAULT_VERSION_HANDLER_SERVICE_H_
 
+#include <chrono>
 #include <mutex>
 #include <string>
 #include <type_traits>
@@ -38,7 +39,11 @@
 #include "maidsafe/vault/account_transfer.h"
 #include "maidsafe/vault/accumulator.h"
 #include "maidsafe/vault/db.h"
+#include "maidsafe/vault/ingestion_queue.h"
 #include "maidsafe/vault/sync.h"
+#include "maidsafe/vault/sync_batcher.h"
+#include "maidsafe/vault/sync_retry_timer.h"
+#include "maidsafe/vault/statistics.h"
 #include "maidsafe/vault/sync.pb.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/message_types.h"
@@ -80,6 +85,9 @@ class VersionHandlerService {
 
   void HandleChurnEvent(std::shared_ptr<routing::MatrixChange> matrix_change);
 
+  // Snapshot of the Accumulator and Sync statistics, safe to call from any thread
+  detail::ServiceStatistics GetStatistics() const;
+
   void Stop() {
     std::lock_guard<std::mutex> lock(matrix_change_mutex_);
     stopped_ = true;
@@ -100,6 +108,10 @@ class VersionHandlerService {
 
   template <typename UnresolvedAction>
   void DoSync(const UnresolvedAction& unresolved_action);
+  // Applies one sync from a received batch
+  void HandleSync(const protobuf::Sync& proto_sync, const routing::GroupSource& sender,
+                  nfs::MessageId message_id);
+  void ResendDueSyncs(std::chrono::steady_clock::time_point now);
 
   template <typename MessageType>
   bool ValidateSender(const MessageType& message, const typename MessageType::Sender& sender) const;
@@ -152,7 +164,9 @@ class VersionHandlerService {
  private:
   routing::Routing& routing_;
   VersionHandlerDispatcher dispatcher_;
-  std::mutex accumulator_mutex_, matrix_change_mutex_;
+  detail::SyncBatcher<VersionHandlerDispatcher> sync_batcher_;
+  detail::IngestionQueue accumulator_ingestion_;
+  std::mutex matrix_change_mutex_;
   bool stopped_;
   Accumulator<Messages> accumulator_;
   routing::MatrixChange matrix_change_;
@@ -162,6 +176,8 @@ class VersionHandlerService {
   Sync<VersionHandler::UnresolvedPutVersion> sync_put_versions_;
   Sync<VersionHandler::UnresolvedDeleteBranchUntilFork> sync_delete_branch_until_fork_;
   AccountTransfer<VersionHandler::UnresolvedAccountTransfer> account_transfer_;
+  AsioService asio_service_;
+  detail::SyncRetryTimer sync_retry_timer_;
 };
 
 template <typename MessageType>
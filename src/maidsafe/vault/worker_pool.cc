@@ -0,0 +1,147 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault/worker_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <numeric>
+#include <utility>
+
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/vault/parameters.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+size_t WorkerPoolStatistics::QueueDepth() const {
+  return std::accumulate(std::begin(queued), std::end(queued), size_t(0));
+}
+
+WorkerPool::WorkerPool()
+    : WorkerPool(Parameters::pmid_node_worker_count, Parameters::pmid_node_worker_queue_size) {}
+
+WorkerPool::WorkerPool(size_t thread_count, size_t max_queue_size)
+    : kMaxQueueSize_(std::max(max_queue_size, size_t(1))),
+      mutex_(),
+      condition_(),
+      queues_(),
+      statistics_(),
+      stopped_(false),
+      threads_() {
+  for (size_t i(0); i != std::max(thread_count, size_t(1)); ++i)
+    threads_.emplace_back([this] { Run(); });
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  condition_.notify_all();
+  for (auto& thread : threads_)
+    thread.join();
+  if (QueuedCount() != 0)
+    LOG(kInfo) << "WorkerPool discarding " << QueuedCount() << " queued tasks";
+}
+
+void WorkerPool::Submit(WorkPriority priority, Task task, Task on_shed) {
+  const size_t index(static_cast<size_t>(priority));
+  Work work = {std::move(task), std::move(on_shed)}, shed_work;
+  bool shedding(false);
+  size_t shed_index(index);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+      shedding = true;
+    } else if (QueuedCount() >= kMaxQueueSize_) {
+      shedding = true;
+      for (shed_index = queues_.size() - 1; shed_index > index; --shed_index) {
+        if (!queues_[shed_index].empty())
+          break;
+      }
+      ++statistics_.shed[shed_index];
+    }
+    if (shedding && shed_index != index) {
+      shed_work = std::move(queues_[shed_index].back());
+      queues_[shed_index].pop_back();
+    }
+    if (!shedding || shed_index != index)
+      queues_[index].push_back(std::move(work));
+    else
+      shed_work = std::move(work);
+  }
+  if (!shedding || shed_index != index)
+    condition_.notify_one();
+  if (shedding) {
+    LOG(kWarning) << "WorkerPool shedding a task of priority " << shed_index;
+    if (shed_work.on_shed)
+      shed_work.on_shed();
+  }
+}
+
+WorkerPoolStatistics WorkerPool::GetStatistics() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  WorkerPoolStatistics statistics(statistics_);
+  for (size_t i(0); i != queues_.size(); ++i)
+    statistics.queued[i] = queues_[i].size();
+  return statistics;
+}
+
+void WorkerPool::Run() {
+  for (;;) {
+    Work work;
+    size_t index(0);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this] { return stopped_ || QueuedCount() != 0; });
+      if (stopped_)
+        return;
+      while (queues_[index].empty())
+        ++index;
+      work = std::move(queues_[index].front());
+      queues_[index].pop_front();
+    }
+    try {
+      work.task();
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "WorkerPool task failed: " << e.what();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++statistics_.completed[index];
+  }
+}
+
+size_t WorkerPool::QueuedCount() const {
+  size_t count(0);
+  for (const auto& queue : queues_)
+    count += queue.size();
+  return count;
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,97 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_WORKER_POOL_H_
+#define MAIDSAFE_VAULT_WORKER_POOL_H_
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+enum class WorkPriority : int { kHigh = 0, kNormal = 1, kLow = 2 };
+
+// 'queued' is as at the time of the snapshot.  All are indexed by WorkPriority.
+struct WorkerPoolStatistics {
+  static const size_t kPriorityCount = 3;
+  WorkerPoolStatistics() : queued(), completed(), shed() {}
+  size_t QueueDepth() const;
+  std::array<size_t, kPriorityCount> queued;
+  std::array<uint64_t, kPriorityCount> completed;
+  std::array<uint64_t, kPriorityCount> shed;
+};
+
+// Runs tasks on a fixed number of threads, always taking the oldest task of the highest priority
+// queued.  The queue holds at most 'max_queue_size' tasks.  Once it's full, a new task displaces
+// the newest task of the lowest priority queued if that is lower than its own, otherwise it is
+// itself refused.  Either way, the task which loses out is shed: its 'on_shed' functor is run on
+// the submitting thread in place of the task.  Tasks still queued on destruction are discarded.
+class WorkerPool {
+ public:
+  typedef std::function<void()> Task;
+
+  // Thread count and queue size are taken from Parameters::pmid_node_worker_count and
+  // Parameters::pmid_node_worker_queue_size.
+  WorkerPool();
+  WorkerPool(size_t thread_count, size_t max_queue_size);
+  ~WorkerPool();
+
+  void Submit(WorkPriority priority, Task task, Task on_shed = Task());
+  WorkerPoolStatistics GetStatistics() const;
+
+ private:
+  WorkerPool(const WorkerPool&);
+  WorkerPool& operator=(const WorkerPool&);
+  WorkerPool(WorkerPool&&);
+  WorkerPool& operator=(WorkerPool&&);
+
+  struct Work {
+    Task task, on_shed;
+  };
+
+  void Run();
+  size_t QueuedCount() const;
+
+  const size_t kMaxQueueSize_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::array<std::deque<Work>, WorkerPoolStatistics::kPriorityCount> queues_;
+  WorkerPoolStatistics statistics_;
+  bool stopped_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_WORKER_POOL_H_